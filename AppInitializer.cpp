@@ -4,14 +4,31 @@
 #include <windows.h>
 #include "AppInitializer.h"
 #include "ConfigLoader.h"
-#include <thread>
 #include <shellapi.h>
 #include "CallbackServer.h"
+#include "Executor.h"
+#include "ConfigWatcher.h"
+#include "SetlistCache.h"
+#include "CacheWarmer.h"
+#include "CacheBundle.h"
+#include <thread>
+
+namespace {
+    const std::string kConfigFile = "accessData.json";
+
+    // Ein OAuth-Callback-Server fr alle Anmeldungen; luft bis Shutdown() in einem eigenen Thread
+    std::shared_ptr<net::io_context> callbackIoc;
+    std::unique_ptr<CallbackServer> callbackServer;
+    std::thread callbackThread;
+    std::unique_ptr<ConfigWatcher> configWatcher;
+    std::unique_ptr<CacheWarmer> cacheWarmer;
+}
 
 bool AppInitializer::InitializeServices(AppState& state) {
     try {
         // Konfiguration laden
-        auto config = ConfigLoader::loadConfig("accessData.json");
+        auto config = ConfigLoader::loadConfig(kConfigFile);
+        Executor::configure(config.performance.workers.executorThreads);
 
         // SpotifyService initialisieren
         SpotifyService::AuthConfig spotifyConfig{
@@ -20,46 +37,74 @@ bool AppInitializer::InitializeServices(AppState& state) {
             config.spotify.redirect_uri
         };
 
-        state.spotifyService = std::make_unique<SpotifyService>(spotifyConfig);
+        state.spotifyService = std::make_unique<SpotifyService>(spotifyConfig, config.performance.http);
 
         // SetlistFmService initialisieren
         SetlistFmService::Config setlistConfig{
             config.setlistfm.api_key
         };
 
-        state.setlistService = std::make_unique<SetlistFmService>(setlistConfig);
+        state.setlistService = std::make_unique<SetlistFmService>(setlistConfig, config.performance.http);
+        state.spotifyService->applyPerformance(config.performance);
+        state.setlistService->applyPerformance(config.performance);
+
+        // Nutzt ruhige Phasen, um die Caches fr die beobachteten Knstler vorzuwrmen
+        cacheWarmer = std::make_unique<CacheWarmer>(*state.setlistService, *state.spotifyService,
+            config.performance.warming);
+
+        // Genderte Performance-Einstellungen ohne Neustart bernehmen
+        if (config.performance.hotReload) {
+            configWatcher = std::make_unique<ConfigWatcher>(kConfigFile, config.performance,
+                [&state](const ConfigLoader::PerformanceConfig& performance) {
+                    state.spotifyService->applyPerformance(performance);
+                    state.setlistService->applyPerformance(performance);
+                    cacheWarmer->apply(performance.warming);
+                    state.uiEvents.push({ UiEvent::StatusChanged{ "Performance-Einstellungen neu geladen" } });
+                });
+        }
+
+        // Start parallelisieren: Token laden, beide API-Hosts vorwrmen (DNS, TCP, TLS) und die
+        // Caches laden. Gewartet wird nur auf den Token, weil davon der Auth-Flow abhngt;
+        // ein abgelaufener Token wird vom TokenStore direkt im Hintergrund erneuert.
+        auto& executor = Executor::instance();
+        auto tokenLoaded = executor.submit([&state]() { return state.spotifyService->loadTokenFromFile(); });
+        executor.post([&state]() { state.spotifyService->prewarm(); });
+        executor.post([&state]() { state.setlistService->prewarm(); });
+        executor.post([&state]() { state.spotifyService->trackCache()->load(); });
+        executor.post([&state]() { state.setlistService->setlistCache()->load(); });
+        executor.post([&state, bundle = config.performance.cache.warmStartBundle]() {
+            CacheBundle::warmStart(bundle, *state.spotifyService->trackCache(), *state.setlistService->setlistCache());
+            });
 
         // Token laden oder Auth-Flow starten
-        if (!state.spotifyService->loadTokenFromFile()) {
+        if (!tokenLoaded.get()) {
             state.statusMessage = "Bitte authentifiziere dich bei Spotify im Browser";
 
-            // Browser ffnen
-            std::string authUrl =
-                "https://accounts.spotify.com/authorize?"
-                "client_id=" + config.spotify.client_id +
-                "&response_type=code"
-                "&redirect_uri=" + config.spotify.redirect_uri +
-                "&scope=user-read-private%20playlist-modify-public";
+            // Callback-Server zuerst starten, damit der Redirect nicht ins Leere geht
+            callbackIoc = std::make_shared<net::io_context>();
+            callbackServer = std::make_unique<CallbackServer>(*callbackIoc,
+                ConfigLoader::callbackPort(config.spotify.redirect_uri));
+            callbackServer->start();
+            callbackThread = std::thread([ioc = callbackIoc]() { ioc->run(); });
 
-            ShellExecuteA(NULL, "open", authUrl.c_str(), NULL, NULL, SW_SHOWNORMAL);
+            // Der Handler luft auf dem Executor, der Token-Austausch blockiert also keinen I/O-Thread
+            std::string authState = callbackServer->beginAuthorization([&state](std::optional<std::string> code) {
+                if (!code) {
+                    state.uiEvents.push({ UiEvent::StatusChanged{ "Authentifizierung abgebrochen oder abgelaufen" } });
+                    return;
+                }
+                state.uiEvents.push({ UiEvent::StatusChanged{ "Auth-Code erhalten. Fordere Access-Token an..." } });
+                if (state.spotifyService->requestAccessToken(*code)) {
+                    state.uiEvents.push({ UiEvent::StatusChanged{ "Authentifizierung erfolgreich!" } });
+                }
+                else {
+                    state.uiEvents.push({ UiEvent::StatusChanged{ "Fehler bei der Authentifizierung" } });
+                }
+                });
 
-            // Callback-Server in separatem Thread starten
-            std::thread([&state]() {
-                net::io_context ioc;
-                CallbackServer server(ioc, 8080);
-
-                server.start([&state](const std::string& code) {
-                    state.statusMessage = "Auth-Code erhalten. Fordere Access-Token an...";
-                    if (state.spotifyService->requestAccessToken(code)) {
-                        state.statusMessage = "Authentifizierung erfolgreich!";
-                    }
-                    else {
-                        state.statusMessage = "Fehler bei der Authentifizierung";
-                    }
-                    });
-
-                ioc.run();
-                }).detach();
+            // Browser ffnen
+            std::string authUrl = state.spotifyService->authorizationUrl(authState);
+            ShellExecuteA(NULL, "open", authUrl.c_str(), NULL, NULL, SW_SHOWNORMAL);
         }
         else {
             state.statusMessage = "Bereit";
@@ -71,4 +116,24 @@ bool AppInitializer::InitializeServices(AppState& state) {
         state.statusMessage = std::string("Fehler: ") + e.what();
         return false;
     }
-}
\ No newline at end of file
+}
+
+void AppInitializer::Shutdown(AppState& state) {
+    // Ein laufender Import hlt sonst das Beenden bis zu seinem Ende auf; sein Journal
+    // bleibt erhalten, sodass er beim nchsten Start fortgesetzt werden kann
+    state.importCancel.cancel();
+
+    configWatcher.reset();
+    cacheWarmer.reset();
+
+    if (callbackIoc) {
+        callbackIoc->stop();
+    }
+    if (callbackThread.joinable()) {
+        callbackThread.join();
+    }
+    callbackServer.reset();
+
+    // Abgebrochene Aufgaben noch auslaufen lassen, dann die Worker beenden
+    Executor::instance().shutdown();
+}
@@ -4,4 +4,7 @@
 class AppInitializer {
 public:
     static bool InitializeServices(AppState& state);
+    // Bricht einen laufenden Import ab und beendet die Hintergrundaufgaben; vor dem Zerstren
+    // des AppState aufrufen
+    static void Shutdown(AppState& state);
 };
\ No newline at end of file
@@ -2,6 +2,9 @@
 #include <string>
 #include "SetlistFmService.h"
 #include "SpotifyService.h"
+#include "MpscQueue.h"
+#include "UiEvent.h"
+#include "CancellationToken.h"
 /// <summary>
 /// Beinhaltet den Zustand der Anwendung, der von der UI verwendet wird und die Services fr Spotify und Setlist.fm.
 /// </summary>
@@ -15,13 +18,25 @@ struct AppState {
     std::string statusMessage = "Bereit";
     bool isLoading = false;
     bool hasSetlist = false;
+    bool quitRequested = false;     // Men "Beenden"; die Hauptschleife beendet die Anwendung
 
     // Setlist-Daten
-    SetlistFmService::Setlist currentSetlist;
+    SetlistFmService::SetlistSnapshot currentSetlist;   // Wird mit laufenden Importen geteilt
+    std::vector<std::string> songDisplayLines;   // "1. Titel (Cover von ...)", einmal pro Setlist gebaut
+    bool virtualizeSongList = true;             // false zeichnet alle Zeilen (nur fr den Vergleich in --bench-ui)
 
     // Playlist-Erstellung
     bool createPlaylist = false;
     char playlistName[256] = "";
     bool playlistCreated = false;
     std::string playlistCreationStatus;
+
+    // Fortschritt des laufenden Imports (aus den ImportEvents)
+    size_t importSongsProcessed = 0;
+    size_t importSongCount = 0;
+    CancellationToken importCancel;     // Bricht den laufenden Import ab
+    uint64_t importGeneration = 0;      // Zhlt die gestarteten Importe; ltere Ereignisse werden verworfen
+
+    // Ergebnisse der Hintergrundaufgaben; nur der UI-Thread liest und ndert die Felder oben
+    MpscQueue<UiEvent> uiEvents;
 };
\ No newline at end of file
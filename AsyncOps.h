@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <functional>
+#include <exception>
+#include <boost/asio/awaitable.hpp>
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/this_coro.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+
+namespace net = boost::asio;
+
+/// <summary>
+/// Hilfsfunktionen zum Kombinieren von Asio-Coroutinen.
+/// </summary>
+class AsyncOps {
+public:
+    // Startet alle Operationen gleichzeitig auf dem Executor des Aufrufers und wartet auf alle.
+    // Die Ergebnisse stehen in der Reihenfolge der Operationen; die erste Exception wird
+    // weitergegeben, nachdem alle Operationen beendet sind.
+    template <typename T>
+    static net::awaitable<std::vector<T>> whenAll(std::vector<net::awaitable<T>> operations);
+};
+
+template <typename T>
+net::awaitable<std::vector<T>> AsyncOps::whenAll(std::vector<net::awaitable<T>> operations) {
+    struct State {
+        std::mutex mutex;
+        std::vector<T> results;
+        size_t remaining = 0;
+        std::exception_ptr error;
+        std::function<void()> waiter;   // Fortsetzung des wartenden Aufrufers
+    };
+
+    auto state = std::make_shared<State>();
+    state->results.resize(operations.size());
+    state->remaining = operations.size();
+    if (operations.empty()) co_return std::vector<T>{};
+
+    auto executor = co_await net::this_coro::executor;
+    for (size_t i = 0; i < operations.size(); i++) {
+        net::co_spawn(executor, std::move(operations[i]),
+            [state, i](std::exception_ptr error, T value) {
+                std::function<void()> waiter;
+                {
+                    std::lock_guard<std::mutex> lock(state->mutex);
+                    if (error) {
+                        if (!state->error) state->error = error;
+                    }
+                    else {
+                        state->results[i] = std::move(value);
+                    }
+                    if (--state->remaining == 0) waiter = std::move(state->waiter);
+                }
+                if (waiter) waiter();
+            });
+    }
+
+    // Benannt statt als Temporary: GCC verlngert die Lebensdauer von Temporaries
+    // in co_await-Ausdrcken nicht zuverlssig
+    auto waitForAll = [state](auto handler) {
+        auto work = net::make_work_guard(handler);
+        auto pending = std::make_shared<std::pair<decltype(handler), decltype(work)>>(
+            std::move(handler), std::move(work));
+        auto resume = [pending]() {
+            auto executor = pending->second.get_executor();
+            net::post(executor, [pending]() {
+                pending->first();
+                pending->second.reset();
+                });
+        };
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        if (state->remaining == 0) {
+            lock.unlock();
+            resume();
+        }
+        else {
+            state->waiter = resume;
+        }
+    };
+    co_await net::async_initiate<decltype(net::use_awaitable), void()>(waitForAll, net::use_awaitable);
+
+    if (state->error) std::rethrow_exception(state->error);
+    co_return std::move(state->results);
+}
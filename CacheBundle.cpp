@@ -0,0 +1,368 @@
+#include "CacheBundle.h"
+#include "MappedFile.h"
+#include <zlib.h>
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include <limits>
+#include <vector>
+#include <cstring>
+
+namespace {
+    constexpr char kMagic[4] = { 'S', 'S', 'C', 'B' };
+    constexpr uint32_t kVersion = 1;
+    constexpr uint32_t kCompressionZlib = 1;
+    // Magic, Version, Kompression, CRC-32, Erstellzeit, Rohgre, gespeicherte Gre
+    constexpr size_t kHeaderSize = 4 + 4 + 4 + 4 + 8 + 8 + 8;
+    // Schutz vor kaputten Kpfen, bevor entsprechend Speicher angelegt wird. zlib rechnet mit uLong
+    // (unter Windows 32 Bit), crc32 mit uInt; auch die komprimierte Gre (hchstens compressBound,
+    // etwa 0,03 % mehr) muss noch hineinpassen. Grere Caches werden beim Export abgelehnt.
+    constexpr uint64_t kMaxRawSize = uint64_t{ 3 } * 1024 * 1024 * 1024;
+    static_assert(kMaxRawSize + kMaxRawSize / 1024 <= std::numeric_limits<uint32_t>::max(),
+        "Das Bundle muss in 32-Bit-Gren von zlib passen");
+
+    int64_t toMs(std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    }
+
+    std::chrono::system_clock::time_point fromMs(int64_t ms) {
+        return std::chrono::system_clock::time_point(std::chrono::milliseconds(ms));
+    }
+
+    // Alle Zahlen little-endian, unabhngig von der Plattform
+    class Writer {
+    public:
+        void u8(uint8_t value) { bytes_.push_back(static_cast<char>(value)); }
+
+        void u32(uint32_t value) {
+            for (int i = 0; i < 4; i++) u8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+
+        void u64(uint64_t value) {
+            for (int i = 0; i < 8; i++) u8(static_cast<uint8_t>(value >> (8 * i)));
+        }
+
+        void i64(int64_t value) { u64(static_cast<uint64_t>(value)); }
+
+        void str(const std::string& value) {
+            u32(static_cast<uint32_t>(value.size()));
+            bytes_.append(value);
+        }
+
+        std::string& bytes() { return bytes_; }
+
+    private:
+        std::string bytes_;
+    };
+
+    // Liest nie ber das Ende hinaus; nach dem ersten Fehler liefert ok() false
+    class Reader {
+    public:
+        Reader(const char* data, size_t size) : data_(data), size_(size) {}
+
+        uint8_t u8() {
+            if (!need(1)) return 0;
+            return static_cast<uint8_t>(data_[pos_++]);
+        }
+
+        uint32_t u32() {
+            if (!need(4)) return 0;
+            uint32_t value = 0;
+            for (int i = 0; i < 4; i++) value |= static_cast<uint32_t>(static_cast<uint8_t>(data_[pos_++])) << (8 * i);
+            return value;
+        }
+
+        uint64_t u64() {
+            if (!need(8)) return 0;
+            uint64_t value = 0;
+            for (int i = 0; i < 8; i++) value |= static_cast<uint64_t>(static_cast<uint8_t>(data_[pos_++])) << (8 * i);
+            return value;
+        }
+
+        int64_t i64() { return static_cast<int64_t>(u64()); }
+
+        std::string str() {
+            uint32_t length = u32();
+            if (!need(length)) return {};
+            std::string value(data_ + pos_, length);
+            pos_ += length;
+            return value;
+        }
+
+        // Obergrenze fr Zhler: jeder Eintrag belegt mindestens minBytes
+        uint32_t count(size_t minBytes) {
+            uint32_t value = u32();
+            if (ok_ && value > (size_ - pos_) / minBytes) ok_ = false;
+            return ok_ ? value : 0;
+        }
+
+        bool ok() const { return ok_; }
+        size_t position() const { return pos_; }
+
+    private:
+        bool need(size_t bytes) {
+            if (!ok_ || size_ - pos_ < bytes) ok_ = false;
+            return ok_;
+        }
+
+        const char* data_;
+        size_t size_;
+        size_t pos_ = 0;
+        bool ok_ = true;
+    };
+
+    std::string encode(const std::vector<TrackCache::Entry>& tracks, const std::vector<SetlistCache::Entry>& setlists) {
+        Writer out;
+        out.u32(static_cast<uint32_t>(tracks.size()));
+        for (const auto& entry : tracks) {
+            out.str(entry.key);
+            out.str(entry.trackId);
+            out.i64(toMs(entry.stored));
+        }
+
+        out.u32(static_cast<uint32_t>(setlists.size()));
+        for (const auto& entry : setlists) {
+            const auto& setlist = entry.setlist;
+            out.str(setlist.id);
+            out.str(setlist.versionId);
+            out.str(setlist.lastUpdated);
+            out.str(setlist.eventDate);
+            out.str(setlist.artist);
+            out.str(setlist.venue);
+            out.str(setlist.city);
+            out.str(setlist.country);
+            out.str(entry.etag);
+            out.str(entry.lastModified);
+            out.i64(toMs(entry.validated));
+            out.u32(static_cast<uint32_t>(setlist.songs.size()));
+            for (const auto& song : setlist.songs) {
+                out.str(song.name);
+                out.str(song.artist);
+                out.u8(song.isCover ? 1 : 0);
+                out.str(song.coverArtist);
+            }
+        }
+        return std::move(out.bytes());
+    }
+
+    bool decode(const std::string& raw, std::vector<TrackCache::Entry>& tracks, std::vector<SetlistCache::Entry>& setlists) {
+        Reader in(raw.data(), raw.size());
+
+        uint32_t trackCount = in.count(4 + 4 + 8);
+        tracks.reserve(trackCount);
+        for (uint32_t i = 0; i < trackCount && in.ok(); i++) {
+            TrackCache::Entry entry;
+            entry.key = in.str();
+            entry.trackId = in.str();
+            entry.stored = fromMs(in.i64());
+            tracks.push_back(std::move(entry));
+        }
+
+        uint32_t setlistCount = in.count(10 * 4 + 8 + 4);
+        setlists.reserve(setlistCount);
+        for (uint32_t i = 0; i < setlistCount && in.ok(); i++) {
+            SetlistCache::Entry entry;
+            auto& setlist = entry.setlist;
+            setlist.id = in.str();
+            setlist.versionId = in.str();
+            setlist.lastUpdated = in.str();
+            setlist.eventDate = in.str();
+            setlist.artist = in.str();
+            setlist.venue = in.str();
+            setlist.city = in.str();
+            setlist.country = in.str();
+            entry.etag = in.str();
+            entry.lastModified = in.str();
+            entry.validated = fromMs(in.i64());
+            uint32_t songCount = in.count(4 + 4 + 1 + 4);
+            setlist.songs.reserve(songCount);
+            for (uint32_t s = 0; s < songCount && in.ok(); s++) {
+                SetlistFmService::Song song;
+                song.name = in.str();
+                song.artist = in.str();
+                song.isCover = in.u8() != 0;
+                song.coverArtist = in.str();
+                setlist.songs.push_back(std::move(song));
+            }
+            setlists.push_back(std::move(entry));
+        }
+
+        return in.ok() && in.position() == raw.size();
+    }
+}
+
+std::optional<CacheBundle::Stats> CacheBundle::exportTo(const std::string& path, const TrackCache& tracks, const SetlistCache& setlists) {
+    auto start = std::chrono::steady_clock::now();
+    auto trackEntries = tracks.entries();
+    auto setlistEntries = setlists.entries();
+    std::string raw = encode(trackEntries, setlistEntries);
+    if (raw.size() > kMaxRawSize) {
+        std::cerr << "Cache-Bundle: Caches sind mit " << raw.size() / (1024 * 1024)
+            << " MB zu gro (hchstens " << kMaxRawSize / (1024 * 1024) << " MB)" << std::endl;
+        return std::nullopt;
+    }
+
+    uLongf storedSize = compressBound(static_cast<uLong>(raw.size()));
+    std::string stored(storedSize, '\0');
+    if (compress2(reinterpret_cast<Bytef*>(stored.data()), &storedSize,
+        reinterpret_cast<const Bytef*>(raw.data()), static_cast<uLong>(raw.size()), Z_BEST_SPEED) != Z_OK) {
+        std::cerr << "Cache-Bundle: Komprimieren fehlgeschlagen" << std::endl;
+        return std::nullopt;
+    }
+    stored.resize(storedSize);
+
+    Writer header;
+    header.bytes().append(kMagic, sizeof(kMagic));
+    header.u32(kVersion);
+    header.u32(kCompressionZlib);
+    header.u32(static_cast<uint32_t>(crc32(0L, reinterpret_cast<const Bytef*>(stored.data()), static_cast<uInt>(stored.size()))));
+    header.i64(toMs(std::chrono::system_clock::now()));
+    header.u64(raw.size());
+    header.u64(stored.size());
+
+    // Erst vollstndig in eine temporre Datei schreiben, dann atomar ersetzen
+    std::string tempName = path + ".tmp";
+    try {
+        {
+            std::ofstream file(tempName, std::ios::trunc | std::ios::binary);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open " + tempName);
+            }
+            file.write(header.bytes().data(), static_cast<std::streamsize>(header.bytes().size()));
+            file.write(stored.data(), static_cast<std::streamsize>(stored.size()));
+            if (!file) {
+                throw std::runtime_error("Could not write " + tempName);
+            }
+        }
+        std::filesystem::rename(tempName, path);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error saving cache bundle: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+
+    Stats stats;
+    stats.tracks = trackEntries.size();
+    stats.setlists = setlistEntries.size();
+    stats.bytes = header.bytes().size() + stored.size();
+    stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return stats;
+}
+
+std::optional<CacheBundle::Stats> CacheBundle::importFrom(const std::string& path, TrackCache& tracks, SetlistCache& setlists) {
+    auto start = std::chrono::steady_clock::now();
+
+    MappedFile file;
+    if (!file.open(path)) return std::nullopt;
+
+    if (file.size() < kHeaderSize || std::memcmp(file.data(), kMagic, sizeof(kMagic)) != 0) {
+        std::cerr << "Cache-Bundle " << path << " hat ein unbekanntes Format" << std::endl;
+        return std::nullopt;
+    }
+
+    Reader header(file.data() + sizeof(kMagic), kHeaderSize - sizeof(kMagic));
+    uint32_t version = header.u32();
+    uint32_t compression = header.u32();
+    uint32_t checksum = header.u32();
+    header.i64();   // Erstellzeit, nur zur Information
+    uint64_t rawSize = header.u64();
+    uint64_t storedSize = header.u64();
+
+    if (version != kVersion || compression != kCompressionZlib) {
+        std::cerr << "Cache-Bundle " << path << ": Version " << version << " wird nicht untersttzt" << std::endl;
+        return std::nullopt;
+    }
+    if (storedSize != file.size() - kHeaderSize || rawSize > kMaxRawSize ||
+        storedSize > std::numeric_limits<uInt>::max()) {
+        std::cerr << "Cache-Bundle " << path << " ist unvollstndig" << std::endl;
+        return std::nullopt;
+    }
+
+    const auto* stored = reinterpret_cast<const Bytef*>(file.data() + kHeaderSize);
+    if (static_cast<uint32_t>(crc32(0L, stored, static_cast<uInt>(storedSize))) != checksum) {
+        std::cerr << "Cache-Bundle " << path << ": Prfsumme stimmt nicht" << std::endl;
+        return std::nullopt;
+    }
+
+    std::string raw(static_cast<size_t>(rawSize), '\0');
+    uLongf rawLength = static_cast<uLongf>(rawSize);
+    if (uncompress(reinterpret_cast<Bytef*>(raw.data()), &rawLength, stored, static_cast<uLong>(storedSize)) != Z_OK ||
+        rawLength != rawSize) {
+        std::cerr << "Cache-Bundle " << path << " lsst sich nicht entpacken" << std::endl;
+        return std::nullopt;
+    }
+
+    std::vector<TrackCache::Entry> trackEntries;
+    std::vector<SetlistCache::Entry> setlistEntries;
+    if (!decode(raw, trackEntries, setlistEntries)) {
+        std::cerr << "Cache-Bundle " << path << " ist beschdigt" << std::endl;
+        return std::nullopt;
+    }
+
+    Stats stats;
+    stats.tracks = tracks.merge(trackEntries);
+    stats.setlists = setlists.merge(setlistEntries);
+    stats.bytes = file.size();
+    stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return stats;
+}
+
+bool CacheBundle::warmStart(const std::string& path, TrackCache& tracks, SetlistCache& setlists) {
+    std::error_code error;
+    if (path.empty() || !std::filesystem::exists(path, error)) return false;
+
+    auto stats = importFrom(path, tracks, setlists);
+    if (!stats) return false;
+
+    std::cout << "Warmstart aus " << path << ": " << stats->tracks << " Tracks, " << stats->setlists
+        << " Setlists in " << stats->elapsed.count() << " ms" << std::endl;
+    return true;
+}
+
+bool CacheBundle::isBundleInvocation(int argc, char** argv) {
+    if (argc < 2) return false;
+    std::string command = argv[1];
+    return command == "--export-caches" || command == "--import-caches";
+}
+
+int CacheBundle::runCommandLine(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Aufruf: --export-caches <Bundle> | --import-caches <Bundle>" << std::endl;
+        return 1;
+    }
+    std::string command = argv[1];
+    std::string path = argv[2];
+    bool exporting = command == "--export-caches";
+
+    // Beim Exportieren nichts verdrngen: das Bundle soll alles enthalten, was auf der Platte liegt
+    TrackCache::Options trackOptions;
+    SetlistCache::Options setlistOptions;
+    if (exporting) {
+        trackOptions.capacity = std::numeric_limits<size_t>::max();
+        setlistOptions.capacity = std::numeric_limits<size_t>::max();
+    }
+    TrackCache tracks(trackOptions);
+    SetlistCache setlists(setlistOptions);
+    tracks.load();
+    setlists.load();
+
+    std::optional<Stats> stats;
+    if (exporting) {
+        stats = exportTo(path, tracks, setlists);
+    }
+    else {
+        stats = importFrom(path, tracks, setlists);
+        if (stats && !(tracks.save() && setlists.save())) return 2;
+    }
+    if (!stats) {
+        if (!exporting) std::cerr << "Kann " << path << " nicht einlesen." << std::endl;
+        return 2;
+    }
+
+    std::cout << std::fixed << std::setprecision(1)
+        << (exporting ? "Exportiert: " : "bernommen: ") << stats->tracks << " Tracks, " << stats->setlists
+        << " Setlists, " << stats->bytes / (1024.0 * 1024.0) << " MB in " << stats->elapsed.count() / 1000.0
+        << " s" << std::endl;
+    return 0;
+}
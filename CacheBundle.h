@@ -0,0 +1,38 @@
+#pragma once
+#include <string>
+#include <optional>
+#include <chrono>
+#include <cstdint>
+#include "TrackCache.h"
+#include "SetlistCache.h"
+
+/// <summary>
+/// Schnappschuss von Track- und Setlist-Cache in einer einzigen Datei, mit dem ein neuer
+/// Worker warm starten kann, statt beide Caches erst ber die APIs aufzubauen.
+/// Format: fester Kopf (Magic "SSCB", Version, Kompression, CRC-32, Gren) und dahinter
+/// die zlib-komprimierten Eintrge in einem kompakten Binrformat. Beim Einlesen wird die
+/// Datei in den Speicher abgebildet, Version und Prfsumme werden vor dem Entpacken geprft.
+/// Bei Eintrgen, die schon im Cache sind, gewinnt jeweils der neuere.
+/// </summary>
+class CacheBundle {
+public:
+    struct Stats {
+        size_t tracks = 0;
+        size_t setlists = 0;
+        uint64_t bytes = 0;             // Gre der Bundle-Datei
+        std::chrono::milliseconds elapsed{ 0 };
+    };
+
+    // Schreibt atomar (temporre Datei, dann umbenennen); nullopt bei Fehlern
+    static std::optional<Stats> exportTo(const std::string& path, const TrackCache& tracks, const SetlistCache& setlists);
+    // bernimmt die Eintrge in die Caches; nullopt, wenn die Datei fehlt oder ungltig ist.
+    // tracks/setlists zhlen dann die tatschlich bernommenen Eintrge.
+    static std::optional<Stats> importFrom(const std::string& path, TrackCache& tracks, SetlistCache& setlists);
+    // Fr den Start: bernimmt das Bundle, falls konfiguriert und vorhanden, und meldet das Ergebnis
+    static bool warmStart(const std::string& path, TrackCache& tracks, SetlistCache& setlists);
+
+    // Kommandozeile: --export-caches <Bundle> bzw. --import-caches <Bundle>
+    // (arbeitet auf track_cache.json und setlist_cache.json im aktuellen Verzeichnis)
+    static bool isBundleInvocation(int argc, char** argv);
+    static int runCommandLine(int argc, char** argv);
+};
@@ -0,0 +1,159 @@
+#include "CacheWarmer.h"
+#include "TrackCache.h"
+#include "HttpClient.h"
+#include <iostream>
+#include <algorithm>
+#include <unordered_map>
+
+namespace {
+    // So oft wird geprft, ob gerade Ruhe herrscht
+    constexpr auto kCheckInterval = std::chrono::seconds(30);
+    constexpr auto kBudgetWindow = std::chrono::hours(1);
+}
+
+CacheWarmer::CacheWarmer(SetlistFmService& setlists, SpotifyService& spotify, const ConfigLoader::WarmingConfig& config)
+    : setlists_(setlists), spotify_(spotify),
+    config_(std::make_shared<const ConfigLoader::WarmingConfig>(config)) {
+    thread_ = std::thread([this]() { run(); });
+}
+
+CacheWarmer::~CacheWarmer() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = true;
+    }
+    stop_.cancel();
+    stopCv_.notify_all();
+    thread_.join();
+}
+
+void CacheWarmer::apply(const ConfigLoader::WarmingConfig& config) {
+    config_.store(std::make_shared<const ConfigLoader::WarmingConfig>(config));
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        wakeUp_ = true;
+    }
+    stopCv_.notify_all();
+}
+
+bool CacheWarmer::waitForNextPass() {
+    std::unique_lock<std::mutex> lock(stopMutex_);
+    stopCv_.wait_for(lock, kCheckInterval, [this]() { return stopping_.load() || wakeUp_; });
+    wakeUp_ = false;
+    return !stopping_;
+}
+
+void CacheWarmer::run() {
+    // Alles, was der Warmer anstt, steht hinter Benutzer-Requests zurck
+    HttpClient::PriorityScope priority(HttpClient::Priority::Background);
+    HttpClient::CancellationScope cancellation(stop_);
+
+    while (waitForNextPass()) {
+        auto config = config_.load();
+        if (!config->enabled || config->artists.empty() || !isQuiet(*config)) continue;
+        // Ohne Anmeldung kann nichts aufgelst werden
+        if (!spotify_.tokenStore()->get(spotify_.account())) continue;
+
+        for (const auto& artist : config->artists) {
+            if (stopping_) break;
+
+            auto it = warmed_.find(artist);
+            if (it != warmed_.end() &&
+                std::chrono::steady_clock::now() - it->second < std::chrono::hours(config->refreshHours)) {
+                continue;
+            }
+            if (!warmArtist(artist, *config)) break;
+            warmed_[artist] = std::chrono::steady_clock::now();
+        }
+    }
+}
+
+bool CacheWarmer::warmArtist(const std::string& artist, const ConfigLoader::WarmingConfig& config) {
+    // Eine Suche kann mehrere Requests kosten; verbucht wird, was wirklich gesendet wurde
+    HttpClient::RequestCountScope requests;
+    if (!mayRequest(config)) return false;
+
+    auto recent = setlists_.searchSetlists(artist);
+    charge(requests.take());
+    if (recent.size() > config.setlistsPerArtist) {
+        recent.resize(config.setlistsPerArtist);
+    }
+
+    auto cache = spotify_.trackCache();
+    size_t resolved = 0;
+    size_t cached = 0;
+    bool complete = true;
+    for (const auto& candidate : rankSongs(recent)) {
+        if (stopping_) {
+            complete = false;
+            break;
+        }
+        if (cache->get(TrackCache::makeKey(candidate.title, candidate.artist))) {
+            cached++;
+            continue;
+        }
+        if (!mayRequest(config)) {
+            complete = false;
+            break;
+        }
+        if (spotify_.searchTrackId(candidate.title, candidate.artist, candidate.alternateArtist)) {
+            resolved++;
+        }
+        charge(requests.take());
+    }
+
+    if (resolved > 0) cache->save();
+    std::cout << "Cache-Warmer: " << artist << ": " << recent.size() << " Setlists, " << resolved
+        << " Songs neu aufgelst, " << cached << " bereits im Cache"
+        << (complete ? "" : " (unterbrochen)") << "." << std::endl;
+    return complete;
+}
+
+bool CacheWarmer::mayRequest(const ConfigLoader::WarmingConfig& config) {
+    if (!isQuiet(config)) return false;
+
+    auto now = std::chrono::steady_clock::now();
+    while (!spent_.empty() && now - spent_.front() >= kBudgetWindow) {
+        spent_.pop_front();
+    }
+    return spent_.size() < static_cast<size_t>(config.requestsPerHour);
+}
+
+void CacheWarmer::charge(uint64_t requests) {
+    auto now = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < requests; i++) {
+        spent_.push_back(now);
+    }
+}
+
+bool CacheWarmer::isQuiet(const ConfigLoader::WarmingConfig& config) const {
+    auto idle = std::min(spotify_.foregroundIdle(), setlists_.foregroundIdle());
+    return idle >= std::chrono::seconds(config.quietSeconds);
+}
+
+std::vector<CacheWarmer::Candidate> CacheWarmer::rankSongs(const std::vector<SetlistFmService::Setlist>& setlists) {
+    std::vector<Candidate> candidates;
+    std::unordered_map<std::string, size_t> index;
+
+    for (const auto& setlist : setlists) {
+        for (const auto& song : setlist.songs) {
+            if (song.name.empty()) continue;
+
+            // Wie beim Import: Covers unter dem Original-Knstler, die Band als Ausweichkandidat
+            bool isCover = song.isCover && !song.coverArtist.empty();
+            const std::string& artist = isCover ? song.coverArtist : song.artist;
+            std::string key = TrackCache::makeKey(song.name, artist);
+
+            auto [it, inserted] = index.try_emplace(key, candidates.size());
+            if (inserted) {
+                candidates.push_back({ song.name, artist, isCover ? song.artist : std::string(), 0 });
+            }
+            candidates[it->second].count++;
+        }
+    }
+
+    // Bei Gleichstand bleibt die Reihenfolge der jngsten Setlist erhalten
+    std::stable_sort(candidates.begin(), candidates.end(),
+        [](const Candidate& a, const Candidate& b) { return a.count > b.count; });
+    return candidates;
+}
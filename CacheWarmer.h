@@ -0,0 +1,68 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include "ConfigLoader.h"
+#include "SetlistFmService.h"
+#include "SpotifyService.h"
+
+/// <summary>
+/// Wrmt in ruhigen Phasen die Caches fr eine Liste beobachteter Knstler vor: holt deren
+/// jngste Setlists und lst die hufigsten Songs schon einmal in Track-IDs auf. Luft als
+/// Background-Prioritt, nur wenn seit quiet_s kein Benutzer-Request lief, und hchstens
+/// mit requests_per_hour Requests pro Stunde. Setzt bei Benutzeraktivitt sofort aus.
+/// </summary>
+class CacheWarmer {
+public:
+    CacheWarmer(SetlistFmService& setlists, SpotifyService& spotify, const ConfigLoader::WarmingConfig& config);
+    ~CacheWarmer();
+
+    CacheWarmer(const CacheWarmer&) = delete;
+    CacheWarmer& operator=(const CacheWarmer&) = delete;
+
+    // bernimmt genderte Einstellungen (z.B. vom ConfigWatcher) und prft sofort erneut
+    void apply(const ConfigLoader::WarmingConfig& config);
+
+private:
+    struct Candidate {
+        std::string title;
+        std::string artist;
+        std::string alternateArtist;
+        size_t count = 0;
+    };
+
+    void run();
+    // Wartet bis zum nchsten Durchlauf; false, wenn der Warmer beendet wird
+    bool waitForNextPass();
+    // Vollstndig vorgewrmt; false, wenn abgebrochen wurde (Benutzer aktiv, Budget erschpft)
+    bool warmArtist(const std::string& artist, const ConfigLoader::WarmingConfig& config);
+    // Ruhig und Budget brig?
+    bool mayRequest(const ConfigLoader::WarmingConfig& config);
+    // Verbucht die tatschlich gesendeten Requests (samt Wiederholungen, Hedges, Kaskade)
+    void charge(uint64_t requests);
+    bool isQuiet(const ConfigLoader::WarmingConfig& config) const;
+    // Songs der Setlists, die hufigsten zuerst; Covers unter dem Original-Knstler
+    static std::vector<Candidate> rankSongs(const std::vector<SetlistFmService::Setlist>& setlists);
+
+    SetlistFmService& setlists_;
+    SpotifyService& spotify_;
+    std::atomic<std::shared_ptr<const ConfigLoader::WarmingConfig>> config_;
+
+    // Nur im Warmer-Thread benutzt
+    std::deque<std::chrono::steady_clock::time_point> spent_;   // Requests der letzten Stunde
+    std::map<std::string, std::chrono::steady_clock::time_point> warmed_;
+
+    std::mutex stopMutex_;
+    std::condition_variable stopCv_;
+    bool wakeUp_ = false;
+    std::atomic<bool> stopping_{ false };
+    CancellationToken stop_ = CancellationToken::create();     // Bricht beim Beenden den laufenden Request ab
+    std::thread thread_;
+};
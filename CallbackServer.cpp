@@ -1,75 +1,428 @@
 #include "CallbackServer.h"
+#include "Executor.h"
 #include <iostream>
+#include <chrono>
+#include <random>
+#include <cstdio>
+
+namespace {
+    // 128 Bit aus dem Zufallsgenerator des Systems, als Hex-String
+    std::string randomState() {
+        std::random_device random;
+        std::string state;
+        char buffer[9];
+        for (int i = 0; i < 4; i++) {
+            std::snprintf(buffer, sizeof(buffer), "%08x", static_cast<unsigned>(random()));
+            state += buffer;
+        }
+        return state;
+    }
+
+    int hexValue(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    std::string urlDecode(std::string_view value) {
+        std::string decoded;
+        decoded.reserve(value.size());
+        for (size_t i = 0; i < value.size(); i++) {
+            if (value[i] == '+') {
+                decoded += ' ';
+            }
+            else if (value[i] == '%' && i + 2 < value.size() && hexValue(value[i + 1]) >= 0 && hexValue(value[i + 2]) >= 0) {
+                decoded += static_cast<char>(hexValue(value[i + 1]) * 16 + hexValue(value[i + 2]));
+                i += 2;
+            }
+            else {
+                decoded += value[i];
+            }
+        }
+        return decoded;
+    }
+}
 
 CallbackServer::CallbackServer(net::io_context& ioc, uint16_t port)
-    : acceptor_(ioc, { net::ip::make_address("127.0.0.1"), port }) {
+    : ioc_(ioc), acceptor_(ioc, { net::ip::make_address("127.0.0.1"), port }), sweepTimer_(ioc) {
+}
+
+void CallbackServer::addRoute(http::verb method, const std::string& prefix, RouteHandler handler) {
+    routes_.push_back({ method, prefix, std::move(handler) });
+}
+
+void CallbackServer::addStreamRoute(const std::string& prefix, StreamHandler handler) {
+    streamRoutes_.push_back({ prefix, std::move(handler) });
 }
 
-void CallbackServer::start(std::function<void(const std::string&)> callback_handler) {
-    accept(callback_handler);
+void CallbackServer::start() {
+    accept();
+    sweepAuthorizations();
 }
 
-void CallbackServer::accept(std::function<void(const std::string&)> callback_handler) {
+std::string CallbackServer::beginAuthorization(AuthorizationHandler handler, std::chrono::seconds timeout) {
+    std::lock_guard<std::mutex> lock(authorizationsMutex_);
+    std::string state;
+    do {
+        state = randomState();
+    } while (authorizations_.count(state));
+    authorizations_[state] = { std::move(handler), std::chrono::steady_clock::now() + timeout };
+    return state;
+}
+
+bool CallbackServer::cancelAuthorization(const std::string& state) {
+    std::lock_guard<std::mutex> lock(authorizationsMutex_);
+    return authorizations_.erase(state) > 0;
+}
+
+size_t CallbackServer::pendingAuthorizations() const {
+    std::lock_guard<std::mutex> lock(authorizationsMutex_);
+    return authorizations_.size();
+}
+
+void CallbackServer::completeAuthorization(AuthorizationHandler handler, std::optional<std::string> code) {
+    // Der Token-Austausch blockiert; der I/O-Thread soll derweil weitere Redirects annehmen
+    bool posted = Executor::instance().post([handler = std::move(handler), code = std::move(code)]() mutable {
+        handler(std::move(code));
+        });
+    if (!posted) {
+        std::cerr << "Anmeldung verworfen, die Anwendung wird beendet." << std::endl;
+    }
+}
+
+void CallbackServer::sweepAuthorizations() {
+    std::vector<AuthorizationHandler> expired;
+    {
+        std::lock_guard<std::mutex> lock(authorizationsMutex_);
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = authorizations_.begin(); it != authorizations_.end();) {
+            if (it->second.expires <= now) {
+                expired.push_back(std::move(it->second.handler));
+                it = authorizations_.erase(it);
+            }
+            else {
+                ++it;
+            }
+        }
+    }
+    for (auto& handler : expired) {
+        completeAuthorization(std::move(handler), std::nullopt);
+    }
+
+    sweepTimer_.expires_after(kAuthorizationSweepInterval);
+    sweepTimer_.async_wait([this](beast::error_code ec) {
+        if (!ec) sweepAuthorizations();
+        });
+}
+
+void CallbackServer::accept() {
+    // Jede Verbindung bekommt einen eigenen Strand, damit der io_context auf mehreren Threads laufen kann
     acceptor_.async_accept(
-        [this, callback_handler](beast::error_code ec, tcp::socket socket) {
+        net::make_strand(ioc_),
+        [this](beast::error_code ec, tcp::socket socket) {
             if (!ec) {
-                handleConnection(std::move(socket), callback_handler);
+                std::make_shared<Connection>(std::move(socket), *this)->start();
             }
-            accept(callback_handler);
+            accept();
         });
 }
 
-void CallbackServer::handleConnection(tcp::socket socket, std::function<void(const std::string&)> callback_handler) {
-    auto connection = std::make_shared<Connection>(std::move(socket));
-    connection->start(
-        [callback_handler](const std::string& code) {
-            callback_handler(code);
+CallbackServer::Response CallbackServer::dispatch(const Request& request) {
+    std::string_view target(request.target().data(), request.target().size());
+    for (const auto& route : routes_) {
+        if (route.method == request.method() && target.substr(0, route.prefix.size()) == route.prefix) {
+            try {
+                return route.handler(request);
+            }
+            catch (const std::exception& e) {
+                std::cerr << "Fehler in Route " << route.prefix << ": " << e.what() << std::endl;
+                return makeResponse(request, http::status::internal_server_error,
+                    "{\"error\":\"internal error\"}");
+            }
+        }
+    }
+
+    // Alles andere mit einem state-Parameter ist ein OAuth-Redirect (der Pfad kommt aus der redirect_uri)
+    if (request.method() == http::verb::get) {
+        auto query = queryParameters(target);
+        if (query.count("state")) {
+            return handleOAuthRedirect(request, query);
+        }
+    }
+    return makeResponse(request, http::status::not_found, "{\"error\":\"not found\"}");
+}
+
+const CallbackServer::StreamRoute* CallbackServer::findStreamRoute(const Request& request) const {
+    if (request.method() != http::verb::get) return nullptr;
+
+    std::string_view target(request.target().data(), request.target().size());
+    for (const auto& route : streamRoutes_) {
+        if (target.substr(0, route.prefix.size()) == route.prefix) {
+            return &route;
+        }
+    }
+    return nullptr;
+}
+
+CallbackServer::Response CallbackServer::handleOAuthRedirect(const Request& request,
+    const std::map<std::string, std::string>& query) {
+    // Jeder state gilt genau einmal
+    AuthorizationHandler handler;
+    {
+        std::lock_guard<std::mutex> lock(authorizationsMutex_);
+        auto it = authorizations_.find(query.at("state"));
+        if (it != authorizations_.end()) {
+            handler = std::move(it->second.handler);
+            authorizations_.erase(it);
         }
-    );
+    }
+    if (!handler) {
+        return makeResponse(request, http::status::bad_request,
+            "Unknown or expired authorization request. Please start again.", "text/html");
+    }
+
+    auto code = query.find("code");
+    if (query.count("error") || code == query.end() || code->second.empty()) {
+        completeAuthorization(std::move(handler), std::nullopt);
+        return makeResponse(request, http::status::ok,
+            "Authorization was not granted. You can close this window.", "text/html");
+    }
+
+    completeAuthorization(std::move(handler), code->second);
+    return makeResponse(request, http::status::ok,
+        "Authorization successful! You can close this window.", "text/html");
+}
+
+std::map<std::string, std::string> CallbackServer::queryParameters(std::string_view target) {
+    std::map<std::string, std::string> parameters;
+    size_t start = target.find('?');
+    if (start == std::string_view::npos) return parameters;
+
+    std::string_view query = target.substr(start + 1);
+    query = query.substr(0, query.find('#'));
+    while (!query.empty()) {
+        size_t end = query.find('&');
+        std::string_view pair = query.substr(0, end);
+        size_t equals = pair.find('=');
+        if (!pair.empty()) {
+            std::string name = urlDecode(pair.substr(0, equals));
+            std::string value = equals == std::string_view::npos ? std::string() : urlDecode(pair.substr(equals + 1));
+            parameters.emplace(std::move(name), std::move(value));
+        }
+        if (end == std::string_view::npos) break;
+        query.remove_prefix(end + 1);
+    }
+    return parameters;
+}
+
+CallbackServer::Response CallbackServer::makeResponse(const Request& request, http::status status,
+    const std::string& body, const std::string& contentType) {
+    Response response{ status, request.version() };
+    response.set(http::field::server, "CallbackServer");
+    response.set(http::field::content_type, contentType);
+    response.keep_alive(request.keep_alive());
+    response.body() = body;
+    response.prepare_payload();
+    return response;
 }
 
 // Connection class implementation
-CallbackServer::Connection::Connection(tcp::socket socket)
-    : socket_(std::move(socket)) {
+CallbackServer::Connection::Connection(tcp::socket socket, CallbackServer& server)
+    : stream_(std::move(socket)), server_(server) {
+}
+
+void CallbackServer::Connection::start() {
+    read();
 }
 
-void CallbackServer::Connection::start(std::function<void(const std::string&)> callback_handler) {
-    auto self = shared_from_this();
+void CallbackServer::Connection::read() {
+    // Leerlaufende Keep-Alive-Verbindungen nach 30 Sekunden schlieen
+    request_ = {};
+    stream_.expires_after(std::chrono::seconds(30));
+
     http::async_read(
-        socket_,
+        stream_,
         buffer_,
         request_,
-        [self, callback_handler](beast::error_code ec, std::size_t) {
+        [self = shared_from_this()](beast::error_code ec, std::size_t) {
             if (!ec) {
-                self->handleRequest(callback_handler);
+                self->handleRequest();
+            }
+            else {
+                self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
             }
         });
 }
 
-void CallbackServer::Connection::handleRequest(std::function<void(const std::string&)> callback_handler) {
-    // Parse the query string to get the authorization code
-    std::string target = std::string(request_.target());
-    size_t code_pos = target.find("code=");
-    if (code_pos != std::string::npos) {
-        std::string code = target.substr(code_pos + 5);
-        size_t end_pos = code.find('&');
-        if (end_pos != std::string::npos) {
-            code = code.substr(0, end_pos);
-        }
-        callback_handler(code);
+void CallbackServer::Connection::handleRequest() {
+    if (auto route = server_.findStreamRoute(request_)) {
+        startStream(*route);
+        return;
     }
 
-    // Send response
-    http::response<http::string_body> response{ http::status::ok, request_.version() };
-    response.set(http::field::server, "CallbackServer");
-    response.set(http::field::content_type, "text/html");
-    response.body() = "Authorization successful! You can close this window.";
-    response.prepare_payload();
+    response_ = std::make_shared<Response>(server_.dispatch(request_));
 
     http::async_write(
-        socket_,
-        response,
+        stream_,
+        *response_,
+        [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (!ec && self->response_->keep_alive()) {
+                self->read();
+                return;
+            }
+            self->stream_.socket().shutdown(tcp::socket::shutdown_send, ec);
+        });
+}
+
+void CallbackServer::Connection::startStream(const StreamRoute& route) {
+    // Die Verbindung geht an den EventStream ber; diese Connection endet hier
+    auto eventStream = std::make_shared<EventStream>(std::move(stream_));
+
+    std::optional<Response> rejection;
+    try {
+        rejection = route.handler(request_, eventStream);
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fehler in Stream-Route " << route.prefix << ": " << e.what() << std::endl;
+        rejection = makeResponse(request_, http::status::internal_server_error, "{\"error\":\"internal error\"}");
+    }
+
+    if (rejection) {
+        rejection->keep_alive(false);
+        eventStream->reject(std::move(*rejection));
+    }
+    else {
+        eventStream->open();
+    }
+}
+
+// EventStream class implementation
+CallbackServer::EventStream::EventStream(beast::tcp_stream&& stream)
+    : stream_(std::move(stream)) {
+    // Event-Streams sind langlebig: kein Leerlauf-Timeout
+    stream_.expires_never();
+}
+
+void CallbackServer::EventStream::onClose(std::function<void()> handler) {
+    net::post(stream_.get_executor(), [self = shared_from_this(), handler = std::move(handler)]() mutable {
+        if (!self->open_) {
+            handler();
+            return;
+        }
+        self->closeHandler_ = std::move(handler);
+        });
+}
+
+void CallbackServer::EventStream::send(const std::string& event, const std::string& data) {
+    if (!open_) return;
+    enqueue("event: " + event + "\ndata: " + data + "\n\n");
+}
+
+void CallbackServer::EventStream::close() {
+    net::post(stream_.get_executor(), [self = shared_from_this()]() {
+        self->closeAfterDrain_ = true;
+        if (self->ready_ && !self->writing_ && self->queue_.empty()) {
+            self->shutdown();
+        }
+        });
+}
+
+void CallbackServer::EventStream::open() {
+    net::post(stream_.get_executor(), [self = shared_from_this()]() {
+        // Ohne Content-Length und Chunked-Encoding endet der Body erst mit der Verbindung;
+        // Connection: close sagt das Clients und Proxys, damit sie den Socket nicht weiterverwenden
+        self->queue_.push_front(
+            "HTTP/1.1 200 OK\r\n"
+            "Server: CallbackServer\r\n"
+            "Content-Type: text/event-stream\r\n"
+            "Cache-Control: no-cache\r\n"
+            "Connection: close\r\n"
+            "\r\n");
+        self->ready_ = true;
+        self->writeNext();
+        self->watchDisconnect();
+        });
+}
+
+void CallbackServer::EventStream::reject(Response response) {
+    rejectResponse_ = std::make_shared<Response>(std::move(response));
+    net::post(stream_.get_executor(), [self = shared_from_this()]() {
+        http::async_write(
+            self->stream_,
+            *self->rejectResponse_,
+            [self](beast::error_code, std::size_t) {
+                self->shutdown();
+            });
+        });
+}
+
+void CallbackServer::EventStream::enqueue(std::string message) {
+    net::post(stream_.get_executor(), [self = shared_from_this(), message = std::move(message)]() mutable {
+        if (!self->open_) return;
+        if (self->queue_.size() >= kMaxQueuedEvents) {
+            std::cerr << "Event-Stream-Client zu langsam, Verbindung wird getrennt." << std::endl;
+            self->shutdown();
+            return;
+        }
+        self->queue_.push_back(std::move(message));
+        if (self->ready_ && !self->writing_) {
+            self->writeNext();
+        }
+        });
+}
+
+void CallbackServer::EventStream::writeNext() {
+    if (queue_.empty()) {
+        writing_ = false;
+        if (closeAfterDrain_) shutdown();
+        return;
+    }
+
+    writing_ = true;
+    net::async_write(
+        stream_,
+        net::buffer(queue_.front()),
         [self = shared_from_this()](beast::error_code ec, std::size_t) {
-            self->socket_.shutdown(tcp::socket::shutdown_send, ec);
+            if (ec || !self->open_) {
+                // Erst jetzt gibt der Schreibvorgang den Puffer in queue_.front() frei
+                self->writing_ = false;
+                self->queue_.clear();
+                self->shutdown();
+                return;
+            }
+            self->queue_.pop_front();
+            self->writeNext();
         });
-}
\ No newline at end of file
+}
+
+void CallbackServer::EventStream::watchDisconnect() {
+    // Clients senden nach dem Request nichts mehr; ein Lesefehler bedeutet Verbindungsabbruch
+    stream_.async_read_some(
+        net::buffer(&readByte_, 1),
+        [self = shared_from_this()](beast::error_code ec, std::size_t) {
+            if (ec) {
+                self->shutdown();
+                return;
+            }
+            self->watchDisconnect();
+        });
+}
+
+void CallbackServer::EventStream::shutdown() {
+    if (!open_.exchange(false)) return;
+
+    // Laufende Operationen enden mit operation_aborted. Ein laufender Schreibvorgang liest noch
+    // aus queue_.front(); die Warteschlange leert dann erst sein Completion-Handler.
+    beast::error_code ec;
+    stream_.socket().cancel(ec);
+    stream_.socket().shutdown(tcp::socket::shutdown_both, ec);
+    stream_.socket().close(ec);
+    if (!writing_) queue_.clear();
+
+    if (closeHandler_) {
+        auto handler = std::move(closeHandler_);
+        closeHandler_ = nullptr;
+        handler();
+    }
+}
@@ -5,33 +5,151 @@
 #include <functional>
 #include <memory>
 #include <string>
+#include <vector>
+#include <deque>
+#include <atomic>
+#include <optional>
+#include <mutex>
+#include <chrono>
+#include <map>
+#include <unordered_map>
 
 namespace beast = boost::beast;
 namespace http = beast::http;
 namespace net = boost::asio;
 using tcp = boost::asio::ip::tcp;
 
+/// <summary>
+/// Lokaler HTTP-Server. Nimmt OAuth-Redirects entgegen und kann zustzlich
+/// Routen (z.B. die Job-API) sowie Server-Sent-Event-Streams bedienen. Verbindungen
+/// bleiben per Keep-Alive offen; der io_context darf auf mehreren Threads laufen.
+/// Beliebig viele OAuth-Vorgnge knnen gleichzeitig offen sein: jeder bekommt einen
+/// eigenen state-Parameter, ber den der Redirect ihm zugeordnet wird. Der Austausch
+/// des Codes luft auf dem Executor, damit der I/O-Thread sofort weiter annimmt.
+/// </summary>
 class CallbackServer {
 public:
+    using Request = http::request<http::string_body>;
+    using Response = http::response<http::string_body>;
+    using RouteHandler = std::function<Response(const Request&)>;
+
+    /// <summary>
+    /// Server-Sent-Events-Verbindung. send() und close() sind threadsicher; die
+    /// Schreibvorgnge laufen auf dem Strand der Verbindung.
+    /// </summary>
+    class EventStream : public std::enable_shared_from_this<EventStream> {
+    public:
+        EventStream(beast::tcp_stream&& stream);
+
+        void send(const std::string& event, const std::string& data);
+        void close();   // Schliet nach dem Senden aller ausstehenden Ereignisse
+        bool isOpen() const { return open_; }
+
+        // Wird einmalig aufgerufen, sobald die Verbindung geschlossen ist
+        void onClose(std::function<void()> handler);
+
+    private:
+        friend class CallbackServer;
+
+        // Begrenzt den Rckstau bei langsamen Clients
+        static constexpr size_t kMaxQueuedEvents = 4096;
+
+        void open();
+        void reject(Response response);
+        void enqueue(std::string message);
+        void writeNext();
+        void watchDisconnect();
+        void shutdown();
+
+        beast::tcp_stream stream_;
+        std::deque<std::string> queue_;
+        std::shared_ptr<Response> rejectResponse_;
+        std::function<void()> closeHandler_;
+        std::atomic<bool> open_{ true };
+        bool ready_ = false;
+        bool writing_ = false;
+        bool closeAfterDrain_ = false;
+        char readByte_ = 0;
+    };
+
+    // Liefert der Handler eine Antwort, wird sie statt des Streams gesendet (z.B. 404)
+    using StreamHandler = std::function<std::optional<Response>(const Request&, std::shared_ptr<EventStream>)>;
+
+    // Ergebnis eines OAuth-Vorgangs: der Autorisierungscode, oder nullopt bei Ablehnung bzw. Ablauf
+    using AuthorizationHandler = std::function<void(std::optional<std::string> code)>;
+
     explicit CallbackServer(net::io_context& ioc, uint16_t port);
-    void start(std::function<void(const std::string&)> callback_handler);
+
+    // Routen mssen vor start() registriert werden
+    void addRoute(http::verb method, const std::string& prefix, RouteHandler handler);
+    void addStreamRoute(const std::string& prefix, StreamHandler handler);
+
+    void start();
+
+    // Meldet einen OAuth-Vorgang an und liefert seinen (zuflligen) state-Parameter fr die
+    // Autorisierungs-URL. Der Handler luft genau einmal, auf dem Executor. Threadsicher.
+    std::string beginAuthorization(AuthorizationHandler handler,
+        std::chrono::seconds timeout = std::chrono::minutes(10));
+    // false, wenn der Vorgang schon abgeschlossen oder unbekannt ist; der Handler luft dann nicht mehr
+    bool cancelAuthorization(const std::string& state);
+    size_t pendingAuthorizations() const;
+
+    // Hilfsfunktion fr Route-Handler
+    static Response makeResponse(const Request& request, http::status status,
+        const std::string& body, const std::string& contentType = "application/json");
+    // Query-Parameter des Ziels, URL-dekodiert
+    static std::map<std::string, std::string> queryParameters(std::string_view target);
 
 private:
-    void accept(std::function<void(const std::string&)> callback_handler);
-    void handleConnection(tcp::socket socket, std::function<void(const std::string&)> callback_handler);
+    struct Route {
+        http::verb method;
+        std::string prefix;
+        RouteHandler handler;
+    };
+
+    struct StreamRoute {
+        std::string prefix;
+        StreamHandler handler;
+    };
+
+    struct PendingAuthorization {
+        AuthorizationHandler handler;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // Abgelaufene Vorgnge werden so oft gemeldet und entfernt
+    static constexpr auto kAuthorizationSweepInterval = std::chrono::seconds(15);
+
+    void accept();
+    Response dispatch(const Request& request);
+    const StreamRoute* findStreamRoute(const Request& request) const;
+    Response handleOAuthRedirect(const Request& request, const std::map<std::string, std::string>& query);
+    void completeAuthorization(AuthorizationHandler handler, std::optional<std::string> code);
+    void sweepAuthorizations();
 
     class Connection : public std::enable_shared_from_this<Connection> {
     public:
-        explicit Connection(tcp::socket socket);
-        void start(std::function<void(const std::string&)> callback_handler);
+        Connection(tcp::socket socket, CallbackServer& server);
+        void start();
 
     private:
-        void handleRequest(std::function<void(const std::string&)> callback_handler);
+        void read();
+        void handleRequest();
+        void startStream(const StreamRoute& route);
 
-        tcp::socket socket_;
+        beast::tcp_stream stream_;
         beast::flat_buffer buffer_;
-        http::request<http::string_body> request_;
+        Request request_;
+        std::shared_ptr<Response> response_;
+        CallbackServer& server_;
     };
 
+    net::io_context& ioc_;
     tcp::acceptor acceptor_;
-};
\ No newline at end of file
+    std::vector<Route> routes_;
+    std::vector<StreamRoute> streamRoutes_;
+
+    mutable std::mutex authorizationsMutex_;
+    std::unordered_map<std::string, PendingAuthorization> authorizations_;
+    net::steady_timer sweepTimer_;
+};
@@ -0,0 +1,49 @@
+#pragma once
+#include <memory>
+#include <atomic>
+
+/// <summary>
+/// Kooperativer Abbruch laufender Arbeit, z.B. eines Imports, den niemand mehr braucht.
+/// Kopien teilen denselben Zustand, cancel() wirkt also auf alle. Ein verknpftes Token
+/// gilt zustzlich als abgebrochen, sobald sein bergeordnetes Token abgebrochen wird.
+/// Ein leeres (standardkonstruiertes) Token wird nie abgebrochen.
+/// </summary>
+class CancellationToken {
+public:
+    CancellationToken() = default;
+
+    static CancellationToken create() {
+        CancellationToken token;
+        token.state_ = std::make_shared<State>();
+        return token;
+    }
+
+    // Lsst sich einzeln abbrechen, folgt aber auch dem Abbruch von parent
+    static CancellationToken linkedTo(const CancellationToken& parent) {
+        CancellationToken token = create();
+        token.state_->parent = parent.state_;
+        return token;
+    }
+
+    void cancel() const {
+        if (state_) state_->cancelled.store(true, std::memory_order_release);
+    }
+
+    bool cancelled() const {
+        for (const State* state = state_.get(); state; state = state->parent.get()) {
+            if (state->cancelled.load(std::memory_order_acquire)) return true;
+        }
+        return false;
+    }
+
+    // false fr leere Tokens
+    bool cancellable() const { return state_ != nullptr; }
+
+private:
+    struct State {
+        std::atomic<bool> cancelled{ false };
+        std::shared_ptr<const State> parent;
+    };
+
+    std::shared_ptr<State> state_;
+};
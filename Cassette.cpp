@@ -0,0 +1,143 @@
+#include "Cassette.h"
+#include <iostream>
+#include <sstream>
+#include <iomanip>
+#include <cstdint>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    std::string hashBody(const std::string& body) {
+        // FNV-1a: der Body kann Zugangsdaten enthalten und wird nur als Hash abgelegt
+        uint64_t hash = 14695981039346656037ull;
+        for (unsigned char c : body) {
+            hash ^= c;
+            hash *= 1099511628211ull;
+        }
+        std::ostringstream out;
+        out << std::hex << std::setw(16) << std::setfill('0') << hash;
+        return out.str();
+    }
+
+    std::string redactTokens(const std::string& body) {
+        if (body.find("_token") == std::string::npos) return body;
+        try {
+            auto j = json::parse(body);
+            if (!j.is_object()) return body;
+            for (const char* key : { "access_token", "refresh_token" }) {
+                if (j.contains(key)) j[key] = "redacted";
+            }
+            return j.dump();
+        }
+        catch (const json::exception&) {
+            return body;
+        }
+    }
+}
+
+std::shared_ptr<Cassette> Cassette::shared(const std::string& filename, Mode mode, bool originalTiming) {
+    static std::mutex registryMutex;
+    static std::map<std::string, std::weak_ptr<Cassette>> registry;
+
+    std::string key = filename + (mode == Mode::Record ? "|record" : "|replay") + (originalTiming ? "|timed" : "");
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (auto existing = registry[key].lock()) {
+        return existing;
+    }
+    auto cassette = std::make_shared<Cassette>(filename, mode, originalTiming);
+    registry[key] = cassette;
+    return cassette;
+}
+
+Cassette::Cassette(const std::string& filename, Mode mode, bool originalTiming)
+    : filename_(filename), mode_(mode), originalTiming_(originalTiming) {
+    if (mode_ == Mode::Record) {
+        out_.open(filename_, std::ios::trunc | std::ios::binary);
+        if (!out_.is_open()) {
+            std::cerr << "Konnte Kassette nicht anlegen: " << filename_ << std::endl;
+        }
+    }
+    else {
+        load();
+        std::cout << "Kassette " << filename_ << " geladen: " << count_ << " Antworten." << std::endl;
+    }
+}
+
+std::string Cassette::keyFor(const HttpClient::Request& request) {
+    return request.method + " " + request.url + " " + hashBody(request.body);
+}
+
+void Cassette::record(const HttpClient::Request& request, const HttpClient::Response& response) {
+    json entry = {
+        {"method", request.method},
+        {"url", request.url},
+        {"body_hash", hashBody(request.body)},
+        {"ok", response.ok},
+        {"status", response.status},
+        {"timed_out", response.timedOut},
+        {"error", response.error},
+        {"http_version", response.httpVersion},
+        {"headers", response.headers},
+        {"body", redactTokens(response.body)},
+        {"elapsed_ms", response.elapsed.count()}
+    };
+    std::string line = entry.dump();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!out_.is_open()) return;
+    // Zeilenweise und sofort, damit auch ein abgebrochener Lauf verwertbar bleibt
+    out_ << line << '\n';
+    out_.flush();
+    count_++;
+}
+
+std::optional<HttpClient::Response> Cassette::replay(const HttpClient::Request& request) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = tracks_.find(keyFor(request));
+    if (it == tracks_.end() || it->second.responses.empty()) return std::nullopt;
+
+    auto& track = it->second;
+    auto response = track.responses[std::min(track.next, track.responses.size() - 1)];
+    track.next++;
+    return response;
+}
+
+size_t Cassette::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+void Cassette::load() {
+    std::ifstream file(filename_, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Konnte Kassette nicht ffnen: " << filename_ << std::endl;
+        return;
+    }
+
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty()) continue;
+        try {
+            auto entry = json::parse(line);
+            HttpClient::Response response;
+            response.ok = entry.value("ok", false);
+            response.status = entry.value("status", 0L);
+            response.timedOut = entry.value("timed_out", false);
+            response.error = entry.value("error", "");
+            response.httpVersion = entry.value("http_version", 0L);
+            response.headers = entry.value("headers", std::map<std::string, std::string>{});
+            response.body = entry.value("body", "");
+            response.elapsed = std::chrono::milliseconds(entry.value("elapsed_ms", 0LL));
+
+            std::string key = entry.at("method").get<std::string>() + " " + entry.at("url").get<std::string>() +
+                " " + entry.at("body_hash").get<std::string>();
+            tracks_[key].responses.push_back(std::move(response));
+            count_++;
+        }
+        catch (const json::exception& e) {
+            // Eine beim Aufnehmen abgeschnittene letzte Zeile ist kein Fehler
+            std::cerr << "berspringe ungltigen Kassetteneintrag: " << e.what() << std::endl;
+        }
+    }
+}
@@ -0,0 +1,61 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <fstream>
+#include <optional>
+#include <chrono>
+#include "HttpClient.h"
+
+/// <summary>
+/// Aufzeichnung von HTTP-Requests und -Antworten samt gemessener Latenz (eine JSON-Zeile pro
+/// Austausch). Im Aufnahmemodus schreibt der HttpClient jede Antwort mit, im Wiedergabemodus
+/// beantwortet die Kassette die Requests ohne Netzwerk, wahlweise sofort oder mit der
+/// ursprnglichen Latenz. Request-Header (Tokens) werden nicht gespeichert, Tokens in
+/// Antworten geschwrzt.
+/// </summary>
+class Cassette {
+public:
+    enum class Mode { Record, Replay };
+
+    // Gemeinsame Instanz pro Datei und Modus, damit beide Services in dieselbe Kassette schreiben
+    static std::shared_ptr<Cassette> shared(const std::string& filename, Mode mode, bool originalTiming);
+
+    Cassette(const std::string& filename, Mode mode, bool originalTiming);
+
+    Cassette(const Cassette&) = delete;
+    Cassette& operator=(const Cassette&) = delete;
+
+    Mode mode() const { return mode_; }
+    bool originalTiming() const { return originalTiming_; }
+    const std::string& filename() const { return filename_; }
+
+    void record(const HttpClient::Request& request, const HttpClient::Response& response);
+
+    // Nchste aufgezeichnete Antwort fr diesen Request; gleiche Requests werden der Reihe nach
+    // beantwortet, danach wiederholt sich die letzte Antwort. elapsed enthlt die Originallatenz.
+    std::optional<HttpClient::Response> replay(const HttpClient::Request& request);
+
+    size_t size() const;
+
+private:
+    struct Track {
+        std::vector<HttpClient::Response> responses;
+        size_t next = 0;
+    };
+
+    static std::string keyFor(const HttpClient::Request& request);
+    void load();
+
+    std::string filename_;
+    Mode mode_;
+    bool originalTiming_;
+
+    mutable std::mutex mutex_;
+    std::ofstream out_;
+    std::unordered_map<std::string, Track> tracks_;
+    size_t count_ = 0;
+};
@@ -2,6 +2,8 @@
 #include <string>
 #include <fstream>
 #include <stdexcept>
+#include <algorithm>
+#include <map>
 #include <nlohmann/json.hpp>
 
 ConfigLoader::AppConfig ConfigLoader::loadConfig(const std::string& filename) {
@@ -38,6 +40,11 @@ ConfigLoader::AppConfig ConfigLoader::loadConfig(const std::string& filename) {
             }
         }
 
+        // Optionale Performance-Einstellungen (fehlende Werte behalten ihre Defaults)
+        if (j.contains("performance")) {
+            parsePerformance(j["performance"], config.performance);
+        }
+
         return config;
     }
     catch (const nlohmann::json::exception& e) {
@@ -45,6 +52,134 @@ ConfigLoader::AppConfig ConfigLoader::loadConfig(const std::string& filename) {
     }
 }
 
+void ConfigLoader::parsePerformance(const nlohmann::json& j, PerformanceConfig& performance) {
+    auto& http = performance.http;
+
+    if (j.contains("timeouts")) {
+        const auto& t = j["timeouts"];
+        http.timeouts.connectTimeoutMs = t.value("connect_ms", http.timeouts.connectTimeoutMs);
+        http.timeouts.requestTimeoutMs = t.value("request_ms", http.timeouts.requestTimeoutMs);
+        http.timeouts.importBudgetMs = t.value("import_budget_ms", http.timeouts.importBudgetMs);
+    }
+
+    if (j.contains("hedging")) {
+        const auto& h = j["hedging"];
+        http.hedging.enabled = h.value("enabled", http.hedging.enabled);
+        http.hedging.percentile = h.value("percentile", http.hedging.percentile);
+        http.hedging.minDelayMs = h.value("min_delay_ms", http.hedging.minDelayMs);
+        http.hedging.maxDelayMs = h.value("max_delay_ms", http.hedging.maxDelayMs);
+        http.hedging.minSamples = h.value("min_samples", http.hedging.minSamples);
+    }
+
+    if (j.contains("http2")) {
+        const auto& h2 = j["http2"];
+        http.http2.enabled = h2.value("enabled", http.http2.enabled);
+        http.http2.maxConcurrentStreams = h2.value("max_concurrent_streams", http.http2.maxConcurrentStreams);
+        http.http2.maxHostConnections = h2.value("max_host_connections", http.http2.maxHostConnections);
+    }
+
+    if (j.contains("retry")) {
+        const auto& r = j["retry"];
+        http.retry.maxAttempts = r.value("max_attempts", http.retry.maxAttempts);
+        http.retry.baseDelayMs = r.value("base_delay_ms", http.retry.baseDelayMs);
+        http.retry.maxDelayMs = r.value("max_delay_ms", http.retry.maxDelayMs);
+    }
+
+    if (j.contains("host_limits")) {
+        const auto& l = j["host_limits"];
+        http.hostLimits.defaultMaxInFlight = l.value("default_max_in_flight", http.hostLimits.defaultMaxInFlight);
+        if (l.contains("hosts")) {
+            http.hostLimits.perHost = l["hosts"].get<std::map<std::string, long>>();
+        }
+    }
+
+    if (j.contains("qos")) {
+        const auto& q = j["qos"];
+        http.qos.enabled = q.value("enabled", http.qos.enabled);
+        http.qos.agingMs = q.value("aging_ms", http.qos.agingMs);
+        http.qos.backgroundShare = std::clamp(q.value("background_share", http.qos.backgroundShare), 0.0, 1.0);
+    }
+
+    if (j.contains("cassette")) {
+        const auto& c = j["cassette"];
+        std::string mode = c.value("mode", "off");
+        if (mode == "record") http.cassette.mode = HttpClient::CassetteConfig::Mode::Record;
+        else if (mode == "replay") http.cassette.mode = HttpClient::CassetteConfig::Mode::Replay;
+        else http.cassette.mode = HttpClient::CassetteConfig::Mode::Off;
+        http.cassette.filename = c.value("file", http.cassette.filename);
+        http.cassette.originalTiming = c.value("original_timing", http.cassette.originalTiming);
+    }
+
+    if (j.contains("cache")) {
+        const auto& c = j["cache"];
+        performance.cache.trackCapacity = c.value("track_capacity", performance.cache.trackCapacity);
+        performance.cache.trackTtlHours = c.value("track_ttl_hours", performance.cache.trackTtlHours);
+        performance.cache.sharedMemory = c.value("shared_memory", performance.cache.sharedMemory);
+        performance.cache.sharedName = c.value("shared_name", performance.cache.sharedName);
+        performance.cache.sharedSlots = c.value("shared_slots", performance.cache.sharedSlots);
+        performance.cache.warmStartBundle = c.value("warm_start_bundle", performance.cache.warmStartBundle);
+    }
+
+    if (j.contains("workers")) {
+        const auto& w = j["workers"];
+        performance.workers.executorThreads = w.value("executor_threads", performance.workers.executorThreads);
+        performance.workers.importWorkers = w.value("import_workers", performance.workers.importWorkers);
+        performance.workers.fetchWorkers = w.value("fetch_workers", performance.workers.fetchWorkers);
+        performance.workers.parseWorkers = w.value("parse_workers", performance.workers.parseWorkers);
+        performance.workers.writeWorkers = w.value("write_workers", performance.workers.writeWorkers);
+        performance.workers.stageQueue = w.value("stage_queue", performance.workers.stageQueue);
+    }
+
+    if (j.contains("tokens")) {
+        const auto& t = j["tokens"];
+        performance.tokens.refreshLeadSeconds = t.value("refresh_lead_s", performance.tokens.refreshLeadSeconds);
+    }
+
+    if (j.contains("search")) {
+        const auto& s = j["search"];
+        performance.search.limit = std::clamp(s.value("limit", performance.search.limit), 1, 50);
+        performance.search.cascade = s.value("cascade", performance.search.cascade);
+    }
+
+    if (j.contains("stats")) {
+        const auto& s = j["stats"];
+        performance.stats.printAfterImport = s.value("print_after_import", performance.stats.printAfterImport);
+    }
+
+    if (j.contains("warming")) {
+        const auto& w = j["warming"];
+        auto& warming = performance.warming;
+        warming.enabled = w.value("enabled", warming.enabled);
+        warming.artists = w.value("artists", warming.artists);
+        warming.setlistsPerArtist = std::clamp<size_t>(w.value("setlists_per_artist", warming.setlistsPerArtist), 1, 20);
+        warming.requestsPerHour = std::max(0L, w.value("requests_per_hour", warming.requestsPerHour));
+        warming.quietSeconds = std::max(0L, w.value("quiet_s", warming.quietSeconds));
+        warming.refreshHours = std::max(1L, w.value("refresh_hours", warming.refreshHours));
+    }
+
+    performance.hotReload = j.value("hot_reload", performance.hotReload);
+}
+
+unsigned short ConfigLoader::callbackPort(const std::string& redirectUri, unsigned short fallback) {
+    // Schema berspringen, dann folgt nach dem Host optional ":Port"
+    size_t begin = redirectUri.find("://");
+    begin = (begin == std::string::npos) ? 0 : begin + 3;
+    size_t end = redirectUri.find('/', begin);
+    std::string authority = redirectUri.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+    auto colon = authority.rfind(':');
+    if (colon == std::string::npos || authority.find(']', colon) != std::string::npos) {
+        return fallback;
+    }
+    try {
+        int port = std::stoi(authority.substr(colon + 1));
+        if (port > 0 && port <= 65535) return static_cast<unsigned short>(port);
+    }
+    catch (const std::exception&) {
+    }
+    return fallback;
+}
+
 void ConfigLoader::createDefaultConfig(const std::string& filename) {
     nlohmann::json j;
     j["spotify"]["client_id"] = "YOUR_CLIENT_ID";
@@ -52,6 +187,55 @@ void ConfigLoader::createDefaultConfig(const std::string& filename) {
     j["spotify"]["redirect_uri"] = "http://localhost:8080";
     j["setlistfm"]["api_key"] = "YOUR_SETLIST_FM_API_KEY";
 
+    HttpClient::Options http;
+    j["performance"]["timeouts"]["connect_ms"] = http.timeouts.connectTimeoutMs;
+    j["performance"]["timeouts"]["request_ms"] = http.timeouts.requestTimeoutMs;
+    j["performance"]["timeouts"]["import_budget_ms"] = http.timeouts.importBudgetMs;
+    j["performance"]["hedging"]["enabled"] = http.hedging.enabled;
+    j["performance"]["hedging"]["percentile"] = http.hedging.percentile;
+    j["performance"]["hedging"]["min_delay_ms"] = http.hedging.minDelayMs;
+    j["performance"]["hedging"]["max_delay_ms"] = http.hedging.maxDelayMs;
+    j["performance"]["hedging"]["min_samples"] = http.hedging.minSamples;
+    j["performance"]["http2"]["enabled"] = http.http2.enabled;
+    j["performance"]["http2"]["max_concurrent_streams"] = http.http2.maxConcurrentStreams;
+    j["performance"]["http2"]["max_host_connections"] = http.http2.maxHostConnections;
+    j["performance"]["retry"]["max_attempts"] = http.retry.maxAttempts;
+    j["performance"]["retry"]["base_delay_ms"] = http.retry.baseDelayMs;
+    j["performance"]["retry"]["max_delay_ms"] = http.retry.maxDelayMs;
+    j["performance"]["host_limits"]["default_max_in_flight"] = http.hostLimits.defaultMaxInFlight;
+    j["performance"]["host_limits"]["hosts"] = nlohmann::json::object();
+    j["performance"]["qos"]["enabled"] = http.qos.enabled;
+    j["performance"]["qos"]["aging_ms"] = http.qos.agingMs;
+    j["performance"]["qos"]["background_share"] = http.qos.backgroundShare;
+    j["performance"]["cassette"]["mode"] = "off";
+    j["performance"]["cassette"]["file"] = http.cassette.filename;
+    j["performance"]["cassette"]["original_timing"] = http.cassette.originalTiming;
+
+    PerformanceConfig performance;
+    j["performance"]["cache"]["track_capacity"] = performance.cache.trackCapacity;
+    j["performance"]["cache"]["track_ttl_hours"] = performance.cache.trackTtlHours;
+    j["performance"]["cache"]["shared_memory"] = performance.cache.sharedMemory;
+    j["performance"]["cache"]["shared_name"] = performance.cache.sharedName;
+    j["performance"]["cache"]["shared_slots"] = performance.cache.sharedSlots;
+    j["performance"]["cache"]["warm_start_bundle"] = performance.cache.warmStartBundle;
+    j["performance"]["workers"]["executor_threads"] = performance.workers.executorThreads;
+    j["performance"]["workers"]["import_workers"] = performance.workers.importWorkers;
+    j["performance"]["workers"]["fetch_workers"] = performance.workers.fetchWorkers;
+    j["performance"]["workers"]["parse_workers"] = performance.workers.parseWorkers;
+    j["performance"]["workers"]["write_workers"] = performance.workers.writeWorkers;
+    j["performance"]["workers"]["stage_queue"] = performance.workers.stageQueue;
+    j["performance"]["tokens"]["refresh_lead_s"] = performance.tokens.refreshLeadSeconds;
+    j["performance"]["search"]["limit"] = performance.search.limit;
+    j["performance"]["search"]["cascade"] = performance.search.cascade;
+    j["performance"]["stats"]["print_after_import"] = performance.stats.printAfterImport;
+    j["performance"]["warming"]["enabled"] = performance.warming.enabled;
+    j["performance"]["warming"]["artists"] = nlohmann::json::array();
+    j["performance"]["warming"]["setlists_per_artist"] = performance.warming.setlistsPerArtist;
+    j["performance"]["warming"]["requests_per_hour"] = performance.warming.requestsPerHour;
+    j["performance"]["warming"]["quiet_s"] = performance.warming.quietSeconds;
+    j["performance"]["warming"]["refresh_hours"] = performance.warming.refreshHours;
+    j["performance"]["hot_reload"] = performance.hotReload;
+
     std::ofstream file(filename);
     if (!file.is_open()) {
         throw std::runtime_error("Could not create config file: " + filename);
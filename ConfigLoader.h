@@ -1,8 +1,10 @@
 #pragma once
 #include <string>
+#include <vector>
 #include <fstream>
 #include <stdexcept>
 #include <nlohmann/json.hpp>
+#include "HttpClient.h"
 
 class ConfigLoader {
 public:
@@ -16,11 +18,75 @@ public:
         std::string api_key;
     };
 
+    struct CacheConfig {
+        size_t trackCapacity = 50000;
+        long trackTtlHours = 24 * 30;
+        bool sharedMemory = true;       // Suchergebnisse mit den anderen Prozessen des Rechners teilen
+        std::string sharedName = "setlist_spotify_tracks";
+        size_t sharedSlots = 65536;     // Nur beim Anlegen des Segments wirksam
+        std::string warmStartBundle;    // CacheBundle, das beim Start bernommen wird (leer = keins)
+    };
+
+    // Werden nur beim Start gelesen
+    struct WorkerConfig {
+        size_t executorThreads = 0;     // 0 = Anzahl der Kerne
+        size_t importWorkers = 4;       // Nur Job-Server: Stufe resolve (Track-Suche) der Import-Pipeline
+        size_t fetchWorkers = 2;        // Weitere Stufen der Pipeline (siehe ImportJobManager)
+        size_t parseWorkers = 1;
+        size_t writeWorkers = 2;
+        size_t stageQueue = 16;         // Kapazitt der Warteschlangen zwischen den Stufen
+    };
+
+    struct TokenConfig {
+        long refreshLeadSeconds = 300;  // So lange vor Ablauf wird ein Token erneuert
+    };
+
+    struct SearchConfig {
+        int limit = 1;                  // Kandidaten pro Track-Suche
+        bool cascade = false;           // Gelockerte Suchvarianten parallel zur strikten Suche
+    };
+
+    struct StatsConfig {
+        bool printAfterImport = false;  // Latenz-, Hedge- und Wiederholungsstatistik nach jedem Import
+    };
+
+    // Vorwrmen der Caches in ruhigen Phasen (siehe CacheWarmer)
+    struct WarmingConfig {
+        bool enabled = false;
+        std::vector<std::string> artists;   // Beobachtete Knstler
+        size_t setlistsPerArtist = 5;       // Jngste Setlists, aus denen die Songs kommen
+        long requestsPerHour = 200;         // Budget des Warmers ber beide APIs
+        long quietSeconds = 120;            // So lange ohne Benutzer-Requests gilt als ruhig
+        long refreshHours = 6;              // Setlists eines Knstlers hchstens so oft neu holen
+    };
+
+    /// <summary>
+    /// Abschnitt "performance" der Konfiguration. Bis auf die Worker-Anzahlen werden
+    /// nderungen zur Laufzeit bernommen (siehe ConfigWatcher).
+    /// </summary>
+    struct PerformanceConfig {
+        HttpClient::Options http;
+        CacheConfig cache;
+        WorkerConfig workers;
+        TokenConfig tokens;
+        SearchConfig search;
+        StatsConfig stats;
+        WarmingConfig warming;
+        bool hotReload = true;
+    };
+
     struct AppConfig {
         SpotifyConfig spotify;
         SetlistFmConfig setlistfm;
+        PerformanceConfig performance;
     };
 
     static AppConfig loadConfig(const std::string& filename);
     static void createDefaultConfig(const std::string& filename);
+
+    // Port aus der Redirect-URI, z.B. 8080 fr "http://localhost:8080/callback"
+    static unsigned short callbackPort(const std::string& redirectUri, unsigned short fallback = 8080);
+
+    // berschreibt nur die Werte, die im Abschnitt "performance" stehen (auch fr Simulations-Szenarien)
+    static void parsePerformance(const nlohmann::json& j, PerformanceConfig& performance);
 };
\ No newline at end of file
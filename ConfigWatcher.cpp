@@ -0,0 +1,118 @@
+#include "ConfigWatcher.h"
+#include <iostream>
+#include <filesystem>
+#include <chrono>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    // Editoren schreiben oft in mehreren Schritten; erst nach dieser Ruhezeit neu laden
+    constexpr auto kDebounce = std::chrono::milliseconds(200);
+    constexpr auto kPollInterval = std::chrono::seconds(1);
+}
+
+ConfigWatcher::ConfigWatcher(std::string filename, ConfigLoader::PerformanceConfig initial, Callback onChange)
+    : filename_(std::move(filename)), onChange_(std::move(onChange)),
+    current_(std::make_shared<const ConfigLoader::PerformanceConfig>(std::move(initial))) {
+    std::error_code error;
+    lastWrite_ = std::filesystem::last_write_time(filename_, error);
+#ifdef __linux__
+    // Das Verzeichnis beobachten: beim Ersetzen per Rename wre eine berwachung der Datei verloren
+    inotifyFd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotifyFd_ >= 0) {
+        auto directory = std::filesystem::path(filename_).parent_path();
+        std::string watched = directory.empty() ? "." : directory.string();
+        if (inotify_add_watch(inotifyFd_, watched.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE) < 0) {
+            close(inotifyFd_);
+            inotifyFd_ = -1;
+        }
+    }
+    if (inotifyFd_ < 0) {
+        std::cerr << "inotify nicht verfgbar, prfe " << filename_ << " regelmig auf nderungen." << std::endl;
+    }
+#endif
+    thread_ = std::thread([this]() { run(); });
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = true;
+    }
+    stopCv_.notify_all();
+    thread_.join();
+#ifdef __linux__
+    if (inotifyFd_ >= 0) close(inotifyFd_);
+#endif
+}
+
+bool ConfigWatcher::reload() {
+    try {
+        auto config = ConfigLoader::loadConfig(filename_);
+        auto performance = std::make_shared<const ConfigLoader::PerformanceConfig>(config.performance);
+        current_.store(performance);
+        onChange_(*performance);
+        std::cout << "Performance-Einstellungen aus " << filename_ << " neu geladen." << std::endl;
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Konfiguration nicht bernommen, bisherige Werte bleiben aktiv: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+void ConfigWatcher::run() {
+    while (!stopping_) {
+        if (!waitForChange()) continue;
+
+        // Ruhezeit abwarten, damit halb geschriebene Dateien nicht gelesen werden
+        std::unique_lock<std::mutex> lock(stopMutex_);
+        if (stopCv_.wait_for(lock, kDebounce, [this]() { return stopping_.load(); })) break;
+        lock.unlock();
+
+#ifdef __linux__
+        // Whrend der Ruhezeit aufgelaufene Ereignisse gehren zur selben nderung
+        if (inotifyFd_ >= 0) {
+            char buffer[4096];
+            while (read(inotifyFd_, buffer, sizeof(buffer)) > 0) {
+            }
+        }
+#endif
+        reload();
+    }
+}
+
+bool ConfigWatcher::waitForChange() {
+#ifdef __linux__
+    if (inotifyFd_ >= 0) {
+        // Kurzes Poll-Intervall, damit der Destruktor nicht lange warten muss
+        pollfd fd{ inotifyFd_, POLLIN, 0 };
+        if (poll(&fd, 1, 250) <= 0) return false;
+
+        alignas(inotify_event) char buffer[4096];
+        ssize_t length = read(inotifyFd_, buffer, sizeof(buffer));
+        std::string name = std::filesystem::path(filename_).filename().string();
+        bool changed = false;
+        for (ssize_t offset = 0; offset < length;) {
+            auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && name == event->name) changed = true;
+            offset += sizeof(inotify_event) + event->len;
+        }
+        return changed;
+    }
+#endif
+
+    // Rckfallebene (z.B. unter Windows): nderungszeitpunkt vergleichen
+    std::unique_lock<std::mutex> lock(stopMutex_);
+    stopCv_.wait_for(lock, kPollInterval, [this]() { return stopping_.load(); });
+    lock.unlock();
+
+    std::error_code error;
+    auto lastWrite = std::filesystem::last_write_time(filename_, error);
+    if (error || lastWrite == lastWrite_) return false;
+    lastWrite_ = lastWrite;
+    return true;
+}
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <filesystem>
+#include "ConfigLoader.h"
+
+/// <summary>
+/// Beobachtet die Konfigurationsdatei und ldt den Abschnitt "performance" bei nderungen neu.
+/// Unter Linux per inotify auf dem Verzeichnis (erkennt auch Write-then-Rename), sonst durch
+/// Abfragen des nderungszeitpunkts. Eine ungltige Datei lsst die bisherigen Werte in Kraft.
+/// </summary>
+class ConfigWatcher {
+public:
+    using Callback = std::function<void(const ConfigLoader::PerformanceConfig&)>;
+
+    ConfigWatcher(std::string filename, ConfigLoader::PerformanceConfig initial, Callback onChange);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    // Zuletzt erfolgreich geladene Einstellungen
+    std::shared_ptr<const ConfigLoader::PerformanceConfig> current() const { return current_.load(); }
+
+    // Liest die Datei sofort neu; false, wenn sie ungltig ist
+    bool reload();
+
+private:
+    void run();
+    bool waitForChange();
+
+    std::string filename_;
+    Callback onChange_;
+    std::atomic<std::shared_ptr<const ConfigLoader::PerformanceConfig>> current_;
+
+    std::mutex stopMutex_;
+    std::condition_variable stopCv_;
+    std::atomic<bool> stopping_{ false };
+    int inotifyFd_ = -1;
+    std::filesystem::file_time_type lastWrite_;     // Nur ohne inotify
+    std::thread thread_;
+};
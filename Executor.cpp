@@ -0,0 +1,162 @@
+#include "Executor.h"
+#include <iostream>
+
+namespace {
+    std::atomic<size_t> configuredThreadCount{ 0 };
+}
+
+thread_local Executor* Executor::currentExecutor_ = nullptr;
+thread_local size_t Executor::currentIndex_ = 0;
+
+Executor::Executor(size_t threadCount) {
+    threadCount = std::max<size_t>(threadCount, 1);
+    for (size_t i = 0; i < threadCount; i++) {
+        workers_.push_back(std::make_unique<Worker>());
+    }
+    for (size_t i = 0; i < threadCount; i++) {
+        threads_.emplace_back([this, i]() { workerLoop(i); });
+    }
+}
+
+Executor::~Executor() {
+    shutdown();
+}
+
+Executor& Executor::instance() {
+    static Executor executor(configuredThreadCount ? configuredThreadCount.load() : defaultThreadCount());
+    return executor;
+}
+
+void Executor::configure(size_t threadCount) {
+    configuredThreadCount = threadCount;
+}
+
+size_t Executor::defaultThreadCount() {
+    // Mindestens zwei, damit lange Aufgaben (z.B. der Callback-Server) nicht alles blockieren
+    return std::max<size_t>(2, std::thread::hardware_concurrency());
+}
+
+bool Executor::post(Task task) {
+    if (isWorkerThread()) {
+        // Eigene Deque: kein globaler Lock, gute Cache-Lokalitt
+        auto& worker = *workers_[currentIndex_];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        pending_++;
+        worker.tasks.push_back(std::move(task));
+    }
+    else {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        // Beim Beenden kommen noch spte OAuth-Redirects oder Token-Refreshes von I/O- und
+        // cURL-Threads an; eine Exception wrde dort den Prozess beenden
+        if (stopping_) return false;
+        pending_++;
+        injectQueue_.push_back(std::move(task));
+    }
+
+    {
+        // Sperre kurz halten, damit kein Worker die Benachrichtigung verpasst
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    sleepCv_.notify_one();
+    return true;
+}
+
+void Executor::shutdown() {
+    std::lock_guard<std::mutex> shutdownLock(shutdownMutex_);
+    if (threads_.empty()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        stopping_ = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    sleepCv_.notify_all();
+
+    for (auto& thread : threads_) {
+        if (thread.get_id() == std::this_thread::get_id()) {
+            // Shutdown aus einer Aufgabe heraus: dieser Worker beendet sich selbst
+            thread.detach();
+        }
+        else {
+            thread.join();
+        }
+    }
+    threads_.clear();
+}
+
+bool Executor::isWorkerThread() const {
+    return currentExecutor_ == this;
+}
+
+bool Executor::tryRunOne() {
+    Task task;
+    if (!tryTake(task)) return false;
+
+    try {
+        task();
+    }
+    catch (const std::exception& e) {
+        // ber submit/then eingereichte Aufgaben fangen ihre Exceptions selbst
+        std::cerr << "Unbehandelte Exception in Hintergrundaufgabe: " << e.what() << std::endl;
+    }
+    return true;
+}
+
+bool Executor::tryTake(Task& task) {
+    size_t count = workers_.size();
+    size_t self = isWorkerThread() ? currentIndex_ : 0;
+
+    // 1. Eigene Deque von hinten
+    if (isWorkerThread()) {
+        auto& worker = *workers_[self];
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        if (!worker.tasks.empty()) {
+            task = std::move(worker.tasks.back());
+            worker.tasks.pop_back();
+            pending_--;
+            return true;
+        }
+    }
+
+    // 2. Eingangswarteschlange
+    {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        if (!injectQueue_.empty()) {
+            task = std::move(injectQueue_.front());
+            injectQueue_.pop_front();
+            pending_--;
+            return true;
+        }
+    }
+
+    // 3. Bei den anderen Workern vorne stehlen
+    for (size_t offset = 1; offset < count; offset++) {
+        auto& victim = *workers_[(self + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            pending_--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Executor::workerLoop(size_t index) {
+    currentExecutor_ = this;
+    currentIndex_ = index;
+
+    while (true) {
+        if (tryRunOne()) continue;
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepCv_.wait(lock, [this]() { return stopping_ || pending_ > 0; });
+
+        // Beim Beenden erst alle ausstehenden Aufgaben abarbeiten
+        if (stopping_ && pending_ == 0) return;
+    }
+}
@@ -0,0 +1,187 @@
+#pragma once
+#include <vector>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <future>
+#include <functional>
+#include <condition_variable>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>
+
+/// <summary>
+/// Prozessweiter Thread-Pool mit Work-Stealing. Jeder Worker hat eine eigene Deque:
+/// Aufgaben, die ein Worker selbst einreicht, landen hinten in seiner Deque und werden
+/// von dort (LIFO) abgearbeitet, unttige Worker stehlen vorne (FIFO) bei den anderen.
+/// Aufgaben von auen kommen in eine gemeinsame Eingangswarteschlange.
+/// </summary>
+class Executor {
+public:
+    using Task = std::function<void()>;
+
+    explicit Executor(size_t threadCount = defaultThreadCount());
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    // Gemeinsame Instanz fr die ganze Anwendung
+    static Executor& instance();
+    static size_t defaultThreadCount();
+    // Gre der gemeinsamen Instanz (0 = Standard); nur vor dem ersten instance() wirksam
+    static void configure(size_t threadCount);
+
+    // Fhrt eine Aufgabe aus; Ergebnis oder Exception ber das Future. Nach shutdown() wird die
+    // Aufgabe verworfen und das Future meldet std::future_error (broken_promise)
+    template <typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>>;
+
+    // Fhrt nach der Aufgabe die Fortsetzung aus; sie bekommt das Future der Aufgabe
+    template <typename F, typename C>
+    auto then(F&& task, C&& continuation)
+        -> std::future<std::invoke_result_t<std::decay_t<C>, std::future<std::invoke_result_t<std::decay_t<F>>>>>;
+
+    // Ruft fn(i) fr alle i in [0, count) auf und wartet auf das Ende
+    template <typename F>
+    void parallelFor(size_t count, F&& fn);
+
+    // Wartet auf ein Future; auf Worker-Threads werden solange andere Aufgaben abgearbeitet
+    template <typename T>
+    T wait(std::future<T>& future);
+
+    // Nach shutdown() nimmt der Executor von auen nichts mehr an: dann false, die Aufgabe wird
+    // verworfen. Aufrufer, die auf die Aufgabe warten, mssen das selbst auflsen.
+    bool post(Task task);
+
+    // Nimmt keine neuen Aufgaben von auen mehr an, arbeitet die Warteschlangen ab und beendet die Worker
+    void shutdown();
+
+    size_t threadCount() const { return threads_.size(); }
+
+private:
+    struct Worker {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    template <typename R, typename Fn>
+    static void fulfil(std::promise<R>& promise, Fn& fn);
+
+    bool isWorkerThread() const;
+    bool tryRunOne();
+    bool tryTake(Task& task);
+    void workerLoop(size_t index);
+
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::vector<std::thread> threads_;
+
+    std::mutex injectMutex_;
+    std::deque<Task> injectQueue_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCv_;
+    std::atomic<size_t> pending_{ 0 };
+    std::atomic<bool> stopping_{ false };
+    std::mutex shutdownMutex_;
+
+    static thread_local Executor* currentExecutor_;
+    static thread_local size_t currentIndex_;
+};
+
+template <typename R, typename Fn>
+void Executor::fulfil(std::promise<R>& promise, Fn& fn) {
+    try {
+        if constexpr (std::is_void_v<R>) {
+            fn();
+            promise.set_value();
+        }
+        else {
+            promise.set_value(fn());
+        }
+    }
+    catch (...) {
+        promise.set_exception(std::current_exception());
+    }
+}
+
+template <typename F>
+auto Executor::submit(F&& task) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    using R = std::invoke_result_t<std::decay_t<F>>;
+
+    auto promise = std::make_shared<std::promise<R>>();
+    auto future = promise->get_future();
+    auto fn = std::make_shared<std::decay_t<F>>(std::forward<F>(task));
+
+    post([promise, fn]() { fulfil(*promise, *fn); });
+    return future;
+}
+
+template <typename F, typename C>
+auto Executor::then(F&& task, C&& continuation)
+    -> std::future<std::invoke_result_t<std::decay_t<C>, std::future<std::invoke_result_t<std::decay_t<F>>>>> {
+    using T = std::invoke_result_t<std::decay_t<F>>;
+    using R = std::invoke_result_t<std::decay_t<C>, std::future<T>>;
+
+    auto promise = std::make_shared<std::promise<R>>();
+    auto future = promise->get_future();
+    auto fn = std::make_shared<std::decay_t<F>>(std::forward<F>(task));
+    auto next = std::make_shared<std::decay_t<C>>(std::forward<C>(continuation));
+
+    post([this, promise, fn, next]() {
+        auto first = std::make_shared<std::promise<T>>();
+        fulfil(*first, *fn);
+
+        // Fortsetzung als eigene Aufgabe, damit andere Worker sie bernehmen knnen
+        post([promise, next, first]() {
+            auto call = [&]() { return (*next)(first->get_future()); };
+            fulfil(*promise, call);
+            });
+        });
+    return future;
+}
+
+template <typename F>
+void Executor::parallelFor(size_t count, F&& fn) {
+    if (count == 0) return;
+
+    // Einige Blcke pro Worker, damit sich ungleich teure Elemente ausgleichen
+    size_t chunks = std::min(count, std::max<size_t>(1, threadCount() * 4));
+    size_t chunkSize = (count + chunks - 1) / chunks;
+
+    std::vector<std::future<void>> futures;
+    for (size_t begin = 0; begin < count; begin += chunkSize) {
+        size_t end = std::min(count, begin + chunkSize);
+        futures.push_back(submit([&fn, begin, end]() {
+            for (size_t i = begin; i < end; i++) {
+                fn(i);
+            }
+            }));
+    }
+
+    // Erst auf alle warten, dann die erste Exception weitergeben
+    std::exception_ptr error;
+    for (auto& future : futures) {
+        try {
+            wait(future);
+        }
+        catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+    if (error) std::rethrow_exception(error);
+}
+
+template <typename T>
+T Executor::wait(std::future<T>& future) {
+    if (isWorkerThread()) {
+        // Nicht blockieren: sonst warten im schlimmsten Fall alle Worker aufeinander
+        while (future.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            if (!tryRunOne()) {
+                future.wait_for(std::chrono::milliseconds(1));
+            }
+        }
+    }
+    return future.get();
+}
@@ -0,0 +1,1504 @@
+#include "HttpClient.h"
+#include "Cassette.h"
+#include <algorithm>
+#include <memory>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <random>
+#include <cctype>
+#include <curl/curl.h>
+
+namespace {
+    // Deadline des aktuellen Threads (gesetzt ber DeadlineScope)
+    thread_local std::optional<std::chrono::steady_clock::time_point> t_deadline;
+    // Priorittsklasse des aktuellen Threads (gesetzt ber PriorityScope)
+    thread_local HttpClient::Priority t_priority = HttpClient::Priority::Normal;
+    // Abbruch-Token des aktuellen Threads (gesetzt ber CancellationScope)
+    thread_local CancellationToken t_cancel;
+    // Request-Zhler des aktuellen Threads (gesetzt ber RequestCountScope)
+    thread_local std::shared_ptr<std::atomic<uint64_t>> t_counter;
+
+    // Callback-Funktion fr cURL
+    size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
+        size_t newLength = size * nmemb;
+        try {
+            s->append((char*)contents, newLength);
+            return newLength;
+        }
+        catch (std::bad_alloc&) {
+            return 0;
+        }
+    }
+
+    // Sammelt die Antwort-Header; bei Weiterleitungen zhlen nur die der letzten Antwort
+    size_t HeaderCallback(char* buffer, size_t size, size_t nitems, std::map<std::string, std::string>* headers) {
+        size_t length = size * nitems;
+        std::string line(buffer, length);
+        if (line.rfind("HTTP/", 0) == 0) {
+            headers->clear();
+            return length;
+        }
+
+        auto colon = line.find(':');
+        if (colon == std::string::npos) return length;
+
+        std::string name = line.substr(0, colon);
+        std::transform(name.begin(), name.end(), name.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        size_t begin = line.find_first_not_of(" \t", colon + 1);
+        size_t end = line.find_last_not_of(" \t\r\n");
+        (*headers)[name] = (begin == std::string::npos || end < begin) ? "" : line.substr(begin, end - begin + 1);
+        return length;
+    }
+
+    // Bricht einen laufenden Transfer ab, sobald sein Token abgebrochen wird. cURL ruft das
+    // mindestens einmal pro Sekunde auf, bei Datenverkehr deutlich fter.
+    int ProgressCallback(void* clientp, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        return static_cast<const CancellationToken*>(clientp)->cancelled() ? 1 : 0;
+    }
+
+    HttpClient::Response cancelledResponse() {
+        HttpClient::Response response;
+        response.cancelled = true;
+        response.error = "Abgebrochen";
+        return response;
+    }
+
+    // Wartet hchstens delay; false, wenn das Token whrenddessen abgebrochen wird
+    bool sleepUnlessCancelled(std::chrono::milliseconds delay, const CancellationToken& cancel) {
+        auto until = std::chrono::steady_clock::now() + delay;
+        while (!cancel.cancelled()) {
+            auto now = std::chrono::steady_clock::now();
+            if (now >= until) return true;
+            std::this_thread::sleep_for(std::min<std::chrono::steady_clock::duration>(
+                until - now, std::chrono::milliseconds(50)));
+        }
+        return false;
+    }
+
+    // Host einer URL ohne Schema, Port und Pfad, z.B. "api.spotify.com"
+    std::string hostOf(const std::string& url) {
+        size_t begin = url.find("://");
+        begin = (begin == std::string::npos) ? 0 : begin + 3;
+        size_t end = url.find_first_of("/?#", begin);
+        std::string authority = url.substr(begin, end == std::string::npos ? std::string::npos : end - begin);
+
+        auto at = authority.rfind('@');
+        if (at != std::string::npos) authority.erase(0, at + 1);
+        auto colon = authority.rfind(':');
+        if (colon != std::string::npos && authority.find(']', colon) == std::string::npos) {
+            authority.erase(colon);
+        }
+        std::transform(authority.begin(), authority.end(), authority.begin(),
+            [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return authority;
+    }
+
+    long hostLimit(const HttpClient::Options& options, const std::string& host) {
+        auto it = options.hostLimits.perHost.find(host);
+        return it != options.hostLimits.perHost.end() ? it->second : options.hostLimits.defaultMaxInFlight;
+    }
+
+    struct Transfer {
+        CURL* curl = nullptr;
+        curl_slist* headers = nullptr;
+        std::string response;
+        std::map<std::string, std::string> responseHeaders;
+        CancellationToken cancel;       // Lebt so lange wie der Transfer, cURL hlt einen Zeiger darauf
+        bool attached = false;          // Hngt an einem Multi-Handle
+        std::function<void(CURL*)> recycle;     // Gibt das Handle samt Verbindung zurck, statt es zu schlieen
+
+        ~Transfer() {
+            if (headers) curl_slist_free_all(headers);
+            if (!curl) return;
+            if (recycle && !attached) {
+                recycle(curl);
+            }
+            else {
+                curl_easy_cleanup(curl);
+            }
+        }
+    };
+
+    // handle: wiederverwendetes Easy-Handle (nach curl_easy_reset), sonst ein neues
+    std::unique_ptr<Transfer> createTransfer(const HttpClient::Request& request,
+        const HttpClient::Options& options, long timeoutMs, const CancellationToken& cancel,
+        CURLSH* share = nullptr, CURL* handle = nullptr) {
+        const auto& timeouts = options.timeouts;
+        auto transfer = std::make_unique<Transfer>();
+        transfer->curl = handle ? handle : curl_easy_init();
+        if (!transfer->curl) return nullptr;
+
+        CURL* curl = transfer->curl;
+        curl_easy_setopt(curl, CURLOPT_URL, request.url.c_str());
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->response);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, HeaderCallback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &transfer->responseHeaders);
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        if (cancel.cancellable()) {
+            transfer->cancel = cancel;
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, ProgressCallback);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, &transfer->cancel);
+        }
+        if (share) {
+            curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        }
+
+        // Timeouts: Verbindungsaufbau und gesamter Request
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, std::min(timeouts.connectTimeoutMs, timeoutMs));
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMs);
+
+        if (options.http2.enabled) {
+            // HTTP/2 per ALPN; PIPEWAIT wartet auf einen freien Stream statt eine neue Verbindung zu ffnen
+            curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+            curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        }
+
+        // HTTP-Methode setzen
+        if (request.method == "POST") {
+            curl_easy_setopt(curl, CURLOPT_POST, 1L);
+        }
+        else if (request.method == "HEAD") {
+            curl_easy_setopt(curl, CURLOPT_NOBODY, 1L);
+        }
+        else if (request.method != "GET") {
+            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, request.method.c_str());
+        }
+
+        if ((request.method != "GET" && request.method != "HEAD") || !request.body.empty()) {
+            // Kopieren: asynchrone Transfers leben lnger als der Request
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(request.body.size()));
+            curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, request.body.c_str());
+        }
+
+        for (const auto& header : request.headers) {
+            transfer->headers = curl_slist_append(transfer->headers, header.c_str());
+        }
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+
+        return transfer;
+    }
+
+    void fillResponse(Transfer& transfer, CURLcode res, HttpClient::Response& response) {
+        response.ok = (res == CURLE_OK);
+        response.timedOut = (res == CURLE_OPERATION_TIMEDOUT);
+        response.cancelled = (res == CURLE_ABORTED_BY_CALLBACK);
+        curl_easy_getinfo(transfer.curl, CURLINFO_RESPONSE_CODE, &response.status);
+        curl_easy_getinfo(transfer.curl, CURLINFO_NUM_CONNECTS, &response.newConnections);
+
+        long version = 0;
+        curl_easy_getinfo(transfer.curl, CURLINFO_HTTP_VERSION, &version);
+        response.httpVersion = (version == CURL_HTTP_VERSION_2_0) ? 20 : (version ? 11 : 0);
+        response.body = std::move(transfer.response);
+        response.headers = std::move(transfer.responseHeaders);
+        if (response.cancelled) {
+            response.error = "Abgebrochen";
+        }
+        else if (!response.ok) {
+            response.error = curl_easy_strerror(res);
+        }
+    }
+}
+
+/// <summary>
+/// Zhlt laufende Requests pro Host und begrenzt sie auf das konfigurierte Limit.
+/// Wartende Requests bekommen eine Marke; wird ein Platz frei, kommt der Wartende mit der
+/// hchsten Klasse zum Zug (bei gleicher Klasse der lteste). Jede agingMs gewartete Zeit
+/// hebt einen Wartenden um eine Klasse an, damit auch Hintergrund-Requests nicht verhungern.
+/// Hintergrund-Requests belegen hchstens backgroundShare des Limits; der Rest bleibt frei
+/// fr interaktive und normale Requests.
+/// </summary>
+class HttpClient::HostLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Reiht einen Request ein; ber tryAdmit() oder cancel() wieder austragen
+    uint64_t enqueue(const std::string& host, Priority priority) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uint64_t ticket = nextTicket_++;
+        hosts_[host].waiting.push_back({ ticket, priority, Clock::now() });
+        return ticket;
+    }
+
+    // Lsst den Request zu, wenn ein Platz frei ist und kein wichtigerer Request wartet
+    bool tryAdmit(const std::string& host, uint64_t ticket, long limit, const QosConfig& qos) {
+        bool admitted;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            admitted = admitLocked(host, ticket, limit, qos);
+        }
+        // Ein anderer Wartender kann jetzt der nchste sein
+        if (admitted) cv_.notify_all();
+        return admitted;
+    }
+
+    // Wartet hchstens bis until auf einen freien Platz; limit <= 0 heit unbegrenzt.
+    // Ein abgebrochener Request gibt seinen Platz in der Warteschlange sofort auf.
+    bool acquire(const std::string& host, Priority priority, long limit, const QosConfig& qos,
+        Clock::time_point until, const CancellationToken& cancel) {
+        uint64_t ticket = enqueue(host, priority);
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!admitLocked(host, ticket, limit, qos)) {
+            auto now = Clock::now();
+            if (now >= until || cancel.cancelled()) {
+                removeLocked(host, ticket);
+                lock.unlock();
+                cv_.notify_all();
+                return false;
+            }
+            // Nicht nur auf Freigaben warten: die Alterung ndert die Reihenfolge auch so
+            cv_.wait_until(lock, std::min(until, now + std::chrono::milliseconds(50)));
+        }
+        lock.unlock();
+        cv_.notify_all();
+        return true;
+    }
+
+    // Belegt sofort einen Platz oder keinen; wartende Requests mit Vorrang bleiben vorn
+    bool tryAcquire(const std::string& host, Priority priority, long limit, const QosConfig& qos) {
+        uint64_t ticket = enqueue(host, priority);
+        if (tryAdmit(host, ticket, limit, qos)) return true;
+        cancel(host, ticket);
+        return false;
+    }
+
+    void cancel(const std::string& host, uint64_t ticket) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            removeLocked(host, ticket);
+        }
+        cv_.notify_all();
+    }
+
+    void release(const std::string& host, Priority priority) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            auto it = hosts_.find(host);
+            if (it != hosts_.end()) {
+                it->second.inFlight--;
+                if (priority == Priority::Background) it->second.backgroundInFlight--;
+                if (it->second.inFlight <= 0 && it->second.waiting.empty()) hosts_.erase(it);
+            }
+        }
+        cv_.notify_all();
+    }
+
+private:
+    struct Host {
+        long inFlight = 0;
+        long backgroundInFlight = 0;
+        std::vector<Waiter> waiting;    // In Ankunftsreihenfolge
+    };
+
+    bool admitLocked(const std::string& host, uint64_t ticket, long limit, const QosConfig& qos) {
+        auto& state = hosts_[host];
+        size_t index;
+
+        if (limit <= 0) {
+            // Ohne Limit gibt es keine Reihenfolge
+            auto it = std::find_if(state.waiting.begin(), state.waiting.end(),
+                [ticket](const Waiter& waiter) { return waiter.ticket == ticket; });
+            if (it == state.waiting.end()) return false;
+            index = static_cast<size_t>(it - state.waiting.begin());
+        }
+        else {
+            auto next = nextAdmission(state.waiting, state.inFlight, state.backgroundInFlight, limit, qos, Clock::now());
+            if (!next || state.waiting[*next].ticket != ticket) return false;
+            index = *next;
+        }
+
+        state.inFlight++;
+        if (state.waiting[index].priority == Priority::Background) state.backgroundInFlight++;
+        state.waiting.erase(state.waiting.begin() + index);
+        return true;
+    }
+
+    void removeLocked(const std::string& host, uint64_t ticket) {
+        auto it = hosts_.find(host);
+        if (it == hosts_.end()) return;
+        auto& waiting = it->second.waiting;
+        waiting.erase(std::remove_if(waiting.begin(), waiting.end(),
+            [ticket](const Waiter& waiter) { return waiter.ticket == ticket; }), waiting.end());
+        if (it->second.inFlight <= 0 && waiting.empty()) hosts_.erase(it);
+    }
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::map<std::string, Host> hosts_;
+    uint64_t nextTicket_ = 1;
+};
+
+std::optional<size_t> HttpClient::nextAdmission(const std::vector<Waiter>& waiting, long inFlight,
+    long backgroundInFlight, long limit, const QosConfig& qos, std::chrono::steady_clock::time_point now) {
+    if (waiting.empty() || inFlight >= limit) return std::nullopt;
+    // Ohne QoS gilt FIFO
+    if (!qos.enabled) return 0;
+
+    // Klasse nach Alterung; 0 = interaktiv
+    auto rank = [&qos, now](const Waiter& waiter) {
+        int rank = static_cast<int>(waiter.priority);
+        if (qos.agingMs > 0) {
+            auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(now - waiter.since).count();
+            rank -= static_cast<int>(std::min<long long>(waited / qos.agingMs, rank));
+        }
+        return rank;
+    };
+
+    long backgroundLimit = std::max(1L, static_cast<long>(limit * qos.backgroundShare));
+    bool backgroundFull = backgroundInFlight >= backgroundLimit;
+    std::optional<size_t> best;
+    int bestRank = 0;
+    for (size_t i = 0; i < waiting.size(); i++) {
+        if (waiting[i].priority == Priority::Background && backgroundFull) continue;
+        int r = rank(waiting[i]);
+        if (!best || r < bestRank) {
+            best = i;
+            bestRank = r;
+        }
+    }
+    return best;
+}
+
+/// <summary>
+/// Ein Thread mit einem cURL-Multi-Handle, der beliebig viele asynchrone
+/// Requests gleichzeitig abwickelt. Requests ber dem Host-Limit warten in
+/// einer Warteschlange, bis der HostLimiter sie nach ihrer Klasse zulsst.
+/// </summary>
+class HttpClient::AsyncEngine {
+public:
+    explicit AsyncEngine(HttpClient& owner)
+        : owner_(owner), multi_(curl_multi_init()) {
+        applyMultiOptions();
+        thread_ = std::thread([this]() { run(); });
+    }
+
+    ~AsyncEngine() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        curl_multi_wakeup(multi_);
+        thread_.join();
+        curl_multi_cleanup(multi_);
+    }
+
+    void submit(const Request& request, const Options& options, long timeoutMs, Priority priority,
+        Completion completion) {
+        Pending pending;
+        pending.cancel = effectiveCancellation(request);
+        pending.transfer = createTransfer(request, options, timeoutMs, pending.cancel);
+        pending.completion = std::move(completion);
+        pending.host = hostOf(request.url);
+        pending.priority = priority;
+        pending.start = std::chrono::steady_clock::now();
+        pending.expires = pending.start + std::chrono::milliseconds(timeoutMs);
+
+        if (!pending.transfer) {
+            Response response;
+            response.error = "Konnte cURL nicht initialisieren";
+            pending.completion(std::move(response));
+            return;
+        }
+        // Schon beim Einreichen einreihen, damit die Wartezeit fr die Alterung zhlt
+        pending.ticket = owner_.limiter_->enqueue(pending.host, priority);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            incoming_.push_back(std::move(pending));
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+    // Stellt eine fertige Antwort (z.B. aus der Kassette) zum Zeitpunkt due im Engine-Thread zu
+    void schedule(Response response, std::chrono::steady_clock::time_point due, Completion completion) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            incomingTimers_.push_back({ due, std::move(response), std::move(completion), false, {} });
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+    // Ruft completion zum Zeitpunkt due im Engine-Thread auf (Wartezeit vor einer Wiederholung),
+    // nach einem Abbruch schon frher; endet die Engine vorher, bekommt completion eine Antwort mit Fehler
+    void scheduleRetry(std::chrono::steady_clock::time_point due, const CancellationToken& cancel,
+        Completion completion) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            incomingTimers_.push_back({ due, Response{}, std::move(completion), true, cancel });
+        }
+        curl_multi_wakeup(multi_);
+    }
+
+private:
+    struct Timer {
+        std::chrono::steady_clock::time_point due;
+        Response response;
+        Completion completion;
+        bool retry = false;
+        CancellationToken cancel;
+    };
+
+    struct Pending {
+        std::unique_ptr<Transfer> transfer;
+        Completion completion;
+        std::string host;
+        Priority priority = Priority::Normal;
+        CancellationToken cancel;
+        uint64_t ticket = 0;
+        std::chrono::steady_clock::time_point start;
+        std::chrono::steady_clock::time_point admitted;
+        std::chrono::steady_clock::time_point expires;
+    };
+
+    // bernimmt genderte Einstellungen; nur im Konstruktor und im Engine-Thread aufrufen
+    void applyMultiOptions() {
+        applied_ = owner_.options_.load();
+        const auto& http2 = applied_->http2;
+        // Alle Streams zu einem Host teilen sich eine Verbindung; die Flusskontrolle
+        // pro Stream bernimmt nghttp2 in cURL
+        curl_multi_setopt(multi_, CURLMOPT_PIPELINING, http2.enabled ? CURLPIPE_MULTIPLEX : CURLPIPE_NOTHING);
+        curl_multi_setopt(multi_, CURLMOPT_MAX_CONCURRENT_STREAMS, http2.enabled ? http2.maxConcurrentStreams : 100L);
+        curl_multi_setopt(multi_, CURLMOPT_MAX_HOST_CONNECTIONS, http2.enabled ? http2.maxHostConnections : 0L);
+    }
+
+    // Startet wartende Requests, sobald ihr Host wieder Platz hat; abgebrochene fliegen raus
+    void admit() {
+        auto now = std::chrono::steady_clock::now();
+        for (auto it = waiting_.begin(); it != waiting_.end();) {
+            if (it->cancel.cancelled()) {
+                owner_.limiter_->cancel(it->host, it->ticket);
+                Response response = cancelledResponse();
+                response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->start);
+                it->completion(std::move(response));
+                it = waiting_.erase(it);
+                continue;
+            }
+            if (now >= it->expires) {
+                owner_.limiter_->cancel(it->host, it->ticket);
+                Response response;
+                response.timedOut = true;
+                response.error = "Deadline berschritten (Host-Limit)";
+                response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - it->start);
+                it->completion(std::move(response));
+                it = waiting_.erase(it);
+                continue;
+            }
+            if (!owner_.limiter_->tryAdmit(it->host, it->ticket, hostLimit(*applied_, it->host), applied_->qos)) {
+                ++it;
+                continue;
+            }
+
+            it->admitted = now;
+            CURL* curl = it->transfer->curl;
+            curl_multi_add_handle(multi_, curl);
+            it->transfer->attached = true;
+            active_.emplace(curl, std::move(*it));
+            it = waiting_.erase(it);
+        }
+    }
+
+    // Beendet abgebrochene laufende Requests sofort, statt auf den nchsten Aufruf des
+    // Progress-Callbacks zu warten, und gibt ihren Platz im Host-Limit frei
+    void reapCancelled() {
+        for (auto it = active_.begin(); it != active_.end();) {
+            if (!it->second.cancel.cancelled()) {
+                ++it;
+                continue;
+            }
+            Pending pending = std::move(it->second);
+            it = active_.erase(it);
+            curl_multi_remove_handle(multi_, pending.transfer->curl);
+            pending.transfer->attached = false;
+            owner_.limiter_->release(pending.host, pending.priority);
+
+            Response response = cancelledResponse();
+            response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - pending.start);
+            response.queued = std::chrono::duration_cast<std::chrono::milliseconds>(
+                pending.admitted - pending.start);
+            pending.completion(std::move(response));
+        }
+    }
+
+    void run() {
+        while (true) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (stopping_) break;
+                for (auto& pending : incoming_) {
+                    waiting_.push_back(std::move(pending));
+                }
+                incoming_.clear();
+                for (auto& timer : incomingTimers_) {
+                    auto due = timer.due;
+                    timers_.emplace(due, std::move(timer));
+                }
+                incomingTimers_.clear();
+            }
+
+            // Fllige Antworten ohne Transfer zustellen, abgebrochene Wartezeiten sofort beenden
+            auto now = std::chrono::steady_clock::now();
+            for (auto it = timers_.begin(); it != timers_.end();) {
+                if (it->first > now && !it->second.cancel.cancelled()) {
+                    ++it;
+                    continue;
+                }
+                auto timer = std::move(it->second);
+                it = timers_.erase(it);
+                timer.completion(std::move(timer.response));
+            }
+
+            if (owner_.options_.load() != applied_) {
+                applyMultiOptions();
+            }
+            admit();
+
+            int running = 0;
+            curl_multi_perform(multi_, &running);
+
+            CURLMsg* msg = nullptr;
+            int queued = 0;
+            while ((msg = curl_multi_info_read(multi_, &queued))) {
+                if (msg->msg != CURLMSG_DONE) continue;
+
+                auto it = active_.find(msg->easy_handle);
+                if (it == active_.end()) continue;
+
+                CURLcode res = msg->data.result;
+                Pending pending = std::move(it->second);
+                active_.erase(it);
+                curl_multi_remove_handle(multi_, pending.transfer->curl);
+                pending.transfer->attached = false;
+                owner_.limiter_->release(pending.host, pending.priority);
+
+                Response response;
+                fillResponse(*pending.transfer, res, response);
+                response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::steady_clock::now() - pending.start);
+                response.queued = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    pending.admitted - pending.start);
+                pending.completion(std::move(response));
+            }
+
+            // Auch der Gewinner eines Hedge-Rennens bricht den Verlierer ber sein Token ab
+            reapCancelled();
+
+            // Wartet auf Socket-Aktivitt, cURL-Timeouts oder neue Requests (curl_multi_wakeup).
+            // Wartende Requests knnen auch durch blockierende Requests frei werden.
+            // Auch abbrechbare Wartezeiten vor Wiederholungen hufiger prfen
+            bool cancellableTimer = std::any_of(timers_.begin(), timers_.end(),
+                [](const auto& entry) { return entry.second.cancel.cancellable(); });
+            long waitMs = waiting_.empty() && !cancellableTimer ? 1000 : 20;
+            if (!timers_.empty()) {
+                auto untilDue = std::chrono::duration_cast<std::chrono::milliseconds>(
+                    timers_.begin()->first - std::chrono::steady_clock::now()).count();
+                waitMs = std::clamp<long>(static_cast<long>(untilDue), 0, waitMs);
+            }
+            curl_multi_poll(multi_, nullptr, 0, static_cast<int>(waitMs), nullptr);
+        }
+
+        // Beim Beenden alle offenen Requests mit Fehler abschlieen
+        auto abort = [](Pending& pending) {
+            Response response;
+            response.error = "Abgebrochen: HttpClient wird beendet";
+            pending.completion(std::move(response));
+        };
+        for (auto& [curl, pending] : active_) {
+            curl_multi_remove_handle(multi_, curl);
+            pending.transfer->attached = false;
+            owner_.limiter_->release(pending.host, pending.priority);
+            abort(pending);
+        }
+        active_.clear();
+        for (auto& pending : waiting_) {
+            owner_.limiter_->cancel(pending.host, pending.ticket);
+            abort(pending);
+        }
+        waiting_.clear();
+        for (auto& [due, timer] : timers_) {
+            if (timer.retry) timer.response.error = "Abgebrochen: HttpClient wird beendet";
+            timer.completion(std::move(timer.response));
+        }
+        timers_.clear();
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto& pending : incoming_) {
+            owner_.limiter_->cancel(pending.host, pending.ticket);
+            abort(pending);
+        }
+        incoming_.clear();
+        for (auto& timer : incomingTimers_) {
+            if (timer.retry) timer.response.error = "Abgebrochen: HttpClient wird beendet";
+            timer.completion(std::move(timer.response));
+        }
+        incomingTimers_.clear();
+    }
+
+    HttpClient& owner_;
+    CURLM* multi_;
+    std::thread thread_;
+
+    std::mutex mutex_;
+    std::vector<Pending> incoming_;
+    std::vector<Timer> incomingTimers_;
+    bool stopping_ = false;
+
+    // Nur im Engine-Thread verwendet
+    std::shared_ptr<const Options> applied_;
+    std::deque<Pending> waiting_;
+    std::map<CURL*, Pending> active_;
+    std::multimap<std::chrono::steady_clock::time_point, Timer> timers_;
+};
+
+HttpClient::DeadlineScope::DeadlineScope(std::chrono::milliseconds budget)
+    : previous_(t_deadline) {
+    auto deadline = std::chrono::steady_clock::now() + budget;
+    if (!t_deadline || deadline < *t_deadline) {
+        t_deadline = deadline;
+    }
+}
+
+HttpClient::DeadlineScope::~DeadlineScope() {
+    t_deadline = previous_;
+}
+
+std::optional<std::chrono::steady_clock::time_point> HttpClient::DeadlineScope::current() {
+    return t_deadline;
+}
+
+bool HttpClient::DeadlineScope::expired() {
+    return t_deadline && std::chrono::steady_clock::now() >= *t_deadline;
+}
+
+HttpClient::PriorityScope::PriorityScope(Priority priority)
+    : previous_(t_priority) {
+    t_priority = priority;
+}
+
+HttpClient::PriorityScope::~PriorityScope() {
+    t_priority = previous_;
+}
+
+HttpClient::Priority HttpClient::PriorityScope::current() {
+    return t_priority;
+}
+
+HttpClient::CancellationScope::CancellationScope(const CancellationToken& token)
+    : previous_(t_cancel) {
+    if (token.cancellable()) {
+        t_cancel = token;
+    }
+}
+
+HttpClient::CancellationScope::~CancellationScope() {
+    t_cancel = previous_;
+}
+
+const CancellationToken& HttpClient::CancellationScope::current() {
+    return t_cancel;
+}
+
+HttpClient::RequestCountScope::RequestCountScope()
+    : counter_(std::make_shared<std::atomic<uint64_t>>(0)), previous_(t_counter) {
+    t_counter = counter_;
+}
+
+HttpClient::RequestCountScope::~RequestCountScope() {
+    t_counter = previous_;
+}
+
+std::shared_ptr<std::atomic<uint64_t>> HttpClient::RequestCountScope::current() {
+    return t_counter;
+}
+
+const char* HttpClient::toString(Priority priority) {
+    switch (priority) {
+    case Priority::Interactive: return "interactive";
+    case Priority::Normal: return "normal";
+    case Priority::Background: return "background";
+    }
+    return "normal";
+}
+
+std::optional<HttpClient::Priority> HttpClient::parsePriority(const std::string& name) {
+    for (auto priority : { Priority::Interactive, Priority::Normal, Priority::Background }) {
+        if (name == toString(priority)) return priority;
+    }
+    return std::nullopt;
+}
+
+HttpClient::HttpClient()
+    : HttpClient(Options{}) {
+}
+
+HttpClient::HttpClient(const Options& options)
+    : options_(std::make_shared<const Options>(options)), cassette_(openCassette(options.cassette)),
+    limiter_(std::make_unique<HostLimiter>()) {
+    // DNS und TLS-Sessions teilen sich alle Threads. Die Verbindungen bleiben in den Easy-Handles,
+    // die nach dem Request in idleHandles_ zurckkehren (siehe acquireHandle)
+    CURLSH* share = curl_share_init();
+    if (share) {
+        curl_share_setopt(share, CURLSHOPT_LOCKFUNC, &HttpClient::lockShare);
+        curl_share_setopt(share, CURLSHOPT_UNLOCKFUNC, &HttpClient::unlockShare);
+        curl_share_setopt(share, CURLSHOPT_USERDATA, this);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        share_ = share;
+    }
+}
+
+HttpClient::~HttpClient() {
+    // Zuerst die Engine, damit keine Transfers mehr laufen
+    engine_.reset();
+    for (void* multi : idleMultis_) {
+        curl_multi_cleanup(static_cast<CURLM*>(multi));
+    }
+    for (void* handle : idleHandles_) {
+        curl_easy_cleanup(static_cast<CURL*>(handle));
+    }
+    if (share_) {
+        curl_share_cleanup(static_cast<CURLSH*>(share_));
+    }
+}
+
+void HttpClient::setOptions(const Options& options) {
+    cassette_.store(openCassette(options.cassette));
+    options_.store(std::make_shared<const Options>(options));
+}
+
+std::shared_ptr<Cassette> HttpClient::openCassette(const CassetteConfig& config) {
+    switch (config.mode) {
+    case CassetteConfig::Mode::Record:
+        return Cassette::shared(config.filename, Cassette::Mode::Record, false);
+    case CassetteConfig::Mode::Replay:
+        return Cassette::shared(config.filename, Cassette::Mode::Replay, config.originalTiming);
+    default:
+        return nullptr;
+    }
+}
+
+HttpClient::Response HttpClient::replayFrom(Cassette& cassette, const Request& request) {
+    auto response = cassette.replay(request);
+    if (!response) {
+        Response missing;
+        missing.error = "Nicht in der Kassette: " + request.method + " " + request.url;
+        return missing;
+    }
+    return *response;
+}
+
+void* HttpClient::acquireHandle() {
+    {
+        std::lock_guard<std::mutex> lock(idleHandlesMutex_);
+        if (!idleHandles_.empty()) {
+            CURL* curl = static_cast<CURL*>(idleHandles_.back());
+            idleHandles_.pop_back();
+            // Setzt alle Optionen zurck, behlt aber die offenen Verbindungen
+            curl_easy_reset(curl);
+            return curl;
+        }
+    }
+    return curl_easy_init();
+}
+
+void HttpClient::releaseHandle(void* handle) {
+    {
+        std::lock_guard<std::mutex> lock(idleHandlesMutex_);
+        if (idleHandles_.size() < kMaxIdleHandles) {
+            idleHandles_.push_back(handle);
+            return;
+        }
+    }
+    curl_easy_cleanup(static_cast<CURL*>(handle));
+}
+
+void* HttpClient::acquireMulti() {
+    {
+        std::lock_guard<std::mutex> lock(idleHandlesMutex_);
+        if (!idleMultis_.empty()) {
+            void* multi = idleMultis_.back();
+            idleMultis_.pop_back();
+            return multi;
+        }
+    }
+    return curl_multi_init();
+}
+
+void HttpClient::releaseMulti(void* multi) {
+    {
+        std::lock_guard<std::mutex> lock(idleHandlesMutex_);
+        if (idleMultis_.size() < kMaxIdleMultis) {
+            idleMultis_.push_back(multi);
+            return;
+        }
+    }
+    curl_multi_cleanup(static_cast<CURLM*>(multi));
+}
+
+void HttpClient::lockShare(void*, int data, int, void* userptr) {
+    auto* self = static_cast<HttpClient*>(userptr);
+    self->shareMutexes_[static_cast<size_t>(data) % std::size(self->shareMutexes_)].lock();
+}
+
+void HttpClient::unlockShare(void*, int data, void* userptr) {
+    auto* self = static_cast<HttpClient*>(userptr);
+    self->shareMutexes_[static_cast<size_t>(data) % std::size(self->shareMutexes_)].unlock();
+}
+
+bool HttpClient::prewarm(const std::string& url, const std::string& metric) {
+    Request request;
+    request.method = "HEAD";
+    request.url = url;
+    request.metric = metric;
+
+    auto response = perform(request);
+    if (!response.ok) {
+        std::cerr << "Vorwrmen von " << url << " fehlgeschlagen: " << response.error << std::endl;
+    }
+    return response.ok;
+}
+
+HttpClient::Response HttpClient::perform(const Request& request) {
+    // Ein Snapshot fr alle Versuche, auch wenn die Einstellungen whrenddessen wechseln
+    auto options = options_.load();
+    const auto& retry = options->retry;
+    auto start = std::chrono::steady_clock::now();
+    noteActivity(effectivePriority(request));
+
+    auto cancel = effectiveCancellation(request);
+    Response response;
+    std::chrono::milliseconds queued{ 0 };
+    for (size_t attempt = 1;; attempt++) {
+        response = performOnce(request, *options);
+        response.attempts = attempt;
+        queued += response.queued;
+        if (attempt >= retry.maxAttempts || !shouldRetry(request, response)) break;
+
+        // Nicht ber Timeout oder Deadline hinaus warten
+        auto delay = retryDelay(retry, response, attempt);
+        auto timeoutMs = effectiveTimeoutMs(request, *options);
+        if (!timeoutMs || delay.count() >= *timeoutMs) break;
+
+        recordRetry(request.metric);
+        if (!sleepUnlessCancelled(delay, cancel)) {
+            response = cancelledResponse();
+            response.attempts = attempt;
+            break;
+        }
+    }
+
+    response.queued = queued;
+    recordPriority(effectivePriority(request), response, std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start));
+    return response;
+}
+
+bool HttpClient::shouldRetry(const Request& request, const Response& response) {
+    if (response.cancelled) return false;
+    // Bei 429 hat der Server den Request nicht verarbeitet
+    if (response.status == 429) return true;
+
+    bool idempotent = (request.method == "GET" || request.method == "HEAD");
+    if (!idempotent || response.timedOut) return false;
+    return !response.ok || response.status >= 500;
+}
+
+std::chrono::milliseconds HttpClient::retryDelay(const RetryConfig& retry, const Response& response, size_t attempt) {
+    thread_local std::mt19937 random(std::random_device{}());
+    return retryDelay(retry, response, attempt, random);
+}
+
+std::chrono::milliseconds HttpClient::retryDelay(const RetryConfig& retry, const Response& response, size_t attempt,
+    std::mt19937& random) {
+    // Retry-After in Sekunden hat Vorrang (Spotify sendet es bei 429)
+    auto it = response.headers.find("retry-after");
+    if (it != response.headers.end()) {
+        try {
+            return std::chrono::seconds(std::stol(it->second));
+        }
+        catch (const std::exception&) {
+            // HTTP-Datum: auf den Backoff zurckfallen
+        }
+    }
+
+    // Erst auf maxDelayMs begrenzen, dann verdoppeln: so kann auch ein groer baseDelayMs nicht berlaufen
+    const int64_t cap = std::max<int64_t>(retry.maxDelayMs, 1);
+    int64_t capped = std::clamp<int64_t>(retry.baseDelayMs, 1, cap);
+    for (size_t i = 1; i < attempt && capped < cap; i++) {
+        capped = std::min(capped * 2, cap);
+    }
+    // Jitter zwischen 50 und 100 %, damit parallele Clients nicht gleichzeitig wiederholen
+    std::uniform_int_distribution<int64_t> jitter(capped / 2, capped);
+    return std::chrono::milliseconds(jitter(random));
+}
+
+HttpClient::Response HttpClient::performOnce(const Request& request, const Options& options) {
+    // Abgebrochene Requests kosten weder Budget noch Platz in der Warteschlange
+    if (effectiveCancellation(request).cancelled()) {
+        auto response = cancelledResponse();
+        record(request.metric, response, false);
+        return response;
+    }
+
+    auto timeoutMs = effectiveTimeoutMs(request, options);
+    if (!timeoutMs) {
+        Response response;
+        response.timedOut = true;
+        response.error = "Deadline berschritten";
+        record(request.metric, response, false);
+        return response;
+    }
+
+    auto cassette = cassette_.load();
+    if (cassette && cassette->mode() == Cassette::Mode::Replay) {
+        auto response = replayFrom(*cassette, request);
+        if (cassette->originalTiming()) {
+            std::this_thread::sleep_for(response.elapsed);
+        }
+        else {
+            response.elapsed = std::chrono::milliseconds(0);
+        }
+        record(request.metric, response, false);
+        return response;
+    }
+
+    auto response = performNetwork(request, options, *timeoutMs);
+    if (cassette && !response.cancelled) {
+        cassette->record(request, response);
+    }
+    return response;
+}
+
+HttpClient::Response HttpClient::performNetwork(const Request& request, const Options& options, long timeoutMs) {
+    std::optional<long> hedgeDelay;
+    if (request.hedgeable && request.method == "GET") {
+        hedgeDelay = hedgeDelayMs(request.metric, options.hedging);
+    }
+
+    if (options.http2.enabled) {
+        return performMultiplexed(request, options, timeoutMs, hedgeDelay);
+    }
+
+    // Hchstens so viele Requests pro Host wie konfiguriert; das Warten zhlt zum Timeout
+    std::string host = hostOf(request.url);
+    Priority priority = effectivePriority(request);
+    auto cancel = effectiveCancellation(request);
+    auto start = std::chrono::steady_clock::now();
+    if (!limiter_->acquire(host, priority, hostLimit(options, host), options.qos,
+        start + std::chrono::milliseconds(timeoutMs), cancel)) {
+        if (cancel.cancelled()) {
+            auto response = cancelledResponse();
+            response.queued = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - start);
+            record(request.metric, response, false);
+            return response;
+        }
+        Response response;
+        response.timedOut = true;
+        response.error = "Deadline berschritten (Host-Limit)";
+        response.queued = std::chrono::milliseconds(timeoutMs);
+        record(request.metric, response, false);
+        return response;
+    }
+    auto queued = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    long remaining = std::max(timeoutMs - static_cast<long>(queued.count()), 1L);
+
+    Response response;
+    // Ein Hedge lohnt sich nur, wenn er vor Ablauf des Timeouts starten kann
+    if (hedgeDelay && *hedgeDelay < remaining) {
+        response = performHedged(request, options, remaining, *hedgeDelay);
+    }
+    else {
+        response = performSingle(request, options, remaining);
+    }
+    limiter_->release(host, priority);
+    response.queued = queued;
+    return response;
+}
+
+void HttpClient::performAsync(const Request& request, Completion completion) {
+    auto options = options_.load();
+    auto priority = effectivePriority(request);
+    noteActivity(priority);
+    if (effectiveCancellation(request).cancelled()) {
+        auto response = cancelledResponse();
+        record(request.metric, response, false);
+        completion(std::move(response));
+        return;
+    }
+    auto timeoutMs = effectiveTimeoutMs(request, *options);
+    if (!timeoutMs) {
+        Response response;
+        response.timedOut = true;
+        response.error = "Deadline berschritten";
+        record(request.metric, response, false);
+        completion(std::move(response));
+        return;
+    }
+
+    auto cassette = cassette_.load();
+    if (cassette && cassette->mode() == Cassette::Mode::Replay) {
+        // Auch ohne Transfer ber die Engine zustellen, damit completion im gewohnten Thread luft
+        auto response = replayFrom(*cassette, request);
+        auto due = std::chrono::steady_clock::now();
+        if (cassette->originalTiming()) {
+            due += response.elapsed;
+        }
+        else {
+            response.elapsed = std::chrono::milliseconds(0);
+        }
+        record(request.metric, response, false);
+        recordPriority(priority, response, response.elapsed);
+        engine().schedule(std::move(response), due, std::move(completion));
+        return;
+    }
+
+    // Wiederholungen starten im Engine-Thread, in dem die Scopes des Aufrufers nicht gelten:
+    // Abbruch, Prioritt und Deadline deshalb im Request festhalten
+    auto pinned = std::make_shared<Request>(request);
+    pinned->cancel = effectiveCancellation(request);
+    pinned->priority = priority;
+    if (!pinned->counter) pinned->counter = t_counter;
+    auto scoped = DeadlineScope::current();
+    if (scoped && (!pinned->deadline || *scoped < *pinned->deadline)) {
+        pinned->deadline = scoped;
+    }
+    performAsyncAttempt(std::move(pinned), std::move(options), 1, std::chrono::steady_clock::now(),
+        std::chrono::milliseconds(0), std::move(completion));
+}
+
+void HttpClient::performAsyncAttempt(std::shared_ptr<const Request> request, std::shared_ptr<const Options> options,
+    size_t attempt, std::chrono::steady_clock::time_point start, std::chrono::milliseconds queued,
+    Completion completion) {
+    auto priority = *request->priority;
+    auto finish = [this, priority, start](Response& response, std::chrono::milliseconds queued) {
+        response.queued = queued;
+        recordPriority(priority, response, std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start));
+    };
+
+    // Zwischen zwei Versuchen kann der Aufrufer abgebrochen haben oder die Deadline abgelaufen sein
+    auto timeoutMs = effectiveTimeoutMs(*request, *options);
+    if (request->cancel.cancelled() || !timeoutMs) {
+        Response response = request->cancel.cancelled() ? cancelledResponse() : Response{};
+        if (!response.cancelled) {
+            response.timedOut = true;
+            response.error = "Deadline berschritten";
+        }
+        record(request->metric, response, false);
+        response.attempts = attempt;
+        finish(response, queued);
+        completion(std::move(response));
+        return;
+    }
+
+    auto cassette = cassette_.load();
+    countSent(*request);
+    engine().submit(*request, *options, *timeoutMs, priority,
+        [this, request, options, attempt, start, queued, cassette, finish, completion = std::move(completion)](
+            Response response) mutable {
+            record(request->metric, response, false);
+            if (cassette && !response.cancelled) cassette->record(*request, response);
+            response.attempts = attempt;
+            queued += response.queued;
+
+            // Dieselbe Regel wie in perform(), nur wartet statt des Threads ein Timer der Engine
+            if (attempt < options->retry.maxAttempts && shouldRetry(*request, response)) {
+                auto delay = retryDelay(options->retry, response, attempt);
+                auto timeoutMs = effectiveTimeoutMs(*request, *options);
+                if (timeoutMs && delay.count() < *timeoutMs) {
+                    recordRetry(request->metric);
+                    engine().scheduleRetry(std::chrono::steady_clock::now() + delay, request->cancel,
+                        [this, request, options, attempt, start, queued, finish, completion = std::move(completion)](
+                            Response stopped) mutable {
+                            if (!stopped.error.empty()) {
+                                stopped.attempts = attempt;
+                                finish(stopped, queued);
+                                completion(std::move(stopped));
+                                return;
+                            }
+                            performAsyncAttempt(request, options, attempt + 1, start, queued, std::move(completion));
+                        });
+                    return;
+                }
+            }
+            finish(response, queued);
+            completion(std::move(response));
+        });
+}
+
+HttpClient::AsyncEngine& HttpClient::engine() {
+    // Engine erst beim ersten Request ber das Multi-Handle starten
+    std::call_once(engineOnce_, [this]() { engine_ = std::make_unique<AsyncEngine>(*this); });
+    return *engine_;
+}
+
+HttpClient::Priority HttpClient::effectivePriority(const Request& request) {
+    return request.priority.value_or(PriorityScope::current());
+}
+
+CancellationToken HttpClient::effectiveCancellation(const Request& request) {
+    return request.cancel.cancellable() ? request.cancel : CancellationScope::current();
+}
+
+void HttpClient::countSent(const Request& request) {
+    const auto& counter = request.counter ? request.counter : t_counter;
+    if (counter) counter->fetch_add(1, std::memory_order_relaxed);
+}
+
+std::optional<long> HttpClient::effectiveTimeoutMs(const Request& request, const Options& options) {
+    long timeoutMs = options.timeouts.requestTimeoutMs;
+    for (auto deadline : { DeadlineScope::current(), request.deadline }) {
+        if (!deadline) continue;
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+            *deadline - std::chrono::steady_clock::now()).count();
+        if (remaining <= 0) return std::nullopt;
+        timeoutMs = std::min<long>(timeoutMs, static_cast<long>(remaining));
+    }
+    return timeoutMs;
+}
+
+std::optional<long> HttpClient::hedgeDelayMs(const std::string& metric, const HedgeConfig& hedging) const {
+    if (!hedging.enabled) return std::nullopt;
+
+    std::vector<double> samples;
+    {
+        std::lock_guard<std::mutex> lock(statsMutex_);
+        auto it = metrics_.find(metric);
+        if (it != metrics_.end()) samples = it->second.samples;
+    }
+
+    // Ohne ausreichend Messwerte erst nach der Obergrenze hedgen
+    if (samples.size() < hedging.minSamples) {
+        return hedging.maxDelayMs;
+    }
+
+    long delay = static_cast<long>(percentile(std::move(samples), hedging.percentile));
+    return std::clamp(delay, hedging.minDelayMs, hedging.maxDelayMs);
+}
+
+HttpClient::Response HttpClient::performSingle(const Request& request, const Options& options, long timeoutMs) {
+    Response response;
+    auto start = std::chrono::steady_clock::now();
+
+    auto transfer = createTransfer(request, options, timeoutMs, effectiveCancellation(request),
+        static_cast<CURLSH*>(share_), static_cast<CURL*>(acquireHandle()));
+    if (!transfer) {
+        response.error = "Konnte cURL nicht initialisieren";
+        return response;
+    }
+    transfer->recycle = [this](CURL* curl) { releaseHandle(curl); };
+    countSent(request);
+
+    CURLcode res = curl_easy_perform(transfer->curl);
+    fillResponse(*transfer, res, response);
+    response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    record(request.metric, response, false);
+    return response;
+}
+
+HttpClient::Response HttpClient::performHedged(const Request& request, const Options& options, long timeoutMs,
+    long hedgeDelay) {
+    Response response;
+    auto start = std::chrono::steady_clock::now();
+    auto hedgeAt = start + std::chrono::milliseconds(hedgeDelay);
+    auto cancel = effectiveCancellation(request);
+    std::string host = hostOf(request.url);
+    Priority priority = effectivePriority(request);
+    auto recycle = [this](CURL* curl) { releaseHandle(curl); };
+
+    // Beide Requests nehmen Handles aus dem Pool, damit auch der Hedge eine offene Verbindung
+    // oder wenigstens die TLS-Session vorfindet
+    auto primary = createTransfer(request, options, timeoutMs, cancel, static_cast<CURLSH*>(share_),
+        static_cast<CURL*>(acquireHandle()));
+    CURLM* multi = static_cast<CURLM*>(acquireMulti());
+    if (!primary || !multi) {
+        if (multi) releaseMulti(multi);
+        response.error = "Konnte cURL nicht initialisieren";
+        return response;
+    }
+    primary->recycle = recycle;
+
+    std::unique_ptr<Transfer> hedge;
+    bool hedgeSlot = false;
+    curl_multi_add_handle(multi, primary->curl);
+    primary->attached = true;
+    countSent(request);
+    int active = 1;
+    bool done = false;
+
+    while (!done) {
+        int running = 0;
+        curl_multi_perform(multi, &running);
+
+        CURLMsg* msg = nullptr;
+        int queued = 0;
+        while (!done && (msg = curl_multi_info_read(multi, &queued))) {
+            if (msg->msg != CURLMSG_DONE) continue;
+
+            CURLcode res = msg->data.result;
+            Transfer* finished = (msg->easy_handle == primary->curl) ? primary.get() : hedge.get();
+            curl_multi_remove_handle(multi, finished->curl);
+            finished->attached = false;
+            active--;
+
+            // Die erste verwertbare Antwort gewinnt; ein Fehler (auch 429 oder 5xx) zhlt nur,
+            // wenn kein anderer Request mehr unterwegs ist
+            Response candidate;
+            fillResponse(*finished, res, candidate);
+            if (decisive(candidate) || active == 0) {
+                response = std::move(candidate);
+                response.hedged = (finished == hedge.get());
+                done = true;
+            }
+        }
+        if (done) break;
+
+        auto now = std::chrono::steady_clock::now();
+        if (!hedge && now >= hedgeAt) {
+            long remaining = timeoutMs - static_cast<long>(
+                std::chrono::duration_cast<std::chrono::milliseconds>(now - start).count());
+            // Der Hedge braucht einen eigenen Platz im Host-Limit. Ist keiner sofort frei, unterbleibt
+            // er, statt max_per_host und den Vorrang wartender Requests gerade unter Last zu umgehen
+            if (remaining > 0 && active > 0 && !cancel.cancelled() &&
+                limiter_->tryAcquire(host, priority, hostLimit(options, host), options.qos)) {
+                hedgeSlot = true;
+                hedge = createTransfer(request, options, remaining, cancel, static_cast<CURLSH*>(share_),
+                    static_cast<CURL*>(acquireHandle()));
+                if (hedge) {
+                    hedge->recycle = recycle;
+                    curl_multi_add_handle(multi, hedge->curl);
+                    hedge->attached = true;
+                    active++;
+                    countSent(request);
+                }
+            }
+            if (!hedge) {
+                // Kein Hedge mglich: nicht erneut versuchen
+                hedgeAt = std::chrono::steady_clock::time_point::max();
+            }
+        }
+
+        int waitMs = 100;
+        if (!hedge && hedgeAt != std::chrono::steady_clock::time_point::max()) {
+            auto untilHedge = std::chrono::duration_cast<std::chrono::milliseconds>(hedgeAt - now).count();
+            waitMs = static_cast<int>(std::clamp<long long>(untilHedge, 1, 100));
+        }
+        curl_multi_poll(multi, nullptr, 0, waitMs, nullptr);
+    }
+
+    // Verlierer abbrechen
+    if (primary->attached) curl_multi_remove_handle(multi, primary->curl);
+    if (hedge && hedge->attached) curl_multi_remove_handle(multi, hedge->curl);
+    releaseMulti(multi);
+    if (hedgeSlot) limiter_->release(host, priority);
+
+    response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+
+    record(request.metric, response, hedge != nullptr);
+    return response;
+}
+
+bool HttpClient::decisive(const Response& response) {
+    return response.ok && response.status < 500 && response.status != 429;
+}
+
+HttpClient::Response HttpClient::performMultiplexed(const Request& request, const Options& options,
+    long timeoutMs, std::optional<long> hedgeDelay) {
+    // Gemeinsamer Zustand von Primr- und Hedge-Request; berlebt einen verspteten Verlierer
+    struct Race {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::optional<Response> winner;
+        int outstanding = 0;
+        std::vector<CancellationToken> cancels;     // Eines pro Request, dem Abbruch des Aufrufers verknpft
+    };
+
+    auto race = std::make_shared<Race>();
+    auto start = std::chrono::steady_clock::now();
+    auto priority = effectivePriority(request);
+    auto cancel = effectiveCancellation(request);
+
+    auto submit = [&](bool isHedge, long timeout) {
+        Request raced = request;
+        raced.cancel = CancellationToken::linkedTo(cancel);
+        {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            if (race->winner) return false;
+            race->outstanding++;
+            race->cancels.push_back(raced.cancel);
+        }
+        countSent(request);
+        engine().submit(raced, options, timeout, priority, [race, isHedge](Response response) {
+            std::lock_guard<std::mutex> lock(race->mutex);
+            race->outstanding--;
+            // Die erste verwertbare Antwort gewinnt; ein Fehler nur, wenn nichts mehr unterwegs ist
+            if (!race->winner && (decisive(response) || race->outstanding == 0)) {
+                response.hedged = isHedge;
+                race->winner = std::move(response);
+                // Der Verlierer belegt sonst bis zu seinem Ende Stream und Host-Limit
+                for (const auto& token : race->cancels) {
+                    token.cancel();
+                }
+                race->cv.notify_all();
+            }
+            });
+        return true;
+    };
+
+    submit(false, timeoutMs);
+
+    bool hedgeSent = false;
+    std::unique_lock<std::mutex> lock(race->mutex);
+    if (hedgeDelay && *hedgeDelay < timeoutMs) {
+        bool answered = race->cv.wait_for(lock, std::chrono::milliseconds(*hedgeDelay),
+            [&race]() { return race->winner.has_value(); });
+        if (!answered && !cancel.cancelled()) {
+            // Der Hedge luft als weiterer Stream auf derselben Verbindung
+            lock.unlock();
+            hedgeSent = submit(true, timeoutMs - *hedgeDelay);
+            lock.lock();
+        }
+    }
+    race->cv.wait(lock, [&race]() { return race->winner.has_value(); });
+
+    Response response = std::move(*race->winner);
+    lock.unlock();
+
+    response.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    record(request.metric, response, hedgeSent);
+    return response;
+}
+
+void HttpClient::record(const std::string& metric, const Response& response, bool hedgeSent) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    auto& state = metrics_[metric.empty() ? "default" : metric];
+
+    state.counters.requests++;
+    if (hedgeSent) state.counters.hedgesSent++;
+    if (response.hedged) state.counters.hedgeWins++;
+    if (response.timedOut) state.counters.timeouts++;
+    if (response.status == 429) state.counters.throttled++;
+    if (response.cancelled) state.counters.cancelled++;
+    if (response.httpVersion == 20) state.counters.http2++;
+    state.counters.newConnections += response.newConnections;
+
+    // Nur vollstndige Antworten flieen in die Latenzverteilung ein
+    if (response.ok) {
+        double ms = static_cast<double>(response.elapsed.count());
+        if (state.samples.size() < kLatencyWindow) {
+            state.samples.push_back(ms);
+        }
+        else {
+            state.samples[state.next] = ms;
+        }
+        state.next = (state.next + 1) % kLatencyWindow;
+    }
+}
+
+void HttpClient::recordRetry(const std::string& metric) {
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    metrics_[metric.empty() ? "default" : metric].counters.retries++;
+}
+
+void HttpClient::noteActivity(Priority priority) {
+    if (priority == Priority::Background) return;
+    lastForeground_.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+std::chrono::steady_clock::duration HttpClient::foregroundIdle() const {
+    auto last = std::chrono::steady_clock::time_point(
+        std::chrono::steady_clock::duration(lastForeground_.load(std::memory_order_relaxed)));
+    return std::chrono::steady_clock::now() - last;
+}
+
+void HttpClient::recordPriority(Priority priority, const Response& response, std::chrono::milliseconds total) {
+    noteActivity(priority);
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    auto& state = priorities_[priority];
+
+    state.counters.requests++;
+    if (response.timedOut) state.counters.timeouts++;
+    if (!response.ok) return;
+
+    double ms = static_cast<double>(total.count());
+    double queuedMs = static_cast<double>(response.queued.count());
+    if (state.samples.size() < kLatencyWindow) {
+        state.samples.push_back(ms);
+        state.queued.push_back(queuedMs);
+    }
+    else {
+        state.samples[state.next] = ms;
+        state.queued[state.next] = queuedMs;
+    }
+    state.next = (state.next + 1) % kLatencyWindow;
+}
+
+std::map<std::string, HttpClient::MetricStats> HttpClient::stats() const {
+    std::map<std::string, MetricStats> result;
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    for (const auto& [name, state] : metrics_) {
+        MetricStats s = state.counters;
+        s.p50Ms = percentile(state.samples, 0.50);
+        s.p95Ms = percentile(state.samples, 0.95);
+        s.p99Ms = percentile(state.samples, 0.99);
+        result[name] = s;
+    }
+    return result;
+}
+
+std::map<HttpClient::Priority, HttpClient::PriorityStats> HttpClient::priorityStats() const {
+    std::map<Priority, PriorityStats> result;
+    std::lock_guard<std::mutex> lock(statsMutex_);
+    for (const auto& [priority, state] : priorities_) {
+        PriorityStats s = state.counters;
+        s.p50Ms = percentile(state.samples, 0.50);
+        s.p95Ms = percentile(state.samples, 0.95);
+        s.p99Ms = percentile(state.samples, 0.99);
+        s.queuedP95Ms = percentile(state.queued, 0.95);
+        result[priority] = s;
+    }
+    return result;
+}
+
+void HttpClient::printStats(std::ostream& out) const {
+    for (const auto& [name, s] : stats()) {
+        double hedgeRate = s.requests ? 100.0 * s.hedgesSent / s.requests : 0.0;
+        out << std::fixed << std::setprecision(1)
+            << name << ": " << s.requests << " Requests"
+            << ", Hedge-Rate " << hedgeRate << "% (" << s.hedgeWins << " gewonnen)"
+            << ", Timeouts " << s.timeouts
+            << ", abgebrochen " << s.cancelled
+            << ", Wiederholungen " << s.retries << " (" << s.throttled << "x 429)"
+            << ", HTTP/2 " << s.http2
+            << ", neue Verbindungen " << s.newConnections
+            << ", p50 " << s.p50Ms << " ms"
+            << ", p95 " << s.p95Ms << " ms"
+            << ", p99 " << s.p99Ms << " ms" << std::endl;
+    }
+    for (const auto& [priority, s] : priorityStats()) {
+        out << std::fixed << std::setprecision(1)
+            << "Klasse " << toString(priority) << ": " << s.requests << " Requests"
+            << ", Timeouts " << s.timeouts
+            << ", p50 " << s.p50Ms << " ms"
+            << ", p95 " << s.p95Ms << " ms"
+            << ", p99 " << s.p99Ms << " ms"
+            << ", davon Warten p95 " << s.queuedP95Ms << " ms" << std::endl;
+    }
+}
+
+double HttpClient::percentile(std::vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+    std::nth_element(values.begin(), values.begin() + index, values.end());
+    return values[index];
+}
@@ -0,0 +1,403 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <optional>
+#include <functional>
+#include <utility>
+#include <algorithm>
+#include <cstdint>
+#include <ostream>
+#include <random>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/executor_work_guard.hpp>
+#include "CancellationToken.h"
+
+namespace net = boost::asio;
+
+class Cassette;
+
+/// <summary>
+/// Gemeinsame HTTP-Schicht fr SpotifyService und SetlistFmService.
+/// Setzt Verbindungs- und Request-Timeouts, beachtet Deadline-Budgets und
+/// sendet fr idempotente GETs nach dem beobachteten p95 einen Hedge-Request.
+/// Neben dem blockierenden perform() gibt es asyncPerform() fr Asio-Coroutinen:
+/// alle asynchronen Requests laufen ber ein gemeinsames cURL-Multi-Handle in
+/// einem eigenen Thread. Mit HTTP/2 laufen auch die blockierenden Requests ber
+/// dieses Handle, damit sich alle Threads eine Verbindung pro Host teilen.
+/// Die Einstellungen lassen sich zur Laufzeit austauschen (setOptions). Fr Benchmarks ohne
+/// Netzwerk kann der Verkehr auf eine Kassette aufgenommen und wieder abgespielt werden.
+/// Vor dem Host-Limit werden Requests nach Priorittsklasse eingereiht, damit interaktive
+/// Importe nicht hinter Hintergrundarbeit warten. Abgebrochene Requests (CancellationToken)
+/// verlassen sofort die Warteschlange, laufende Transfers bricht der Fortschritts-Callback ab.
+/// </summary>
+class HttpClient {
+public:
+    // Priorittsklassen fr das Host-Limit, von der wichtigsten zur unwichtigsten
+    enum class Priority { Interactive, Normal, Background };
+
+    struct TimeoutConfig {
+        long connectTimeoutMs = 5000;
+        long requestTimeoutMs = 15000;
+        long importBudgetMs = 180000;   // Budget je angefangene kBudgetSongs Songs eines Imports
+        static constexpr size_t kBudgetSongs = 30;
+
+        // Ein festes Budget reicht fr eine Konzert-Setlist, bricht aber Tour- und Festivallisten
+        // mit Hunderten Songs immer mit einer halben Playlist ab; es wchst daher mit der Songzahl
+        std::chrono::milliseconds importBudget(size_t songCount) const {
+            size_t blocks = std::max<size_t>(1, (songCount + kBudgetSongs - 1) / kBudgetSongs);
+            return std::chrono::milliseconds(importBudgetMs) * static_cast<long long>(blocks);
+        }
+    };
+
+    struct HedgeConfig {
+        bool enabled = true;
+        double percentile = 0.95;       // Hedge nach diesem Perzentil der Latenz
+        long minDelayMs = 50;
+        long maxDelayMs = 2000;         // Obergrenze, auch solange Messwerte fehlen
+        size_t minSamples = 20;         // Erst ab so vielen Messwerten hedgen
+    };
+
+    struct Http2Config {
+        // HTTP/2 aushandeln und Requests ber eine Verbindung multiplexen. Aus, weil dann auch die
+        // blockierenden Requests ber den einen Engine-Thread laufen und bei einem Rckfall auf
+        // HTTP/1.1 (Proxy) die eine Verbindung pro Host alle Requests nacheinander abarbeitet
+        bool enabled = false;
+        long maxConcurrentStreams = 100;
+        long maxHostConnections = 1;    // Weitere Requests warten auf freie Streams
+    };
+
+    // Wiederholung blockierender Requests: 429 immer, 5xx und Transportfehler nur bei GET/HEAD
+    struct RetryConfig {
+        size_t maxAttempts = 3;         // Einschlielich des ersten Versuchs
+        long baseDelayMs = 250;         // Exponentieller Backoff mit Jitter
+        long maxDelayMs = 5000;         // Gilt nicht fr Retry-After des Servers
+    };
+
+    struct HostLimitConfig {
+        long defaultMaxInFlight = 0;    // Gleichzeitige Requests pro Host, 0 = unbegrenzt
+        std::map<std::string, long> perHost;
+    };
+
+    // Reihenfolge der Requests, die auf einen Platz im Host-Limit warten
+    struct QosConfig {
+        bool enabled = true;            // Aus: reine FIFO-Reihenfolge
+        long agingMs = 2000;            // Wartende steigen pro Intervall eine Klasse auf
+        double backgroundShare = 0.75;  // Anteil des Host-Limits, den Hintergrund-Requests belegen drfen
+    };
+
+    // Aufnahme bzw. Wiedergabe aller Requests (siehe Cassette)
+    struct CassetteConfig {
+        enum class Mode { Off, Record, Replay };
+        Mode mode = Mode::Off;
+        std::string filename = "http_cassette.ndjson";
+        bool originalTiming = false;    // Bei der Wiedergabe die aufgezeichnete Latenz abwarten
+    };
+
+    struct Options {
+        TimeoutConfig timeouts;
+        HedgeConfig hedging;
+        Http2Config http2;
+        RetryConfig retry;
+        HostLimitConfig hostLimits;
+        QosConfig qos;
+        CassetteConfig cassette;
+    };
+
+    struct Request {
+        std::string method = "GET";
+        std::string url;
+        std::vector<std::string> headers;
+        std::string body;
+        std::string metric;             // Name fr die Latenzstatistik, z.B. "spotify.search"
+        bool hedgeable = false;         // Nur fr idempotente GETs setzen
+        // Zustzliche Deadline fr diesen Request (z.B. fr einen ganzen Fan-out).
+        // Fr asynchrone Requests anstelle von DeadlineScope verwenden, da Coroutinen
+        // den Thread wechseln knnen.
+        std::optional<std::chrono::steady_clock::time_point> deadline;
+        // Ohne Angabe gilt die PriorityScope des aufrufenden Threads (wie bei der Deadline)
+        std::optional<Priority> priority;
+        // Ohne Angabe gilt die CancellationScope des aufrufenden Threads
+        CancellationToken cancel;
+        // Ohne Angabe zhlt die RequestCountScope des aufrufenden Threads
+        std::shared_ptr<std::atomic<uint64_t>> counter;
+    };
+
+    struct Response {
+        bool ok = false;                // Transport erfolgreich (unabhngig vom HTTP-Status)
+        long status = 0;
+        std::string body;
+        std::string error;
+        bool timedOut = false;
+        bool cancelled = false;         // ber das CancellationToken abgebrochen
+        bool hedged = false;            // Antwort stammt vom Hedge-Request
+        long httpVersion = 0;           // 11 oder 20
+        long newConnections = 0;        // Fr diesen Request neu aufgebaute Verbindungen
+        size_t attempts = 1;
+        std::chrono::milliseconds queued{ 0 };          // Wartezeit auf das Host-Limit
+        std::map<std::string, std::string> headers;     // Namen in Kleinbuchstaben
+        std::chrono::milliseconds elapsed{ 0 };
+    };
+
+    struct MetricStats {
+        uint64_t requests = 0;
+        uint64_t hedgesSent = 0;
+        uint64_t hedgeWins = 0;
+        uint64_t timeouts = 0;
+        uint64_t http2 = 0;             // ber HTTP/2 beantwortet
+        uint64_t newConnections = 0;
+        uint64_t retries = 0;
+        uint64_t throttled = 0;         // Antworten mit 429
+        uint64_t cancelled = 0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+    };
+
+    // Aus Sicht des Aufrufers: Latenz einschlielich Wartezeit und Wiederholungen
+    struct PriorityStats {
+        uint64_t requests = 0;
+        uint64_t timeouts = 0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double queuedP95Ms = 0.0;       // Davon Wartezeit auf das Host-Limit
+    };
+
+    /// <summary>
+    /// Setzt fr den aktuellen Thread eine Deadline, die alle Requests innerhalb
+    /// des Scopes begrenzt. Verschachtelte Scopes knnen die Deadline nur verkrzen.
+    /// </summary>
+    class DeadlineScope {
+    public:
+        explicit DeadlineScope(std::chrono::milliseconds budget);
+        ~DeadlineScope();
+        DeadlineScope(const DeadlineScope&) = delete;
+        DeadlineScope& operator=(const DeadlineScope&) = delete;
+
+        static std::optional<std::chrono::steady_clock::time_point> current();
+        static bool expired();
+
+    private:
+        std::optional<std::chrono::steady_clock::time_point> previous_;
+    };
+
+    /// <summary>
+    /// Setzt fr den aktuellen Thread die Priorittsklasse aller Requests innerhalb des
+    /// Scopes. Anders als bei DeadlineScope gilt der innerste Scope.
+    /// </summary>
+    class PriorityScope {
+    public:
+        explicit PriorityScope(Priority priority);
+        ~PriorityScope();
+        PriorityScope(const PriorityScope&) = delete;
+        PriorityScope& operator=(const PriorityScope&) = delete;
+
+        static Priority current();
+
+    private:
+        Priority previous_;
+    };
+
+    /// <summary>
+    /// Setzt fr den aktuellen Thread das CancellationToken aller Requests innerhalb des
+    /// Scopes. Wie bei PriorityScope gilt der innerste Scope; ein leeres Token lsst das
+    /// uere in Kraft.
+    /// </summary>
+    class CancellationScope {
+    public:
+        explicit CancellationScope(const CancellationToken& token);
+        ~CancellationScope();
+        CancellationScope(const CancellationScope&) = delete;
+        CancellationScope& operator=(const CancellationScope&) = delete;
+
+        static const CancellationToken& current();
+        static bool cancelled() { return current().cancelled(); }
+
+    private:
+        CancellationToken previous_;
+    };
+
+    /// <summary>
+    /// Zhlt fr den aktuellen Thread alle Requests, die innerhalb des Scopes tatschlich
+    /// gesendet werden: auch Wiederholungen, Hedges und asynchrone Requests, die der Thread
+    /// startet (z.B. die Varianten der Suchkaskade). Es zhlt nur der innerste Scope.
+    /// </summary>
+    class RequestCountScope {
+    public:
+        RequestCountScope();
+        ~RequestCountScope();
+        RequestCountScope(const RequestCountScope&) = delete;
+        RequestCountScope& operator=(const RequestCountScope&) = delete;
+
+        // Bisher gezhlte Requests; der Zhler beginnt danach wieder bei 0
+        uint64_t take() { return counter_->exchange(0); }
+
+        static std::shared_ptr<std::atomic<uint64_t>> current();
+
+    private:
+        std::shared_ptr<std::atomic<uint64_t>> counter_;
+        std::shared_ptr<std::atomic<uint64_t>> previous_;
+    };
+
+    using Completion = std::function<void(Response)>;
+
+    HttpClient();
+    explicit HttpClient(const Options& options);
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    Response perform(const Request& request);
+
+    // Baut DNS-Auflsung, TCP- und TLS-Verbindung zum Host der URL vorab auf
+    // (HEAD-Request), damit der erste echte Request sie wiederverwendet
+    bool prewarm(const std::string& url, const std::string& metric);
+
+    // Nicht blockierend, mit denselben Wiederholungen wie perform() (die Wartezeit luft als Timer
+    // der Engine); completion luft im Thread der Async-Engine und darf nicht blockieren
+    void performAsync(const Request& request, Completion completion);
+
+    // Asio-Variante, z.B. co_await http.asyncPerform(request, net::use_awaitable).
+    // Die Fortsetzung luft auf dem Executor des Aufrufers.
+    template <typename CompletionToken>
+    auto asyncPerform(Request request, CompletionToken&& token);
+
+    // Aktuelle Einstellungen; setOptions() gilt ab dem nchsten Request, laufende bleiben unberhrt
+    Options options() const { return *options_.load(); }
+    void setOptions(const Options& options);
+
+    // Instrumentierung
+    std::map<std::string, MetricStats> stats() const;
+    std::map<Priority, PriorityStats> priorityStats() const;
+    void printStats(std::ostream& out) const;
+
+    // Zeit seit dem letzten Request oberhalb von Background (Start oder Ende), z.B. fr den CacheWarmer
+    std::chrono::steady_clock::duration foregroundIdle() const;
+
+    static const char* toString(Priority priority);
+    static std::optional<Priority> parsePriority(const std::string& name);
+
+    // Regeln von Host-Limit und Wiederholung ohne Netzwerk und Uhr, damit die
+    // Lastsimulation (LoadSimulator) dieselben Entscheidungen trifft wie der echte Client
+
+    // Ein Request, der auf einen Platz im Host-Limit wartet
+    struct Waiter {
+        uint64_t ticket;
+        Priority priority;
+        std::chrono::steady_clock::time_point since;
+    };
+
+    // Index des Wartenden (in Ankunftsreihenfolge), der bei einem Limit > 0 als nchster
+    // einen Platz bekommt: Klasse nach Alterung, Hintergrund-Anteil, sonst FIFO. nullopt, wenn keiner darf.
+    static std::optional<size_t> nextAdmission(const std::vector<Waiter>& waiting, long inFlight,
+        long backgroundInFlight, long limit, const QosConfig& qos, std::chrono::steady_clock::time_point now);
+    static bool shouldRetry(const Request& request, const Response& response);
+    static std::chrono::milliseconds retryDelay(const RetryConfig& retry, const Response& response, size_t attempt);
+    static std::chrono::milliseconds retryDelay(const RetryConfig& retry, const Response& response, size_t attempt,
+        std::mt19937& random);
+
+private:
+    class AsyncEngine;
+    class HostLimiter;
+
+    struct MetricState {
+        std::vector<double> samples;    // Ringpuffer der letzten Latenzen in ms
+        size_t next = 0;
+        MetricStats counters;
+    };
+
+    struct PriorityState {
+        std::vector<double> samples;    // Ringpuffer: Gesamtlatenz in ms
+        std::vector<double> queued;     // Ringpuffer: Wartezeit in ms, gleicher Index
+        size_t next = 0;
+        PriorityStats counters;
+    };
+
+    static constexpr size_t kLatencyWindow = 512;
+
+    std::atomic<std::shared_ptr<const Options>> options_;
+    std::atomic<std::shared_ptr<Cassette>> cassette_;
+    std::unique_ptr<HostLimiter> limiter_;
+    mutable std::mutex statsMutex_;
+    std::map<std::string, MetricState> metrics_;
+    std::map<Priority, PriorityState> priorities_;
+    std::atomic<std::chrono::steady_clock::rep> lastForeground_{ 0 };
+
+    std::once_flag engineOnce_;
+    std::unique_ptr<AsyncEngine> engine_;
+
+    // Gemeinsamer DNS- und TLS-Session-Cache der blockierenden Requests. Den Verbindungs-Cache
+    // darf cURL nicht zwischen gleichzeitig laufenden Threads teilen; er bleibt in den Easy-Handles.
+    void* share_ = nullptr;             // CURLSH*
+    std::mutex shareMutexes_[8];
+    static void lockShare(void* handle, int data, int access, void* userptr);
+    static void unlockShare(void* handle, int data, void* userptr);
+
+    // Freie Easy-Handles der blockierenden Requests samt ihren offenen Verbindungen; jedes
+    // Handle nutzt immer nur ein Thread zugleich
+    static constexpr size_t kMaxIdleHandles = 16;
+    std::mutex idleHandlesMutex_;
+    std::vector<void*> idleHandles_;    // CURL*
+    void* acquireHandle();
+    void releaseHandle(void* handle);
+    // Freie Multi-Handles der Hedge-Rennen; ihr Verbindungs-Cache bleibt so ber Rennen hinweg erhalten
+    static constexpr size_t kMaxIdleMultis = 4;
+    std::vector<void*> idleMultis_;     // CURLM*, ebenfalls unter idleHandlesMutex_
+    void* acquireMulti();
+    void releaseMulti(void* multi);
+
+    AsyncEngine& engine();
+    static std::optional<long> effectiveTimeoutMs(const Request& request, const Options& options);
+    static Priority effectivePriority(const Request& request);
+    static CancellationToken effectiveCancellation(const Request& request);
+    // Zhlt einen gesendeten Request beim Zhler des Requests bzw. der RequestCountScope
+    static void countSent(const Request& request);
+    std::optional<long> hedgeDelayMs(const std::string& metric, const HedgeConfig& hedging) const;
+    Response performOnce(const Request& request, const Options& options);
+    // Ein Versuch von performAsync; request trgt Abbruch, Prioritt und Deadline des Aufrufers
+    void performAsyncAttempt(std::shared_ptr<const Request> request, std::shared_ptr<const Options> options,
+        size_t attempt, std::chrono::steady_clock::time_point start, std::chrono::milliseconds queued,
+        Completion completion);
+    Response performNetwork(const Request& request, const Options& options, long timeoutMs);
+    static Response replayFrom(Cassette& cassette, const Request& request);
+    static std::shared_ptr<Cassette> openCassette(const CassetteConfig& config);
+    Response performSingle(const Request& request, const Options& options, long timeoutMs);
+    Response performHedged(const Request& request, const Options& options, long timeoutMs, long hedgeDelay);
+    // Entscheidet ein Hedge-Rennen: eine Antwort unter 500 auer 429. Bei 429, 5xx und
+    // Transportfehlern luft der andere Request weiter
+    static bool decisive(const Response& response);
+    Response performMultiplexed(const Request& request, const Options& options, long timeoutMs,
+        std::optional<long> hedgeDelay);
+    void record(const std::string& metric, const Response& response, bool hedgeSent);
+    void recordRetry(const std::string& metric);
+    void recordPriority(Priority priority, const Response& response, std::chrono::milliseconds total);
+    void noteActivity(Priority priority);
+    static double percentile(std::vector<double> values, double p);
+};
+
+template <typename CompletionToken>
+auto HttpClient::asyncPerform(Request request, CompletionToken&& token) {
+    return net::async_initiate<CompletionToken, void(Response)>(
+        [this](auto handler, Request request) {
+            // Hlt den Executor des Aufrufers am Leben, bis die Antwort zugestellt ist
+            auto work = net::make_work_guard(handler);
+            auto pending = std::make_shared<std::pair<decltype(handler), decltype(work)>>(
+                std::move(handler), std::move(work));
+
+            performAsync(request, [pending](Response response) {
+                auto executor = pending->second.get_executor();
+                net::dispatch(executor, [pending, response = std::move(response)]() mutable {
+                    pending->first(std::move(response));
+                    pending->second.reset();
+                    });
+                });
+        },
+        token, std::move(request));
+}
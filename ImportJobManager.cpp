@@ -0,0 +1,481 @@
+#include "ImportJobManager.h"
+#include "ImportJournal.h"
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+
+ImportJobManager::ImportJobManager(SetlistFmService& setlists, SpotifyService& spotify, const Options& options)
+    : setlists_(setlists), spotify_(spotify), retainedJobs_(options.retainedJobs), retention_(options.retention),
+    fetchStage_("fetch", options.fetchWorkers, options.queueCapacity,
+        [this](WorkItem& work) { return runStage(*work, &ImportJobManager::fetch); }),
+    parseStage_("parse", options.parseWorkers, options.stageCapacity,
+        [this](WorkItem& work) { return runStage(*work, &ImportJobManager::parse); }),
+    resolveStage_("resolve", options.resolveWorkers, options.stageCapacity,
+        [this](WorkItem& work) { return runStage(*work, &ImportJobManager::resolve); }),
+    writeStage_("write", options.writeWorkers, options.stageCapacity,
+        [this](WorkItem& work) { return runStage(*work, &ImportJobManager::write); }) {
+    fetchStage_.connect(parseStage_);
+    parseStage_.connect(resolveStage_);
+    resolveStage_.connect(writeStage_);
+
+    for (auto* stage : { &fetchStage_, &parseStage_, &resolveStage_, &writeStage_ }) {
+        stage->start();
+    }
+}
+
+ImportJobManager::~ImportJobManager() {
+    // Laufende Jobs abbrechen, sonst wartet join() (z.B. nach SIGINT) bis zu einem Import-Budget
+    // pro Job; ihr Fortschritt bleibt im Journal und wird beim nchsten Einreichen fortgesetzt
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [id, job] : jobs_) {
+            if (job->status == Status::Queued || job->status == Status::Running) {
+                job->cancel.cancel();
+            }
+        }
+    }
+
+    // Dann alle Stufen anhalten, damit kein Worker mehr auf Platz in der nchsten wartet
+    for (auto* stage : { &fetchStage_, &parseStage_, &resolveStage_, &writeStage_ }) {
+        stage->stop();
+    }
+    for (auto* stage : { &fetchStage_, &parseStage_, &resolveStage_, &writeStage_ }) {
+        stage->join();
+    }
+
+    // Suchergebnisse seit dem letzten Speichern sichern
+    spotify_.trackCache()->save();
+}
+
+std::optional<std::vector<std::string>> ImportJobManager::submit(const std::vector<JobRequest>& requests) {
+    std::vector<std::shared_ptr<Job>> jobs;
+    std::vector<WorkItem> items;
+    // Unter der Sperre, damit die Job-IDs fortlaufend bleiben und jeder Job in jobs_ steht,
+    // bevor eine Stufe ihn meldet
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < requests.size(); i++) {
+        auto job = std::make_shared<Job>();
+        job->id = std::to_string(nextJobId_ + i);
+        job->request = requests[i];
+        job->created = std::chrono::system_clock::now();
+
+        auto work = std::make_unique<Work>();
+        work->job = job;
+        items.push_back(std::move(work));
+        jobs.push_back(std::move(job));
+    }
+
+    if (!fetchStage_.tryPushAll(items)) {
+        return std::nullopt;
+    }
+
+    nextJobId_ += requests.size();
+    unfinished_ += requests.size();
+    std::vector<std::string> ids;
+    for (auto& job : jobs) {
+        ids.push_back(job->id);
+        jobs_[job->id] = std::move(job);
+    }
+    return ids;
+}
+
+std::optional<ImportJobManager::Job> ImportJobManager::job(const std::string& id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = jobs_.find(id);
+    // Abgelaufene Jobs fallen erst beim nchsten Jobende heraus, gelten aber schon jetzt als unbekannt
+    if (it == jobs_.end() || expiredLocked(*it->second, std::chrono::system_clock::now())) return std::nullopt;
+    return *it->second;
+}
+
+std::optional<uint64_t> ImportJobManager::subscribe(const std::string& jobId, EventCallback callback) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!jobId.empty()) {
+        auto it = jobs_.find(jobId);
+        if (it == jobs_.end() || expiredLocked(*it->second, std::chrono::system_clock::now())) {
+            return std::nullopt;
+        }
+    }
+
+    uint64_t id = nextSubscriptionId_++;
+    subscriptions_[id] = { jobId, callback };
+
+    // Bisherige Ereignisse nachliefern (unter der Sperre, damit keines doppelt oder verloren geht)
+    if (!jobId.empty()) {
+        for (const auto& event : history_[jobId]) {
+            callback(jobId, event);
+        }
+    }
+    return id;
+}
+
+void ImportJobManager::unsubscribe(uint64_t subscriptionId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    subscriptions_.erase(subscriptionId);
+}
+
+std::optional<ImportJobManager::Job> ImportJobManager::cancel(const std::string& id) {
+    std::shared_ptr<Job> job;
+    bool dequeued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = jobs_.find(id);
+        if (it == jobs_.end() || expiredLocked(*it->second, std::chrono::system_clock::now())) return std::nullopt;
+        job = it->second;
+
+        if (job->status == Status::Queued) {
+            // Ein Worker kann ihn gerade erst bernommen haben, ohne ihn schon als laufend markiert
+            // zu haben; dann luft er bereits und endet in seiner ersten Stufe
+            dequeued = !fetchStage_.removeIf([&job](const WorkItem& work) { return work->job == job; }).empty();
+            if (!dequeued) job->status = Status::Running;
+        }
+        if (job->status == Status::Queued || job->status == Status::Running) {
+            job->cancel.cancel();
+        }
+    }
+
+    if (dequeued) {
+        ImportEvent cancelled;
+        cancelled.type = ImportEvent::Type::Failed;
+        cancelled.message = "Import abgebrochen";
+        publish(job, cancelled);
+        finishJob(job, Status::Cancelled, cancelled.message);
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return *job;
+}
+
+size_t ImportJobManager::queueDepth() const {
+    return fetchStage_.depth();
+}
+
+size_t ImportJobManager::queueCapacity() const {
+    return fetchStage_.capacity();
+}
+
+std::vector<PipelineStageStats> ImportJobManager::stages() const {
+    return { fetchStage_.stats(), parseStage_.stats(), resolveStage_.stats(), writeStage_.stats() };
+}
+
+const char* ImportJobManager::toString(Status status) {
+    switch (status) {
+    case Status::Queued: return "queued";
+    case Status::Running: return "running";
+    case Status::Succeeded: return "succeeded";
+    case Status::Failed: return "failed";
+    case Status::Cancelled: return "cancelled";
+    }
+    return "unknown";
+}
+
+nlohmann::json ImportJobManager::toJson(const Job& job) {
+    auto toMs = [](std::chrono::system_clock::time_point t) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(t.time_since_epoch()).count();
+    };
+
+    nlohmann::json j = {
+        {"id", job.id},
+        {"setlist_id", job.request.setlistId},
+        {"playlist_name", job.request.playlistName},
+        {"account", job.request.account},
+        {"priority", HttpClient::toString(job.request.priority)},
+        {"status", toString(job.status)},
+        {"message", job.message},
+        {"song_count", job.songCount},
+        {"processed_count", job.processedCount},
+        {"resolved_count", job.resolvedCount},
+        {"created_ms", toMs(job.created)}
+    };
+    if (!job.playlistId.empty()) j["playlist_id"] = job.playlistId;
+    if (job.status == Status::Succeeded || job.status == Status::Failed || job.status == Status::Cancelled) {
+        j["finished_ms"] = toMs(job.finished);
+    }
+    return j;
+}
+
+nlohmann::json ImportJobManager::toJson(const PipelineStageStats& stage) {
+    return {
+        {"name", stage.name},
+        {"workers", stage.workers},
+        {"queue_depth", stage.depth},
+        {"queue_capacity", stage.capacity},
+        {"active", stage.active},
+        {"blocked", stage.blocked},
+        {"processed", stage.processed},
+        {"utilization", std::round(stage.utilization * 1000.0) / 1000.0}
+    };
+}
+
+bool ImportJobManager::runStage(Work& work, bool (ImportJobManager::*stage)(Work&)) {
+    try {
+        return (this->*stage)(work);
+    }
+    catch (const std::exception& e) {
+        fail(work, std::string("Fehler: ") + e.what());
+        return false;
+    }
+}
+
+bool ImportJobManager::fetch(Work& work) {
+    const auto& job = work.job;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->status = Status::Running;
+    }
+    if (job->cancel.cancelled()) {
+        fail(work, "Import abgebrochen");
+        return false;
+    }
+
+    HttpClient::PriorityScope priority(job->request.priority);
+    work.started = std::chrono::steady_clock::now();
+    work.response = setlists_.fetchSetlist(job->request.setlistId, job->cancel);
+    return true;
+}
+
+bool ImportJobManager::parse(Work& work) {
+    const auto& job = work.job;
+    auto result = setlists_.resolveSetlist(job->request.setlistId, work.response);
+    work.response = {};
+    if (result.refetch) {
+        // Selten: zwischen fetch und parse aus dem Cache verdrngt
+        HttpClient::PriorityScope priority(job->request.priority);
+        result = setlists_.resolveSetlist(job->request.setlistId,
+            setlists_.fetchSetlist(job->request.setlistId, job->cancel, false));
+    }
+    work.setlist = std::move(result.setlist);
+    if (!work.setlist) {
+        fail(work, "Fehler beim Laden der Setlist");
+        return false;
+    }
+
+    // Standardname wie in der UI
+    std::string playlistName = job->request.playlistName;
+    if (playlistName.empty()) {
+        playlistName = work.setlist->artist + " @ " + work.setlist->venue + " (" + work.setlist->eventDate + ")";
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->request.playlistName = playlistName;
+    }
+
+    ImportEvent started;
+    started.type = ImportEvent::Type::Started;
+    started.message = playlistName;
+    emit(work, std::move(started));
+
+    // Zwei Jobs mit derselben Setlist, demselben Namen und Konto wrden dasselbe Journal
+    // fortschreiben und die Playlist doppelt anlegen: Der sptere wird abgewiesen
+    std::string journalId = ImportJournal::makeJobId(job->request.setlistId, playlistName, job->request.account);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!activeJournals_.insert(journalId).second) {
+            journalId.clear();
+        }
+    }
+    if (journalId.empty()) {
+        fail(work, "Derselbe Import luft bereits in einem anderen Job");
+        return false;
+    }
+    work.journalId = journalId;
+
+    // Abgeschlossene Jobs werden bei erneuter Einreichung nicht doppelt importiert
+    work.journal = std::make_unique<ImportJournal>(journalId);
+    // Nach einer Bearbeitung der Setlist passen die Checkpoints nicht mehr; das Journal beginnt dann neu
+    work.journal->bindVersion(work.setlist->versionId);
+    work.checkpoint = work.journal->state();
+    if (work.checkpoint.completed) {
+        std::cout << "Import '" << playlistName << "' wurde bereits abgeschlossen." << std::endl;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            job->playlistId = work.checkpoint.playlistId.value_or("");
+        }
+        ImportEvent finished;
+        finished.type = ImportEvent::Type::Finished;
+        finished.playlistId = work.checkpoint.playlistId.value_or("");
+        emit(work, std::move(finished));
+        releaseJournal(work);
+        finishJob(job, Status::Succeeded, "Playlist erfolgreich erstellt");
+        return false;
+    }
+
+    // Jedes Konto bekommt einen eigenen Service; Token und HTTP-Client werden geteilt
+    work.spotify = spotify_.forAccount(job->request.account);
+    return true;
+}
+
+bool ImportJobManager::resolve(Work& work) {
+    const auto& job = work.job;
+    if (job->cancel.cancelled()) {
+        fail(work, "Import abgebrochen");
+        return false;
+    }
+
+    // Das Import-Budget gilt fr die Spotify-Requests von resolve und write zusammen; die
+    // Wartezeit vor write zhlt nicht, sonst scheitern bei einem Stau dort fertig aufgelste Jobs
+    auto resolveStart = std::chrono::steady_clock::now();
+    HttpClient::PriorityScope priority(job->request.priority);
+    HttpClient::CancellationScope cancellation(job->cancel);
+    auto budget = work.spotify->importBudget(work.setlist->songs.size());
+    HttpClient::DeadlineScope deadline(budget);
+
+    auto resolved = work.spotify->resolveTracks(work.setlist->artist, work.setlist->songs, work.checkpoint,
+        work.journal.get(), [this, &work](ImportEvent&& event) { emit(work, std::move(event)); });
+    if (!resolved) {
+        fail(work, "Fehler beim Erstellen der Playlist");
+        return false;
+    }
+    // Ohne Treffer erst gar keine leere Playlist anlegen
+    if (resolved->empty()) {
+        fail(work, "Keine Songs gefunden");
+        return false;
+    }
+
+    // Der Track-Cache wird nicht pro Job gespeichert, sondern gesammelt (siehe finishJob)
+    work.resolved = std::move(*resolved);
+    work.writeBudget = std::chrono::duration_cast<std::chrono::milliseconds>(
+        budget - (std::chrono::steady_clock::now() - resolveStart));
+    return true;
+}
+
+bool ImportJobManager::write(Work& work) {
+    const auto& job = work.job;
+    if (job->cancel.cancelled()) {
+        fail(work, "Import abgebrochen");
+        return false;
+    }
+
+    if (work.writeBudget.count() <= 0) {
+        fail(work, "Import-Budget berschritten");
+        return false;
+    }
+    HttpClient::PriorityScope priority(job->request.priority);
+    HttpClient::CancellationScope cancellation(job->cancel);
+    HttpClient::DeadlineScope deadline(work.writeBudget);
+
+    auto emitter = [this, &work](ImportEvent&& event) { emit(work, std::move(event)); };
+    auto playlistId = work.spotify->preparePlaylist(job->request.playlistName, work.setlist->artist,
+        work.checkpoint, work.journal.get(), emitter);
+    if (playlistId) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->playlistId = *playlistId;
+    }
+    if (!playlistId || !work.spotify->writeTracks(*playlistId, work.resolved, work.checkpoint,
+        work.journal.get(), emitter)) {
+        fail(work, "Fehler beim Erstellen der Playlist");
+        return false;
+    }
+
+    work.journal->markCompleted();
+    std::cout << "Playlist '" << job->request.playlistName << "' erfolgreich erstellt." << std::endl;
+
+    ImportEvent finished;
+    finished.type = ImportEvent::Type::Finished;
+    finished.playlistId = *playlistId;
+    emit(work, std::move(finished));
+    releaseJournal(work);
+    finishJob(job, Status::Succeeded, "Playlist erfolgreich erstellt");
+    return true;
+}
+
+void ImportJobManager::emit(Work& work, ImportEvent&& event) {
+    if (event.type == ImportEvent::Type::SongResolved) work.resolvedCount++;
+    event.songCount = work.setlist ? work.setlist->songs.size() : 0;
+    event.resolvedCount = work.resolvedCount;
+    if (event.isTerminal()) {
+        event.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - work.started);
+    }
+    publish(work.job, event);
+}
+
+void ImportJobManager::fail(Work& work, const std::string& message) {
+    bool cancelled = work.job->cancel.cancelled();
+
+    const std::string reason = cancelled ? "Import abgebrochen" : message;
+
+    ImportEvent failed;
+    failed.type = ImportEvent::Type::Failed;
+    failed.message = reason;
+    emit(work, std::move(failed));
+    releaseJournal(work);
+    finishJob(work.job, cancelled ? Status::Cancelled : Status::Failed, reason);
+}
+
+void ImportJobManager::releaseJournal(Work& work) {
+    if (work.journalId.empty()) return;
+
+    // Erst schlieen, dann freigeben, damit ein Nachfolger das Journal vollstndig liest
+    work.journal.reset();
+    std::lock_guard<std::mutex> lock(mutex_);
+    activeJournals_.erase(work.journalId);
+    work.journalId.clear();
+}
+
+void ImportJobManager::publish(const std::shared_ptr<Job>& job, const ImportEvent& event) {
+    std::vector<EventCallback> receivers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->songCount = event.songCount;
+        job->resolvedCount = event.resolvedCount;
+        if (event.type == ImportEvent::Type::SongResolved || event.type == ImportEvent::Type::SongNotFound) {
+            job->processedCount = event.songIndex + 1;
+        }
+
+        auto& history = history_[job->id];
+        history.push_back(event);
+        if (history.size() > kMaxEventHistory) {
+            history.pop_front();
+        }
+
+        for (const auto& [id, subscription] : subscriptions_) {
+            if (subscription.jobId.empty() || subscription.jobId == job->id) {
+                receivers.push_back(subscription.callback);
+            }
+        }
+    }
+
+    // Auerhalb der Sperre zustellen, damit langsame Empfnger die Worker nicht blockieren
+    for (const auto& receiver : receivers) {
+        receiver(job->id, event);
+    }
+}
+
+void ImportJobManager::finishJob(const std::shared_ptr<Job>& job, Status status, const std::string& message) {
+    bool saveCache = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        job->status = status;
+        job->message = message;
+        job->finished = std::chrono::system_clock::now();
+        finished_.push_back(job->id);
+        evictLocked();
+
+        // Den ganzen Cache zu schreiben kostet bei jedem Job mehr als die Suche spart: erst
+        // speichern, wenn die Pipeline leer ist, bei Dauerlast hchstens alle kCacheSaveInterval
+        if (unfinished_ > 0) unfinished_--;
+        auto now = std::chrono::steady_clock::now();
+        if (unfinished_ == 0 || now - lastCacheSave_ >= kCacheSaveInterval) {
+            lastCacheSave_ = now;
+            saveCache = true;
+        }
+    }
+    if (saveCache) {
+        spotify_.trackCache()->save();
+    }
+}
+
+bool ImportJobManager::expiredLocked(const Job& job, std::chrono::system_clock::time_point now) const {
+    bool finished = job.status == Status::Succeeded || job.status == Status::Failed || job.status == Status::Cancelled;
+    return finished && now - job.finished >= retention_;
+}
+
+void ImportJobManager::evictLocked() {
+    auto now = std::chrono::system_clock::now();
+    while (!finished_.empty()) {
+        auto it = jobs_.find(finished_.front());
+        if (it != jobs_.end() && finished_.size() <= retainedJobs_ && !expiredLocked(*it->second, now)) break;
+
+        if (it != jobs_.end()) jobs_.erase(it);
+        history_.erase(finished_.front());
+        finished_.pop_front();
+    }
+}
@@ -0,0 +1,162 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <chrono>
+#include <nlohmann/json.hpp>
+#include "SetlistFmService.h"
+#include "SpotifyService.h"
+#include "ImportProgress.h"
+#include "ImportJournal.h"
+#include "PipelineStage.h"
+
+/// <summary>
+/// Verwaltet Import-Jobs fr den Server-Modus: begrenzte Warteschlange und Statusabfrage
+/// pro Job. Ein Import durchluft vier Stufen mit eigenen Workern und begrenzten
+/// Warteschlangen dazwischen: fetch (Setlist laden), parse (auswerten, Journal ffnen),
+/// resolve (Tracks suchen) und write (Playlist anlegen und befllen). Auch groe Nachhollufe
+/// laufen so mit gleichmigem Durchsatz und begrenztem Speicher; stages() zeigt den Engpass.
+/// Jobs lassen sich abbrechen; ein laufender Import hrt dann mit dem nchsten Request bzw.
+/// der nchsten Stufe auf und gibt sein Request-Budget frei.
+/// </summary>
+class ImportJobManager {
+public:
+    enum class Status { Queued, Running, Succeeded, Failed, Cancelled };
+
+    struct JobRequest {
+        std::string setlistId;
+        std::string playlistName;       // Leer: Name aus der Setlist ableiten
+        std::string account = TokenStore::kDefaultAccount;   // Spotify-Konto im TokenStore
+        HttpClient::Priority priority = HttpClient::Priority::Normal;   // Klasse aller API-Requests des Jobs
+    };
+
+    struct Job {
+        std::string id;
+        JobRequest request;
+        Status status = Status::Queued;
+        std::string message;
+        std::string playlistId;
+        size_t songCount = 0;
+        size_t processedCount = 0;
+        size_t resolvedCount = 0;
+        std::chrono::system_clock::time_point created;
+        std::chrono::system_clock::time_point finished;
+        CancellationToken cancel = CancellationToken::create();
+    };
+
+    struct Options {
+        size_t fetchWorkers = 2;
+        size_t parseWorkers = 1;
+        size_t resolveWorkers = 4;
+        size_t writeWorkers = 2;
+        size_t queueCapacity = 256;     // Eingangs-Warteschlange (wartende Jobs)
+        size_t stageCapacity = 16;      // Warteschlangen zwischen den Stufen
+        size_t retainedJobs = 1000;     // Beendete Jobs, die abfragbar bleiben (die ltesten fallen heraus)
+        std::chrono::minutes retention{ 60 };   // Beendete Jobs hchstens so lange nach ihrem Ende
+    };
+
+    using EventCallback = std::function<void(const std::string& jobId, const ImportEvent& event)>;
+
+    ImportJobManager(SetlistFmService& setlists, SpotifyService& spotify, const Options& options);
+    ~ImportJobManager();
+
+    // Nimmt alle Jobs oder keinen an; std::nullopt, wenn die Warteschlange voll ist
+    std::optional<std::vector<std::string>> submit(const std::vector<JobRequest>& requests);
+
+    // Beendete Jobs samt Ereignissen werden nach Options::retention bzw. ber
+    // Options::retainedJobs hinaus vergessen und gelten dann als unbekannt
+    std::optional<Job> job(const std::string& id) const;
+
+    // Wartende Jobs werden sofort beendet, laufende beim nchsten Request; beendete bleiben
+    // unverndert. Liefert den Job danach, std::nullopt, wenn er unbekannt ist.
+    std::optional<Job> cancel(const std::string& id);
+
+    // Leere Job-ID: Ereignisse aller Jobs. Fr einen einzelnen Job werden die bisherigen
+    // Ereignisse nachgeliefert; std::nullopt, wenn der Job unbekannt ist.
+    std::optional<uint64_t> subscribe(const std::string& jobId, EventCallback callback);
+    void unsubscribe(uint64_t subscriptionId);
+
+    size_t queueDepth() const;
+    size_t queueCapacity() const;
+    // Stufen in Reihenfolge der Pipeline
+    std::vector<PipelineStageStats> stages() const;
+
+    static const char* toString(Status status);
+    static nlohmann::json toJson(const Job& job);
+    static nlohmann::json toJson(const PipelineStageStats& stage);
+
+private:
+    struct Subscription {
+        std::string jobId;
+        EventCallback callback;
+    };
+
+    // Nachgelieferte Ereignisse pro Job fr spt verbundene Clients
+    static constexpr size_t kMaxEventHistory = 256;
+    // Track-Cache unter Dauerlast hchstens so oft speichern
+    static constexpr std::chrono::seconds kCacheSaveInterval{ 30 };
+
+    // Zustand eines Jobs auf dem Weg durch die Stufen
+    struct Work {
+        std::shared_ptr<Job> job;
+        HttpClient::Response response;                      // fetch -> parse
+        std::optional<SetlistFmService::Setlist> setlist;   // ab parse
+        std::string journalId;                              // belegt in activeJournals_, ab parse
+        std::unique_ptr<ImportJournal> journal;
+        ImportJournal::State checkpoint;
+        std::unique_ptr<SpotifyService> spotify;            // Dienst fr das Konto des Jobs
+        SpotifyService::ResolvedTracks resolved;            // resolve -> write
+        size_t resolvedCount = 0;
+        std::chrono::steady_clock::time_point started;
+        std::chrono::milliseconds writeBudget{ 0 };         // Was resolve vom Import-Budget brig lsst
+    };
+    using WorkItem = std::unique_ptr<Work>;
+
+    // Stufen; false beendet den Job (erledigt, fehlgeschlagen oder abgebrochen)
+    bool fetch(Work& work);
+    bool parse(Work& work);
+    bool resolve(Work& work);
+    bool write(Work& work);
+    // Fngt Ausnahmen der Stufe ab und beendet den Job dann als fehlgeschlagen
+    bool runStage(Work& work, bool (ImportJobManager::*stage)(Work&));
+
+    // Ereignis mit Songanzahl und Trefferzahl des Jobs anreichern und verffentlichen
+    void emit(Work& work, ImportEvent&& event);
+    // Failed-Ereignis und Endstatus; bei einem Abbruch gilt der Job als abgebrochen
+    void fail(Work& work, const std::string& message);
+    void publish(const std::shared_ptr<Job>& job, const ImportEvent& event);
+    // Schliet das Journal des Jobs und gibt es fr sptere Jobs frei
+    void releaseJournal(Work& work);
+    // Setzt den Endstatus; speichert den Track-Cache, wenn kein Job mehr unterwegs ist
+    void finishJob(const std::shared_ptr<Job>& job, Status status, const std::string& message);
+    bool expiredLocked(const Job& job, std::chrono::system_clock::time_point now) const;
+    // Vergisst beendete Jobs ber Anzahl oder Alter hinaus; nur unter mutex_ aufrufen
+    void evictLocked();
+
+    SetlistFmService& setlists_;
+    SpotifyService& spotify_;
+
+    mutable std::mutex mutex_;
+    std::map<std::string, std::shared_ptr<Job>> jobs_;
+    std::map<std::string, std::deque<ImportEvent>> history_;
+    std::deque<std::string> finished_;      // Beendete Jobs in der Reihenfolge ihres Endes
+    std::set<std::string> activeJournals_;  // Journale laufender Jobs; je Journal nur ein Job
+    size_t retainedJobs_;
+    std::chrono::minutes retention_;
+    std::map<uint64_t, Subscription> subscriptions_;
+    uint64_t nextJobId_ = 1;
+    uint64_t nextSubscriptionId_ = 1;
+    size_t unfinished_ = 0;     // Angenommene Jobs ohne Endstatus
+    std::chrono::steady_clock::time_point lastCacheSave_ = std::chrono::steady_clock::now();
+
+    // Nach den brigen Membern, damit die Worker beim Abbau zuerst enden
+    PipelineStage<WorkItem> fetchStage_;
+    PipelineStage<WorkItem> parseStage_;
+    PipelineStage<WorkItem> resolveStage_;
+    PipelineStage<WorkItem> writeStage_;
+};
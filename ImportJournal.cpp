@@ -0,0 +1,180 @@
+#include "ImportJournal.h"
+#include "TokenStore.h"
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <filesystem>
+#include <cctype>
+#include <cstdint>
+
+using json = nlohmann::json;
+
+ImportJournal::ImportJournal(const std::string& jobId, const std::string& directory)
+    : jobId_(jobId) {
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    path_ = (std::filesystem::path(directory) / (jobId + ".journal")).string();
+
+    load();
+    out_.open(path_, std::ios::app | std::ios::binary);
+    if (!out_.is_open()) {
+        std::cerr << "Konnte Import-Journal nicht ffnen: " << path_ << std::endl;
+    }
+}
+
+std::string ImportJournal::makeJobId(const std::string& setlistId, const std::string& playlistName,
+    const std::string& account) {
+    // Das Standardkonto behlt das bisherige Format, damit ltere Journale weiter fortgesetzt werden
+    const bool otherAccount = account != TokenStore::kDefaultAccount;
+
+    // FNV-1a, damit die ID ber Prozess-Neustarts hinweg stabil bleibt
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](unsigned char c) {
+        hash ^= c;
+        hash *= 1099511628211ull;
+    };
+    if (otherAccount) {
+        for (unsigned char c : account) mix(c);
+        mix('\0');
+    }
+    for (unsigned char c : playlistName) mix(c);
+
+    auto sanitize = [](std::ostringstream& out, const std::string& text) {
+        for (char c : text) {
+            out << (std::isalnum(static_cast<unsigned char>(c)) ? c : '_');
+        }
+    };
+    std::ostringstream id;
+    sanitize(id, setlistId);
+    if (otherAccount) {
+        id << "-";
+        sanitize(id, account);
+    }
+    id << "-" << std::hex << std::setw(16) << std::setfill('0') << hash;
+    return id.str();
+}
+
+ImportJournal::State ImportJournal::state() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_;
+}
+
+bool ImportJournal::hasProgress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_.playlistId.has_value() || !state_.resolvedTracks.empty();
+}
+
+bool ImportJournal::bindVersion(const std::string& versionId) {
+    // Ohne versionId (z.B. aus einem alten Cache) lsst sich nichts prfen
+    if (versionId.empty()) return true;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_.setlistVersion == versionId) return true;
+
+    bool hadProgress = state_.playlistId.has_value() || !state_.resolvedTracks.empty() || state_.completed;
+    if (!hadProgress) {
+        appendLocked({ {"type", "version"}, {"id", versionId} });
+        return true;
+    }
+
+    std::cerr << "Import-Journal " << jobId_ << ": Setlist wurde seit dem letzten Lauf gendert, "
+        "Import beginnt neu." << std::endl;
+    restartLocked(versionId);
+    return false;
+}
+
+void ImportJournal::recordPlaylist(const std::string& playlistId) {
+    append({ {"type", "playlist"}, {"id", playlistId} });
+}
+
+void ImportJournal::recordTrack(size_t songIndex, const std::string& trackId) {
+    append({ {"type", "track"}, {"index", songIndex}, {"id", trackId} });
+}
+
+void ImportJournal::recordChunk(const std::vector<size_t>& songIndices) {
+    append({ {"type", "chunk"}, {"songs", songIndices} });
+}
+
+void ImportJournal::markCompleted() {
+    append({ {"type", "done"} });
+}
+
+void ImportJournal::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    restartLocked(state_.setlistVersion);
+}
+
+void ImportJournal::restartLocked(std::optional<std::string> setlistVersion) {
+    out_.close();
+    out_.open(path_, std::ios::trunc | std::ios::binary);
+    state_ = State{};
+    if (setlistVersion) {
+        appendLocked({ {"type", "version"}, {"id", *setlistVersion} });
+    }
+}
+
+void ImportJournal::load() {
+    std::ifstream file(path_, std::ios::binary);
+    if (!file.is_open()) return;
+
+    std::string line;
+    uintmax_t validBytes = 0;
+    bool truncated = false;
+    while (std::getline(file, line)) {
+        if (!line.empty()) {
+            try {
+                apply(json::parse(line));
+            }
+            catch (const json::exception&) {
+                truncated = true;
+                break;
+            }
+        }
+        validBytes += line.size() + 1;
+    }
+    file.close();
+
+    // Abgeschnittene letzte Zeile nach einem Absturz entfernen, damit neue Eintrge sauber anschlieen
+    if (truncated) {
+        std::cerr << "Import-Journal " << jobId_ << ": unvollstndiger Eintrag verworfen." << std::endl;
+        std::error_code ec;
+        std::filesystem::resize_file(path_, validBytes, ec);
+    }
+}
+
+void ImportJournal::apply(const json& record) {
+    std::string type = record.at("type").get<std::string>();
+    if (type == "version") {
+        state_.setlistVersion = record.at("id").get<std::string>();
+    }
+    else if (type == "playlist") {
+        state_.playlistId = record.at("id").get<std::string>();
+    }
+    else if (type == "track") {
+        state_.resolvedTracks[record.at("index").get<size_t>()] = record.at("id").get<std::string>();
+    }
+    else if (type == "chunk") {
+        for (size_t index : record.at("songs")) {
+            state_.committedSongs.insert(index);
+        }
+        state_.committedChunks++;
+    }
+    else if (type == "done") {
+        state_.completed = true;
+    }
+}
+
+void ImportJournal::append(const json& record) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    appendLocked(record);
+}
+
+void ImportJournal::appendLocked(const json& record) {
+    apply(record);
+
+    // Jeder Eintrag wird sofort geschrieben, damit er einen Absturz bersteht
+    if (out_.is_open()) {
+        out_ << record.dump() << '\n';
+        out_.flush();
+    }
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <string>
+#include <optional>
+#include <vector>
+#include <map>
+#include <set>
+#include <mutex>
+#include <fstream>
+#include <nlohmann/json.hpp>
+
+/// <summary>
+/// Persistentes Checkpoint-Journal eines Imports. Hlt die erstellte Playlist-ID,
+/// die aufgelsten Track-IDs pro Song-Index und die bereits geschriebenen Chunks fest,
+/// damit ein abgebrochener Import genau dort fortgesetzt werden kann.
+/// </summary>
+class ImportJournal {
+public:
+    struct State {
+        std::optional<std::string> setlistVersion;      // versionId der Setlist, zu der die Song-Indizes gehren
+        std::optional<std::string> playlistId;
+        std::map<size_t, std::string> resolvedTracks;   // Song-Index -> Track-ID
+        std::set<size_t> committedSongs;                // Bereits in der Playlist
+        size_t committedChunks = 0;
+        bool completed = false;
+    };
+
+    explicit ImportJournal(const std::string& jobId, const std::string& directory = "imports");
+
+    // Stabile Job-ID aus Setlist-ID, Playlist-Name und Spotify-Konto; jedes Konto hat eigene Checkpoints
+    static std::string makeJobId(const std::string& setlistId, const std::string& playlistName,
+        const std::string& account);
+
+    const std::string& jobId() const { return jobId_; }
+    State state() const;
+    bool hasProgress() const;
+
+    // Bindet das Journal an einen Stand der Setlist (versionId von setlist.fm). Stammen die
+    // Checkpoints von einem anderen oder unbekannten Stand, passen die Song-Indizes nicht mehr
+    // zur Setlist: Dann beginnt das Journal neu. false, wenn dabei Fortschritt verworfen wurde.
+    bool bindVersion(const std::string& versionId);
+
+    void recordPlaylist(const std::string& playlistId);
+    void recordTrack(size_t songIndex, const std::string& trackId);
+    void recordChunk(const std::vector<size_t>& songIndices);
+    void markCompleted();
+
+    // Verwirft das Journal (z.B. fr einen bewusst neuen Import); der Stand der Setlist bleibt vermerkt
+    void reset();
+
+private:
+    void load();
+    void apply(const nlohmann::json& record);
+    void append(const nlohmann::json& record);
+    // Nur unter mutex_ aufrufen
+    void appendLocked(const nlohmann::json& record);
+    void restartLocked(std::optional<std::string> setlistVersion);
+
+    std::string jobId_;
+    std::string path_;
+    State state_;
+    std::ofstream out_;
+    mutable std::mutex mutex_;
+};
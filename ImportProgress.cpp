@@ -0,0 +1,49 @@
+#include "ImportProgress.h"
+
+const char* ImportEvent::toString(Type type) {
+    switch (type) {
+    case Type::Started: return "started";
+    case Type::PlaylistCreated: return "playlist_created";
+    case Type::SongResolved: return "song_resolved";
+    case Type::SongNotFound: return "song_not_found";
+    case Type::ChunkWritten: return "chunk_written";
+    case Type::Finished: return "finished";
+    case Type::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+nlohmann::json ImportEvent::toJson() const {
+    nlohmann::json j = {
+        {"type", toString(type)},
+        {"song_count", songCount},
+        {"resolved_count", resolvedCount},
+        {"duration_ms", duration.count()}
+    };
+
+    switch (type) {
+    case Type::SongResolved:
+        j["track_id"] = trackId;
+        j["from_checkpoint"] = fromCheckpoint;
+        [[fallthrough]];
+    case Type::SongNotFound:
+        j["song_index"] = songIndex;
+        j["title"] = title;
+        j["artist"] = artist;
+        break;
+    case Type::ChunkWritten:
+        j["chunk_size"] = chunkSize;
+        break;
+    case Type::PlaylistCreated:
+        j["from_checkpoint"] = fromCheckpoint;
+        [[fallthrough]];
+    case Type::Finished:
+        j["playlist_id"] = playlistId;
+        break;
+    default:
+        break;
+    }
+
+    if (!message.empty()) j["message"] = message;
+    return j;
+}
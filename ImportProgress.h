@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <chrono>
+#include <functional>
+#include <nlohmann/json.hpp>
+
+/// <summary>
+/// Fortschrittsereignis eines Imports. Wird von SpotifyService::importSetlistToSpotify
+/// pro Song, pro geschriebenem Chunk sowie zu Beginn und Ende ausgelst.
+/// </summary>
+struct ImportEvent {
+    enum class Type {
+        Started,
+        PlaylistCreated,
+        SongResolved,
+        SongNotFound,
+        ChunkWritten,
+        Finished,
+        Failed
+    };
+
+    Type type = Type::Started;
+    size_t songIndex = 0;               // Song-Events: Position in der Setlist
+    size_t songCount = 0;               // Anzahl Songs des Imports
+    std::string title;
+    std::string artist;
+    std::string trackId;                // SongResolved
+    std::string playlistId;             // PlaylistCreated, Finished
+    size_t chunkSize = 0;               // ChunkWritten
+    size_t resolvedCount = 0;           // Bisher gefundene Songs
+    bool fromCheckpoint = false;        // Ergebnis stammt aus dem Import-Journal
+    std::chrono::milliseconds duration{ 0 };   // Dauer der Suche, des Chunks bzw. des gesamten Imports
+    std::string message;
+
+    bool isTerminal() const { return type == Type::Finished || type == Type::Failed; }
+
+    static const char* toString(Type type);
+    nlohmann::json toJson() const;
+};
+
+using ImportObserver = std::function<void(const ImportEvent&)>;
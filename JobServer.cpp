@@ -0,0 +1,353 @@
+#include "JobServer.h"
+#include "CallbackServer.h"
+#include "ConfigLoader.h"
+#include "ImportJobManager.h"
+#include "SetlistFmService.h"
+#include "SetlistCache.h"
+#include "SpotifyService.h"
+#include "Executor.h"
+#include "ConfigWatcher.h"
+#include "CacheWarmer.h"
+#include "CacheBundle.h"
+#include <iostream>
+#include <thread>
+#include <vector>
+#include <csignal>
+
+using json = nlohmann::json;
+
+bool JobServer::isServerInvocation(int argc, char** argv) {
+    return argc > 1 && std::string(argv[1]) == "--server";
+}
+
+JobServer::Options JobServer::parseArguments(int argc, char** argv) {
+    Options options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        if (key == "--config") options.configFile = value;
+        else if (key == "--port") options.port = static_cast<uint16_t>(std::stoi(value));
+        else if (key == "--io-threads") options.ioThreads = std::stoul(value);
+        else if (key == "--workers") options.workers = std::stoul(value);
+        else if (key == "--queue") options.queueCapacity = std::stoul(value);
+        else std::cerr << "Unbekannte Option ignoriert: " << key << std::endl;
+    }
+    return options;
+}
+
+int JobServer::run(const Options& requested) {
+    try {
+        // Konfiguration laden und Services initialisieren
+        auto config = ConfigLoader::loadConfig(requested.configFile);
+
+        // Nicht angegebene Schalter kommen aus der Konfiguration
+        Options options = requested;
+        if (options.port == 0) options.port = ConfigLoader::callbackPort(config.spotify.redirect_uri);
+        if (options.workers == 0) options.workers = config.performance.workers.importWorkers;
+        Executor::configure(config.performance.workers.executorThreads);
+
+        SpotifyService spotify(SpotifyService::AuthConfig{
+            config.spotify.client_id,
+            config.spotify.client_secret,
+            config.spotify.redirect_uri
+            }, config.performance.http);
+        SetlistFmService setlists(SetlistFmService::Config{ config.setlistfm.api_key }, config.performance.http);
+        spotify.applyPerformance(config.performance);
+        setlists.applyPerformance(config.performance);
+
+        // Nutzt ruhige Phasen, um die Caches fr die beobachteten Knstler vorzuwrmen
+        CacheWarmer warmer(setlists, spotify, config.performance.warming);
+
+        // Genderte Performance-Einstellungen ohne Neustart bernehmen
+        std::unique_ptr<ConfigWatcher> configWatcher;
+        if (config.performance.hotReload) {
+            configWatcher = std::make_unique<ConfigWatcher>(options.configFile, config.performance,
+                [&spotify, &setlists, &warmer](const ConfigLoader::PerformanceConfig& performance) {
+                    spotify.applyPerformance(performance);
+                    setlists.applyPerformance(performance);
+                    warmer.apply(performance.warming);
+                });
+        }
+
+        // Start-Aufgaben parallel zum Server-Start: Token laden, beide API-Hosts vorwrmen,
+        // Caches laden. Sie referenzieren die Services, daher wird beim Verlassen auf sie gewartet.
+        struct StartupTasks {
+            std::vector<std::future<bool>> tasks;
+            ~StartupTasks() {
+                for (auto& task : tasks) {
+                    if (task.valid()) task.wait();
+                }
+            }
+        } startup;
+
+        auto& executor = Executor::instance();
+        auto tokenLoaded = executor.submit([&spotify]() { return spotify.loadTokenFromFile(); });
+        startup.tasks.push_back(executor.submit([&spotify]() { return spotify.prewarm(); }));
+        startup.tasks.push_back(executor.submit([&setlists]() { return setlists.prewarm(); }));
+        startup.tasks.push_back(executor.submit([&spotify]() { return spotify.trackCache()->load(); }));
+        startup.tasks.push_back(executor.submit([&setlists]() { return setlists.setlistCache()->load(); }));
+        // Ein neuer Worker startet mit dem Bundle warm; bei Dubletten gewinnt der neuere Eintrag
+        startup.tasks.push_back(executor.submit([&spotify, &setlists, bundle = config.performance.cache.warmStartBundle]() {
+            return CacheBundle::warmStart(bundle, *spotify.trackCache(), *setlists.setlistCache());
+            }));
+
+        net::io_context ioc;
+        CallbackServer server(ioc, options.port);
+        ImportJobManager::Options pipeline;
+        pipeline.fetchWorkers = config.performance.workers.fetchWorkers;
+        pipeline.parseWorkers = config.performance.workers.parseWorkers;
+        pipeline.resolveWorkers = options.workers;
+        pipeline.writeWorkers = config.performance.workers.writeWorkers;
+        pipeline.queueCapacity = options.queueCapacity;
+        pipeline.stageCapacity = config.performance.workers.stageQueue;
+        ImportJobManager manager(setlists, spotify, pipeline);
+
+        // GET /imports/{id}
+        server.addRoute(http::verb::get, "/imports/", [&manager](const CallbackServer::Request& request) {
+            std::string target(request.target());
+            std::string id = target.substr(std::string("/imports/").size());
+            id = id.substr(0, id.find('?'));
+
+            auto job = manager.job(id);
+            if (!job) {
+                return CallbackServer::makeResponse(request, http::status::not_found, "{\"error\":\"unknown job\"}");
+            }
+            return CallbackServer::makeResponse(request, http::status::ok, ImportJobManager::toJson(*job).dump());
+            });
+
+        // DELETE /imports/{id}: wartende Jobs sofort, laufende beim nchsten Request beenden
+        server.addRoute(http::verb::delete_, "/imports/", [&manager](const CallbackServer::Request& request) {
+            std::string target(request.target());
+            std::string id = target.substr(std::string("/imports/").size());
+            id = id.substr(0, id.find('?'));
+
+            auto job = manager.cancel(id);
+            if (!job) {
+                return CallbackServer::makeResponse(request, http::status::not_found, "{\"error\":\"unknown job\"}");
+            }
+            auto status = http::status::ok;
+            if (job->status == ImportJobManager::Status::Running) {
+                status = http::status::accepted;
+            }
+            else if (job->status != ImportJobManager::Status::Cancelled) {
+                status = http::status::conflict;
+            }
+            return CallbackServer::makeResponse(request, status, ImportJobManager::toJson(*job).dump());
+            });
+
+        // GET /imports
+        server.addRoute(http::verb::get, "/imports", [&manager](const CallbackServer::Request& request) {
+            json stages = json::array();
+            std::string bottleneck;
+            double busiest = -1.0;
+            for (const auto& stage : manager.stages()) {
+                stages.push_back(ImportJobManager::toJson(stage));
+                // Engpass: die am strksten ausgelastete Stufe
+                if (stage.utilization > busiest) {
+                    busiest = stage.utilization;
+                    bottleneck = stage.name;
+                }
+            }
+            json body = {
+                {"queue_depth", manager.queueDepth()},
+                {"queue_capacity", manager.queueCapacity()},
+                {"stages", stages},
+                {"bottleneck", bottleneck}
+            };
+            return CallbackServer::makeResponse(request, http::status::ok, body.dump());
+            });
+
+        // POST /imports
+        server.addRoute(http::verb::post, "/imports", [&manager](const CallbackServer::Request& request) {
+            std::vector<ImportJobManager::JobRequest> jobs;
+            try {
+                auto body = json::parse(request.body());
+                std::string playlistName = body.value("playlist_name", "");
+                std::string account = body.value("account", std::string(TokenStore::kDefaultAccount));
+                auto priority = HttpClient::parsePriority(body.value("priority", "normal"));
+                if (!priority) {
+                    return CallbackServer::makeResponse(request, http::status::bad_request,
+                        "{\"error\":\"priority must be interactive, normal or background\"}");
+                }
+
+                if (body.contains("setlist_ids")) {
+                    for (const auto& id : body["setlist_ids"]) {
+                        jobs.push_back({ id.get<std::string>(), "", account, *priority });
+                    }
+                }
+                else if (body.contains("setlist_id")) {
+                    jobs.push_back({ body["setlist_id"].get<std::string>(), "", account, *priority });
+                }
+
+                // Ein eigener Playlist-Name ist nur fr einzelne Setlists sinnvoll
+                if (jobs.size() == 1) {
+                    jobs[0].playlistName = playlistName;
+                }
+            }
+            catch (const json::exception& e) {
+                json error = { {"error", std::string("invalid request: ") + e.what()} };
+                return CallbackServer::makeResponse(request, http::status::bad_request, error.dump());
+            }
+
+            if (jobs.empty()) {
+                return CallbackServer::makeResponse(request, http::status::bad_request,
+                    "{\"error\":\"setlist_ids missing\"}");
+            }
+
+            auto ids = manager.submit(jobs);
+            if (!ids) {
+                // Backpressure: Warteschlange voll
+                json error = {
+                    {"error", "queue full"},
+                    {"queue_depth", manager.queueDepth()},
+                    {"queue_capacity", manager.queueCapacity()}
+                };
+                auto response = CallbackServer::makeResponse(request, http::status::service_unavailable, error.dump());
+                response.set(http::field::retry_after, "5");
+                return response;
+            }
+
+            json accepted = json::array();
+            for (size_t i = 0; i < ids->size(); i++) {
+                accepted.push_back({ {"id", (*ids)[i]}, {"setlist_id", jobs[i].setlistId} });
+            }
+            auto response = CallbackServer::makeResponse(request, http::status::accepted,
+                json{ {"jobs", accepted} }.dump());
+            if (ids->size() == 1) {
+                response.set(http::field::location, "/imports/" + ids->front());
+            }
+            return response;
+            });
+
+        // GET /events (alle Jobs) bzw. /events/{id} (ein Job) als Server-Sent Events
+        server.addStreamRoute("/events", [&manager](const CallbackServer::Request& request,
+            std::shared_ptr<CallbackServer::EventStream> stream) -> std::optional<CallbackServer::Response> {
+            std::string target(request.target());
+            target = target.substr(0, target.find('?'));
+
+            std::string jobId;
+            if (target.rfind("/events/", 0) == 0) {
+                jobId = target.substr(std::string("/events/").size());
+            }
+            else if (target != "/events") {
+                return CallbackServer::makeResponse(request, http::status::not_found, "{\"error\":\"not found\"}");
+            }
+
+            // Der Stream hlt sich selbst am Leben, solange die Verbindung offen ist
+            std::weak_ptr<CallbackServer::EventStream> weakStream = stream;
+            bool singleJob = !jobId.empty();
+            auto subscription = manager.subscribe(jobId,
+                [weakStream, singleJob](const std::string& id, const ImportEvent& event) {
+                    auto eventStream = weakStream.lock();
+                    if (!eventStream) return;
+
+                    auto data = event.toJson();
+                    data["job_id"] = id;
+                    eventStream->send(ImportEvent::toString(event.type), data.dump());
+
+                    // Stream eines einzelnen Jobs endet mit dessen letztem Ereignis
+                    if (singleJob && event.isTerminal()) {
+                        eventStream->close();
+                    }
+                });
+
+            if (!subscription) {
+                return CallbackServer::makeResponse(request, http::status::not_found, "{\"error\":\"unknown job\"}");
+            }
+
+            stream->onClose([&manager, id = *subscription]() { manager.unsubscribe(id); });
+            return std::nullopt;
+            });
+
+        // POST /accounts/{name}/authorize: startet die Anmeldung eines weiteren Kontos.
+        // Beliebig viele Anmeldungen knnen gleichzeitig laufen, der Redirect findet ber state zurck.
+        server.addRoute(http::verb::post, "/accounts/", [&server, &spotify](const CallbackServer::Request& request) {
+            std::string target(request.target());
+            target = target.substr(0, target.find('?'));
+
+            const std::string prefix = "/accounts/";
+            const std::string suffix = "/authorize";
+            if (target.size() <= prefix.size() + suffix.size() ||
+                target.compare(target.size() - suffix.size(), suffix.size(), suffix) != 0) {
+                return CallbackServer::makeResponse(request, http::status::not_found, "{\"error\":\"not found\"}");
+            }
+            std::string account = target.substr(prefix.size(), target.size() - prefix.size() - suffix.size());
+            if (account.find('/') != std::string::npos) {
+                return CallbackServer::makeResponse(request, http::status::bad_request,
+                    "{\"error\":\"invalid account name\"}");
+            }
+
+            // Der Handler luft bereits auf dem Executor, der Token-Tausch blockiert also keinen I/O-Thread
+            std::string state = server.beginAuthorization([&spotify, account](std::optional<std::string> code) {
+                if (!code) {
+                    std::cerr << "Anmeldung fr Konto '" << account << "' abgebrochen" << std::endl;
+                    return;
+                }
+                if (spotify.forAccount(account)->requestAccessToken(*code)) {
+                    std::cout << "Konto '" << account << "' angemeldet" << std::endl;
+                }
+                else {
+                    std::cerr << "Fehler bei der Anmeldung von Konto '" << account << "'" << std::endl;
+                }
+                });
+
+            json body = {
+                {"account", account},
+                {"state", state},
+                {"authorize_url", spotify.authorizationUrl(state)},
+                {"expires_in", 600}
+            };
+            return CallbackServer::makeResponse(request, http::status::ok, body.dump());
+            });
+
+        // GET /accounts: angemeldete Konten und offene Anmeldungen
+        server.addRoute(http::verb::get, "/accounts", [&server, &spotify](const CallbackServer::Request& request) {
+            json body = {
+                {"accounts", spotify.tokenStore()->accounts()},
+                {"pending", server.pendingAuthorizations()}
+            };
+            return CallbackServer::makeResponse(request, http::status::ok, body.dump());
+            });
+
+        // Derselbe Server nimmt auch die OAuth-Redirects entgegen, zugeordnet ber state
+        server.start();
+
+        if (!tokenLoaded.get()) {
+            std::string state = server.beginAuthorization([&spotify](std::optional<std::string> code) {
+                if (code && spotify.requestAccessToken(*code)) {
+                    std::cout << "Authentifizierung erfolgreich!" << std::endl;
+                }
+                else {
+                    std::cerr << "Fehler bei der Authentifizierung" << std::endl;
+                }
+                });
+            std::cout << "Bitte authentifiziere dich bei Spotify:\n" << spotify.authorizationUrl(state) << std::endl;
+        }
+
+        // Sauber beenden bei Strg+C
+        net::signal_set signals(ioc, SIGINT, SIGTERM);
+        signals.async_wait([&ioc](const beast::error_code&, int) {
+            ioc.stop();
+            });
+
+        std::cout << "Job-Server luft auf http://127.0.0.1:" << options.port
+            << " (" << options.ioThreads << " I/O-Threads, Worker fetch/parse/resolve/write "
+            << pipeline.fetchWorkers << "/" << pipeline.parseWorkers << "/" << pipeline.resolveWorkers << "/"
+            << pipeline.writeWorkers << ", Warteschlange " << options.queueCapacity << ")" << std::endl;
+
+        std::vector<std::thread> threads;
+        for (size_t i = 1; i < options.ioThreads; i++) {
+            threads.emplace_back([&ioc]() { ioc.run(); });
+        }
+        ioc.run();
+        for (auto& thread : threads) {
+            thread.join();
+        }
+
+        return 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Fehler: " << e.what() << std::endl;
+        return 1;
+    }
+}
@@ -0,0 +1,28 @@
+#pragma once
+#include <string>
+#include <cstdint>
+
+/// <summary>
+/// Server-Modus ohne Fenster: stellt die Import-Job-API ber den CallbackServer bereit.
+///   POST /imports        {"setlist_ids": [...], "playlist_name": "..."}
+///   GET  /imports/{id}   Status eines Jobs; beendete Jobs nur eine begrenzte Zeit, danach 404
+///   GET  /imports        Auslastung der Warteschlange und der Pipeline-Stufen
+///   POST /accounts/{name}/authorize   Anmeldung eines Kontos starten (liefert authorize_url)
+///   GET  /accounts       Angemeldete Konten und offene Anmeldungen
+/// </summary>
+class JobServer {
+public:
+    struct Options {
+        std::string configFile = "accessData.json";
+        uint16_t port = 0;              // 0 = Port aus spotify.redirect_uri
+        size_t ioThreads = 2;
+        size_t workers = 0;             // Stufe resolve; 0 = performance.workers.import_workers
+        size_t queueCapacity = 256;
+    };
+
+    // Erwartet "--server" als erstes Argument, gefolgt von optionalen Schaltern
+    static bool isServerInvocation(int argc, char** argv);
+    static Options parseArguments(int argc, char** argv);
+
+    static int run(const Options& options);
+};
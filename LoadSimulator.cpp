@@ -0,0 +1,830 @@
+#include "LoadSimulator.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <deque>
+#include <random>
+#include <cmath>
+#include <memory>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    // Virtuelle Zeit in Mikrosekunden seit Simulationsbeginn
+    using Micros = int64_t;
+    constexpr Micros kMicrosPerMs = 1000;
+
+    enum HostId : size_t { kSpotify, kSetlistFm, kAccounts, kHostCount };
+    const char* const kHostNames[kHostCount] = { "api.spotify.com", "api.setlist.fm", "accounts.spotify.com" };
+
+    // Wie SpotifyService: Tracks pro Request beim Hinzufgen zur Playlist
+    constexpr size_t kTracksPerRequest = 100;
+    // Wie TokenStore::Options::retryDelay nach einem fehlgeschlagenen Refresh
+    constexpr Micros kTokenRetryDelay = 30 * 1000 * kMicrosPerMs;
+    // Das Hedge-Perzentil wird nicht nach jedem Messwert neu bestimmt
+    constexpr size_t kHedgeRecomputeInterval = 32;
+    constexpr size_t kLatencyWindow = 512;
+
+    // Quantil der Standardnormalverteilung fr p99
+    constexpr double kZ99 = 2.326348;
+
+    double percentileOf(std::vector<float>& values, double p) {
+        if (values.empty()) return 0.0;
+        size_t index = static_cast<size_t>(p * (values.size() - 1) + 0.5);
+        std::nth_element(values.begin(), values.begin() + index, values.end());
+        return values[index];
+    }
+
+    LoadSimulator::ServerModel serverFromJson(const json& j, LoadSimulator::ServerModel server) {
+        server.medianMs = j.value("median_ms", server.medianMs);
+        server.p99Ms = j.value("p99_ms", server.p99Ms);
+        server.errorRate = j.value("error_rate", server.errorRate);
+        server.rateLimit = j.value("rate_limit", server.rateLimit);
+        server.rateWindowMs = static_cast<long>(j.value("rate_window_s", server.rateWindowMs / 1000.0) * 1000);
+        server.retryAfterS = j.value("retry_after_s", server.retryAfterS);
+        return server;
+    }
+
+    /// Ein Durchlauf einer Konfiguration: Ereigniswarteschlange, Server, Host-Limits und Importe
+    class Simulation {
+    public:
+        Simulation(const LoadSimulator::Scenario& scenario, const LoadSimulator::Configuration& configuration)
+            : scenario_(scenario), performance_(configuration.performance), options_(configuration.performance.http),
+            workloadRandom_(scenario.seed), random_(scenario.seed + 1) {
+            report_.name = configuration.name;
+            servers_[kSpotify] = &scenario.spotify;
+            servers_[kSetlistFm] = &scenario.setlistFm;
+            servers_[kAccounts] = &scenario.accounts;
+            for (size_t host = 0; host < kHostCount; host++) {
+                const auto& server = *servers_[host];
+                double sigma = server.p99Ms > server.medianMs ? std::log(server.p99Ms / server.medianMs) / kZ99 : 1e-6;
+                latency_[host] = std::lognormal_distribution<double>(std::log(std::max(server.medianMs, 0.001)), sigma);
+            }
+            end_ = static_cast<Micros>(scenario.durationHours * 3600.0 * 1000.0 * kMicrosPerMs);
+        }
+
+        LoadSimulator::Report execute() {
+            auto wallStart = std::chrono::steady_clock::now();
+
+            // Der erste Token ist beim Start gerade frisch
+            tokenExpiresAt_ = scenario_.tokenLifetimeS * 1000 * kMicrosPerMs;
+            scheduleBackgroundRefresh();
+            scheduleNextArrival();
+
+            while (!events_.empty()) {
+                // Nach dem Ende laufen nur noch die angefangenen Importe aus
+                if (events_.top().at > end_ && activeImports_ == 0 && jobQueue_.empty()) break;
+                Event event = std::move(const_cast<Event&>(events_.top()));
+                events_.pop();
+                now_ = event.at;
+                event.action();
+            }
+
+            report_.simulatedSeconds = static_cast<double>(std::max(now_, end_)) / (1000.0 * kMicrosPerMs);
+            std::vector<float> all;
+            for (auto& [priority, samples] : callLatencies_) {
+                report_.p95ByPriority[priority] = percentileOf(samples, 0.95);
+                all.insert(all.end(), samples.begin(), samples.end());
+            }
+            report_.p50Ms = percentileOf(all, 0.50);
+            report_.p95Ms = percentileOf(all, 0.95);
+            report_.p99Ms = percentileOf(all, 0.99);
+            report_.importP50Ms = percentileOf(importLatencies_, 0.50);
+            report_.importP95Ms = percentileOf(importLatencies_, 0.95);
+            report_.wallTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+                std::chrono::steady_clock::now() - wallStart);
+            return report_;
+        }
+
+    private:
+        struct Event {
+            Micros at;
+            uint64_t sequence;          // Gleichzeitige Ereignisse in Planungsreihenfolge
+            std::function<void()> action;
+        };
+
+        struct Later {
+            bool operator()(const Event& a, const Event& b) const {
+                return a.at != b.at ? a.at > b.at : a.sequence > b.sequence;
+            }
+        };
+
+        struct Outcome {
+            long status = 0;
+            bool timedOut = false;
+            bool ok() const { return !timedOut && status >= 200 && status < 300; }
+        };
+
+        // Ein HttpClient::perform() bzw. performAsync(); beide wiederholen nach derselben Regel
+        struct Call {
+            HostId host;
+            HttpClient::Request request;
+            HttpClient::Priority priority;
+            Micros start = 0;
+            std::optional<Micros> deadline;                 // Import-Budget
+            std::shared_ptr<bool> cancelled;                // Kaskaden-Varianten nach einem Treffer
+            bool async = false;                             // performAsync() hedgt nicht
+            size_t attempt = 0;
+            std::function<void(const Outcome&)> done;
+        };
+        using CallPtr = std::shared_ptr<Call>;
+
+        struct Pending {
+            CallPtr call;
+            Micros expires;             // Ende des Timeouts dieses Versuchs
+        };
+
+        struct HostState {
+            long inFlight = 0;
+            long backgroundInFlight = 0;
+            std::vector<HttpClient::Waiter> waiting;
+            std::unordered_map<uint64_t, Pending> pending;
+            std::deque<Micros> window;                      // Requests im Rate-Limit-Fenster
+            std::vector<double> samples;                    // Ringpuffer der Latenzen fr das Hedging
+            size_t next = 0;
+            size_t sinceRecompute = 0;
+            long hedgeDelayMs = 0;
+        };
+
+        struct Served {
+            long status;
+            long latencyMs;
+            long retryAfterS = 0;
+        };
+
+        struct Import {
+            Micros arrived;
+            HttpClient::Priority priority;
+            std::vector<bool> cached;   // Pro Song: im Track-Cache
+            size_t next = 0;
+            size_t found = 0;
+            size_t chunksLeft = 0;
+            Micros deadline = 0;
+        };
+        using ImportPtr = std::shared_ptr<Import>;
+
+        // --- Ereignisse ---
+
+        void at(Micros when, std::function<void()> action) {
+            events_.push({ std::max(when, now_), nextSequence_++, std::move(action) });
+        }
+
+        static std::chrono::steady_clock::time_point toTimePoint(Micros micros) {
+            return std::chrono::steady_clock::time_point(std::chrono::microseconds(micros));
+        }
+
+        // --- Server ---
+
+        Served serve(HostId host) {
+            report_.sent++;
+            const auto& server = *servers_[host];
+            auto& state = hosts_[host];
+            long latencyMs = std::max(1L, static_cast<long>(latency_[host](random_)));
+
+            if (host == kSpotify && now_ >= tokenExpiresAt_) {
+                report_.unauthorized++;
+                return { 401, latencyMs };
+            }
+
+            if (server.rateLimit > 0) {
+                Micros window = server.rateWindowMs * kMicrosPerMs;
+                while (!state.window.empty() && now_ - state.window.front() >= window) {
+                    state.window.pop_front();
+                }
+                bool limited = state.window.size() >= static_cast<size_t>(server.rateLimit);
+                Micros oldest = state.window.empty() ? now_ : state.window.front();
+                state.window.push_back(now_);
+                if (limited) {
+                    report_.throttled++;
+                    long retryAfter = server.retryAfterS;
+                    if (retryAfter <= 0) {
+                        Micros free = oldest + window - now_;
+                        retryAfter = std::max(1L, static_cast<long>((free + 1000 * kMicrosPerMs - 1) / (1000 * kMicrosPerMs)));
+                    }
+                    return { 429, latencyMs, retryAfter };
+                }
+            }
+
+            std::uniform_real_distribution<double> chance(0.0, 1.0);
+            if (server.errorRate > 0 && chance(random_) < server.errorRate) {
+                return { 503, latencyMs };
+            }
+            return { 200, latencyMs };
+        }
+
+        // --- HttpClient ---
+
+        long hostLimit(HostId host) const {
+            const auto& limits = options_.hostLimits;
+            auto it = limits.perHost.find(kHostNames[host]);
+            long limit = it != limits.perHost.end() ? it->second : limits.defaultMaxInFlight;
+            // Mit HTTP/2 teilen sich alle Requests an Spotify wenige Verbindungen; mehr Streams gibt es nicht
+            if (host == kSpotify && options_.http2.enabled) {
+                long streams = std::max(1L, options_.http2.maxConcurrentStreams * std::max(1L, options_.http2.maxHostConnections));
+                limit = limit > 0 ? std::min(limit, streams) : streams;
+            }
+            return limit;
+        }
+
+        std::optional<long> timeoutMs(const Call& call) const {
+            long timeout = options_.timeouts.requestTimeoutMs;
+            if (call.deadline) {
+                Micros remaining = *call.deadline - now_;
+                if (remaining <= 0) return std::nullopt;
+                timeout = std::min<long>(timeout, static_cast<long>(remaining / kMicrosPerMs));
+            }
+            return timeout > 0 ? std::optional<long>(timeout) : std::nullopt;
+        }
+
+        void perform(CallPtr call) {
+            call->start = now_;
+            attempt(std::move(call));
+        }
+
+        void attempt(CallPtr call) {
+            call->attempt++;
+            auto timeout = timeoutMs(*call);
+            if (!timeout) {
+                complete(call, { 0, true });
+                return;
+            }
+
+            auto& state = hosts_[call->host];
+            uint64_t ticket = nextTicket_++;
+            Micros expires = now_ + *timeout * kMicrosPerMs;
+            state.waiting.push_back({ ticket, call->priority, toTimePoint(now_) });
+            state.pending[ticket] = { call, expires };
+
+            // Wer bis zum Timeout keinen Platz bekommt, gibt auf
+            HostId host = call->host;
+            at(expires, [this, host, ticket]() {
+                auto& state = hosts_[host];
+                auto it = state.pending.find(ticket);
+                if (it == state.pending.end()) return;
+                CallPtr call = it->second.call;
+                state.pending.erase(it);
+                state.waiting.erase(std::find_if(state.waiting.begin(), state.waiting.end(),
+                    [ticket](const HttpClient::Waiter& waiter) { return waiter.ticket == ticket; }));
+                finishAttempt(call, { 0, true });
+                });
+
+            dispatch(host);
+        }
+
+        void dispatch(HostId host) {
+            auto& state = hosts_[host];
+            long limit = hostLimit(host);
+            while (!state.waiting.empty()) {
+                size_t index = 0;
+                if (limit > 0) {
+                    auto next = HttpClient::nextAdmission(state.waiting, state.inFlight, state.backgroundInFlight,
+                        limit, options_.qos, toTimePoint(now_));
+                    if (!next) break;
+                    index = *next;
+                }
+                admit(host, index);
+            }
+        }
+
+        void admit(HostId host, size_t index) {
+            auto& state = hosts_[host];
+            HttpClient::Waiter waiter = state.waiting[index];
+            state.waiting.erase(state.waiting.begin() + index);
+            auto it = state.pending.find(waiter.ticket);
+            Pending pending = std::move(it->second);
+            state.pending.erase(it);
+
+            // Abgebrochene Varianten verlassen die Warteschlange, ohne gesendet zu werden
+            if (pending.call->cancelled && *pending.call->cancelled) return;
+
+            state.inFlight++;
+            if (waiter.priority == HttpClient::Priority::Background) state.backgroundInFlight++;
+            transfer(pending.call, pending.expires);
+        }
+
+        void release(HostId host, HttpClient::Priority priority) {
+            auto& state = hosts_[host];
+            state.inFlight--;
+            if (priority == HttpClient::Priority::Background) state.backgroundInFlight--;
+            dispatch(host);
+        }
+
+        std::optional<long> hedgeDelay(const Call& call) const {
+            const auto& hedging = options_.hedging;
+            if (!call.request.hedgeable || call.async || call.request.method != "GET" || !hedging.enabled) return std::nullopt;
+            const auto& state = hosts_[call.host];
+            if (state.samples.size() < hedging.minSamples) return hedging.maxDelayMs;
+            return state.hedgeDelayMs;
+        }
+
+        void recordLatency(const Call& call, long ms) {
+            if (!call.request.hedgeable) return;
+            auto& state = hosts_[call.host];
+            if (state.samples.size() < kLatencyWindow) {
+                state.samples.push_back(static_cast<double>(ms));
+            }
+            else {
+                state.samples[state.next] = static_cast<double>(ms);
+                state.next = (state.next + 1) % kLatencyWindow;
+            }
+            if (++state.sinceRecompute >= kHedgeRecomputeInterval) {
+                state.sinceRecompute = 0;
+                std::vector<float> samples(state.samples.begin(), state.samples.end());
+                long delay = static_cast<long>(percentileOf(samples, options_.hedging.percentile));
+                state.hedgeDelayMs = std::clamp(delay, options_.hedging.minDelayMs, options_.hedging.maxDelayMs);
+            }
+        }
+
+        // Wie HostLimiter::tryAcquire: nur ein sofort freier Platz, der Hedge wartet nicht
+        bool tryAcquire(HostId host, HttpClient::Priority priority) {
+            auto& state = hosts_[host];
+            long limit = hostLimit(host);
+            if (limit > 0) {
+                state.waiting.push_back({ nextTicket_++, priority, toTimePoint(now_) });
+                auto next = HttpClient::nextAdmission(state.waiting, state.inFlight, state.backgroundInFlight,
+                    limit, options_.qos, toTimePoint(now_));
+                bool admitted = next && *next == state.waiting.size() - 1;
+                state.waiting.pop_back();
+                if (!admitted) return false;
+            }
+            state.inFlight++;
+            if (priority == HttpClient::Priority::Background) state.backgroundInFlight++;
+            return true;
+        }
+
+        void transfer(CallPtr call, Micros expires) {
+            Micros started = now_;
+            Served first = serve(call->host);
+            Micros firstAt = started + first.latencyMs * kMicrosPerMs;
+
+            // Wie performHedged: beide Pltze werden frei, sobald die erste verwertbare Antwort da ist
+            auto finish = [this, call, started, expires](Served served, Micros arrival, bool hedged) {
+                Micros end = std::min(arrival, expires);
+                at(end, [this, call, started, served, hedged, timedOut = arrival > expires]() {
+                    if (hedged) release(call->host, call->priority);
+                    release(call->host, call->priority);
+                    if (!timedOut) recordLatency(*call, static_cast<long>((now_ - started) / kMicrosPerMs));
+                    finishAttempt(call, { served.status, timedOut }, served.retryAfterS);
+                    });
+            };
+
+            // Der Hedge startet nur, wenn die erste Antwort bis dahin ausbleibt und unter dem
+            // Host-Limit ein eigener Platz frei ist; die schnellere Antwort gewinnt
+            auto delay = hedgeDelay(*call);
+            Micros hedgeAt = started + (delay ? *delay : 0) * kMicrosPerMs;
+            if (delay && hedgeAt < expires && firstAt > hedgeAt) {
+                at(hedgeAt, [this, call, first, firstAt, finish]() {
+                    if (!tryAcquire(call->host, call->priority)) {
+                        finish(first, firstAt, false);
+                        return;
+                    }
+                    report_.hedges++;
+                    Served second = serve(call->host);
+                    Micros secondAt = now_ + second.latencyMs * kMicrosPerMs;
+                    if (secondAt < firstAt) finish(second, secondAt, true);
+                    else finish(first, firstAt, true);
+                    });
+                return;
+            }
+            finish(first, firstAt, false);
+        }
+
+        void finishAttempt(CallPtr call, Outcome outcome, long retryAfterS = 0) {
+            if (outcome.timedOut) report_.timeouts++;
+
+            // Eine verworfene Kaskaden-Variante wird wie in performAsyncAttempt nicht wiederholt
+            bool cancelled = call->cancelled && *call->cancelled;
+            if (!cancelled && call->attempt < options_.retry.maxAttempts) {
+                HttpClient::Response response;
+                response.ok = !outcome.timedOut && outcome.status != 0;
+                response.status = outcome.status;
+                response.timedOut = outcome.timedOut;
+                if (retryAfterS > 0) response.headers["retry-after"] = std::to_string(retryAfterS);
+
+                if (HttpClient::shouldRetry(call->request, response)) {
+                    // Wie perform(): nicht ber Timeout oder Deadline hinaus warten
+                    auto delay = HttpClient::retryDelay(options_.retry, response, call->attempt, random_);
+                    auto timeout = timeoutMs(*call);
+                    if (timeout && delay.count() < *timeout) {
+                        report_.retries++;
+                        at(now_ + delay.count() * kMicrosPerMs, [this, call]() { attempt(call); });
+                        return;
+                    }
+                }
+            }
+            complete(call, outcome);
+        }
+
+        void complete(const CallPtr& call, const Outcome& outcome) {
+            report_.requests++;
+            callLatencies_[call->priority].push_back(static_cast<float>(now_ - call->start) / kMicrosPerMs);
+            if (call->done) call->done(outcome);
+        }
+
+        CallPtr makeCall(HostId host, const std::string& method, bool hedgeable, HttpClient::Priority priority,
+            std::optional<Micros> deadline, std::function<void(const Outcome&)> done) {
+            auto call = std::make_shared<Call>();
+            call->host = host;
+            call->request.method = method;
+            call->request.hedgeable = hedgeable;
+            call->priority = priority;
+            call->deadline = deadline;
+            call->done = std::move(done);
+            return call;
+        }
+
+        // --- Token (wie TokenStore und SpotifyService::ensureValidToken) ---
+
+        bool tokenNeedsRefresh() const {
+            return now_ >= tokenExpiresAt_ - performance_.tokens.refreshLeadSeconds * 1000 * kMicrosPerMs;
+        }
+
+        // Wie TokenStore::refreshNow: pro Konto luft hchstens ein Refresh, wer whrenddessen
+        // erneuern will, wartet auf dessen Ergebnis
+        void refreshToken(std::function<void(bool)> next) {
+            if (next) refreshWaiters_.push_back(std::move(next));
+            if (refreshing_) return;
+            refreshing_ = true;
+
+            report_.tokenRefreshes++;
+            perform(makeCall(kAccounts, "POST", false, HttpClient::Priority::Normal, std::nullopt,
+                [this](const Outcome& outcome) {
+                    refreshing_ = false;
+                    if (outcome.ok()) {
+                        tokenExpiresAt_ = now_ + scenario_.tokenLifetimeS * 1000 * kMicrosPerMs;
+                        scheduleBackgroundRefresh();
+                    }
+                    else {
+                        scheduleRefreshRetry();
+                    }
+                    auto waiters = std::move(refreshWaiters_);
+                    refreshWaiters_.clear();
+                    for (auto& waiter : waiters) waiter(outcome.ok());
+                }));
+        }
+
+        void scheduleBackgroundRefresh() {
+            uint64_t generation = ++tokenGeneration_;
+            Micros refreshAt = tokenExpiresAt_ - performance_.tokens.refreshLeadSeconds * 1000 * kMicrosPerMs;
+            at(refreshAt, [this, generation]() {
+                // Inzwischen von einem Aufrufer erneuert
+                if (generation != tokenGeneration_) return;
+                refreshToken(nullptr);
+                });
+        }
+
+        void scheduleRefreshRetry() {
+            uint64_t generation = ++tokenGeneration_;
+            at(now_ + kTokenRetryDelay, [this, generation]() {
+                if (generation != tokenGeneration_) return;
+                refreshToken(nullptr);
+                });
+        }
+
+        // Wie ensureValidToken: Aufrufer im Vorlauf erneuern selbst oder hngen sich an den laufenden Refresh
+        void ensureToken(std::function<void(bool)> next) {
+            if (!tokenNeedsRefresh()) {
+                next(true);
+                return;
+            }
+            report_.tokenWaits++;
+            refreshToken(std::move(next));
+        }
+
+        // --- Importe ---
+
+        void scheduleNextArrival() {
+            double perMicro = scenario_.workload.importsPerHour / (3600.0 * 1000.0 * kMicrosPerMs);
+            if (perMicro <= 0) return;
+            std::exponential_distribution<double> gap(perMicro);
+            Micros arrival = now_ + static_cast<Micros>(gap(workloadRandom_));
+            if (arrival > end_) return;
+
+            at(arrival, [this]() {
+                const auto& workload = scenario_.workload;
+                auto import = std::make_shared<Import>();
+                import->arrived = now_;
+
+                std::uniform_real_distribution<double> chance(0.0, 1.0);
+                double kind = chance(workloadRandom_);
+                import->priority = kind < workload.interactiveShare ? HttpClient::Priority::Interactive
+                    : kind < workload.interactiveShare + workload.backgroundShare ? HttpClient::Priority::Background
+                    : HttpClient::Priority::Normal;
+
+                std::uniform_int_distribution<size_t> songs(workload.minSongs, std::max(workload.minSongs, workload.maxSongs));
+                import->cached.resize(songs(workloadRandom_));
+                for (size_t i = 0; i < import->cached.size(); i++) {
+                    import->cached[i] = chance(workloadRandom_) < workload.trackCacheHitRate;
+                }
+
+                // Importe aus dem Fenster laufen sofort, Jobs warten auf einen Import-Worker
+                activeImports_++;
+                if (import->priority == HttpClient::Priority::Interactive) startImport(import);
+                else enqueueJob(import);
+                scheduleNextArrival();
+                });
+        }
+
+        void enqueueJob(ImportPtr import) {
+            if (busyWorkers_ < std::max<size_t>(1, performance_.workers.importWorkers)) {
+                busyWorkers_++;
+                startImport(std::move(import));
+            }
+            else {
+                jobQueue_.push_back(std::move(import));
+            }
+        }
+
+        void startImport(ImportPtr import) {
+            // Zuerst die Setlist (ohne Import-Budget), dann runImport
+            perform(makeCall(kSetlistFm, "GET", true, import->priority, std::nullopt,
+                [this, import](const Outcome& outcome) {
+                    if (!outcome.ok()) {
+                        finishImport(import, false);
+                        return;
+                    }
+                    auto budget = options_.timeouts.importBudget(import->cached.size());
+                    import->deadline = now_ + budget.count() * kMicrosPerMs;
+                    ensureToken([this, import](bool valid) {
+                        if (!valid) finishImport(import, false);
+                        else nextSong(import);
+                        });
+                }));
+        }
+
+        void nextSong(ImportPtr import) {
+            while (import->next < import->cached.size() && import->cached[import->next]) {
+                import->next++;
+                import->found++;
+            }
+            if (import->next >= import->cached.size()) {
+                addTracks(import);
+                return;
+            }
+            if (now_ >= import->deadline) {
+                finishImport(import, false);
+                return;
+            }
+
+            ensureToken([this, import](bool valid) {
+                if (!valid) {
+                    // Suche liefert nichts, der Import geht mit dem nchsten Song weiter
+                    import->next++;
+                    nextSong(import);
+                    return;
+                }
+
+                // Kaskade: Varianten laufen asynchron neben der strikten Suche
+                std::shared_ptr<bool> losers;
+                if (performance_.search.cascade) {
+                    losers = std::make_shared<bool>(false);
+                    for (size_t i = 0; i < scenario_.workload.cascadeVariants; i++) {
+                        auto variant = makeCall(kSpotify, "GET", true, import->priority, import->deadline, nullptr);
+                        variant->cancelled = losers;
+                        variant->async = true;
+                        perform(variant);
+                    }
+                }
+
+                perform(makeCall(kSpotify, "GET", true, import->priority, import->deadline,
+                    [this, import, losers](const Outcome& outcome) {
+                        if (losers) *losers = true;
+                        if (outcome.ok()) import->found++;
+                        import->next++;
+                        nextSong(import);
+                    }));
+                });
+        }
+
+        void addTracks(ImportPtr import) {
+            // Wie runImport: die Playlist erst nach der Suche und nur mit mindestens einem Treffer
+            if (import->found == 0) {
+                finishImport(import, false);
+                return;
+            }
+            import->chunksLeft = (import->found + kTracksPerRequest - 1) / kTracksPerRequest;
+            ensureToken([this, import](bool valid) {
+                if (!valid) {
+                    finishImport(import, false);
+                    return;
+                }
+                perform(makeCall(kSpotify, "POST", false, import->priority, import->deadline,
+                    [this, import](const Outcome& outcome) {
+                        if (!outcome.ok()) finishImport(import, false);
+                        else addChunk(import);
+                    }));
+                });
+        }
+
+        void addChunk(ImportPtr import) {
+            if (import->chunksLeft == 0) {
+                finishImport(import, true);
+                return;
+            }
+            ensureToken([this, import](bool valid) {
+                if (!valid) {
+                    finishImport(import, false);
+                    return;
+                }
+                perform(makeCall(kSpotify, "POST", false, import->priority, import->deadline,
+                    [this, import](const Outcome& outcome) {
+                        if (!outcome.ok()) {
+                            finishImport(import, false);
+                            return;
+                        }
+                        import->chunksLeft--;
+                        addChunk(import);
+                    }));
+                });
+        }
+
+        void finishImport(const ImportPtr& import, bool success) {
+            report_.imports++;
+            if (!success) report_.importsFailed++;
+            importLatencies_.push_back(static_cast<float>(now_ - import->arrived) / kMicrosPerMs);
+            activeImports_--;
+
+            if (import->priority == HttpClient::Priority::Interactive) return;
+            if (jobQueue_.empty()) {
+                busyWorkers_--;
+                return;
+            }
+            auto next = std::move(jobQueue_.front());
+            jobQueue_.pop_front();
+            startImport(std::move(next));
+        }
+
+        const LoadSimulator::Scenario& scenario_;
+        const ConfigLoader::PerformanceConfig& performance_;
+        const HttpClient::Options& options_;
+        std::mt19937 workloadRandom_;   // Nur fr die Importe, damit alle Konfigurationen dieselben sehen
+        std::mt19937 random_;           // Server, Jitter
+
+        Micros now_ = 0;
+        Micros end_ = 0;
+        uint64_t nextSequence_ = 0;
+        std::priority_queue<Event, std::vector<Event>, Later> events_;
+
+        const LoadSimulator::ServerModel* servers_[kHostCount];
+        std::lognormal_distribution<double> latency_[kHostCount];
+        HostState hosts_[kHostCount];
+        uint64_t nextTicket_ = 1;
+
+        Micros tokenExpiresAt_ = 0;
+        uint64_t tokenGeneration_ = 0;
+        bool refreshing_ = false;
+        std::vector<std::function<void(bool)>> refreshWaiters_;
+
+        size_t activeImports_ = 0;
+        size_t busyWorkers_ = 0;
+        std::deque<ImportPtr> jobQueue_;
+
+        LoadSimulator::Report report_;
+        std::map<HttpClient::Priority, std::vector<float>> callLatencies_;
+        std::vector<float> importLatencies_;
+    };
+}
+
+double LoadSimulator::Report::throughput() const {
+    return simulatedSeconds > 0 ? requests / simulatedSeconds : 0.0;
+}
+
+double LoadSimulator::Report::throttleRate() const {
+    return sent > 0 ? static_cast<double>(throttled) / sent : 0.0;
+}
+
+std::optional<LoadSimulator::Scenario> LoadSimulator::loadScenario(const std::string& filename, const std::string& baseConfig) {
+    try {
+        ConfigLoader::PerformanceConfig base;
+        if (!baseConfig.empty()) {
+            base = ConfigLoader::loadConfig(baseConfig).performance;
+        }
+
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            throw std::runtime_error("Could not open scenario file: " + filename);
+        }
+        json j;
+        file >> j;
+
+        Scenario scenario;
+        scenario.durationHours = j.value("duration_h", scenario.durationHours);
+        scenario.seed = j.value("seed", scenario.seed);
+
+        if (j.contains("workload")) {
+            const auto& w = j["workload"];
+            auto& workload = scenario.workload;
+            workload.importsPerHour = w.value("imports_per_hour", workload.importsPerHour);
+            workload.minSongs = w.value("min_songs", workload.minSongs);
+            workload.maxSongs = w.value("max_songs", workload.maxSongs);
+            workload.trackCacheHitRate = w.value("track_cache_hit_rate", workload.trackCacheHitRate);
+            workload.interactiveShare = w.value("interactive_share", workload.interactiveShare);
+            workload.backgroundShare = w.value("background_share", workload.backgroundShare);
+            workload.cascadeVariants = w.value("cascade_variants", workload.cascadeVariants);
+        }
+
+        // Voreinstellungen grob nach den ffentlichen Angaben der APIs
+        scenario.setlistFm.medianMs = 250.0;
+        scenario.setlistFm.p99Ms = 1500.0;
+        scenario.accounts.medianMs = 150.0;
+        scenario.accounts.p99Ms = 600.0;
+        if (j.contains("servers")) {
+            const auto& s = j["servers"];
+            if (s.contains("spotify")) scenario.spotify = serverFromJson(s["spotify"], scenario.spotify);
+            if (s.contains("setlistfm")) scenario.setlistFm = serverFromJson(s["setlistfm"], scenario.setlistFm);
+            if (s.contains("accounts")) scenario.accounts = serverFromJson(s["accounts"], scenario.accounts);
+        }
+
+        if (j.contains("token")) {
+            scenario.tokenLifetimeS = j["token"].value("lifetime_s", scenario.tokenLifetimeS);
+        }
+
+        if (j.contains("configurations")) {
+            for (const auto& c : j["configurations"]) {
+                Configuration configuration;
+                configuration.name = c.value("name", "config" + std::to_string(scenario.configurations.size() + 1));
+                configuration.performance = base;
+                if (c.contains("performance")) {
+                    ConfigLoader::parsePerformance(c["performance"], configuration.performance);
+                }
+                scenario.configurations.push_back(std::move(configuration));
+            }
+        }
+        if (scenario.configurations.empty()) {
+            scenario.configurations.push_back({ baseConfig.empty() ? "default" : baseConfig, base });
+        }
+        return scenario;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading scenario: " << e.what() << std::endl;
+        return std::nullopt;
+    }
+}
+
+LoadSimulator::Report LoadSimulator::run(const Scenario& scenario, const Configuration& configuration) {
+    Simulation simulation(scenario, configuration);
+    return simulation.execute();
+}
+
+void LoadSimulator::printReports(const std::vector<Report>& reports, std::ostream& out) {
+    out << std::left << std::setw(20) << "Konfiguration" << std::right
+        << std::setw(10) << "Req/s" << std::setw(10) << "p50 ms" << std::setw(10) << "p95 ms" << std::setw(10) << "p99 ms"
+        << std::setw(9) << "429 %" << std::setw(10) << "Retries" << std::setw(10) << "Timeouts"
+        << std::setw(10) << "Importe" << std::setw(10) << "Fehler" << std::setw(12) << "Import p95" << std::endl;
+
+    for (const auto& report : reports) {
+        out << std::fixed << std::setprecision(1) << std::left << std::setw(20) << report.name << std::right
+            << std::setw(10) << report.throughput() << std::setw(10) << report.p50Ms
+            << std::setw(10) << report.p95Ms << std::setw(10) << report.p99Ms
+            << std::setw(8) << report.throttleRate() * 100.0 << "%" << std::setw(10) << report.retries
+            << std::setw(10) << report.timeouts << std::setw(10) << report.imports
+            << std::setw(10) << report.importsFailed << std::setw(10) << report.importP95Ms / 1000.0 << " s" << std::endl;
+    }
+
+    out << std::endl;
+    for (const auto& report : reports) {
+        out << std::fixed << std::setprecision(1) << report.name << ": " << report.requests << " Requests, "
+            << report.sent << " gesendet, " << report.hedges << " Hedges, " << report.tokenRefreshes
+            << " Token-Refreshes (" << report.tokenWaits << " Aufrufer warteten darauf), " << report.unauthorized
+            << " mit abgelaufenem Token; p95";
+        for (const auto& [priority, p95] : report.p95ByPriority) {
+            out << " " << HttpClient::toString(priority) << " " << p95 << " ms";
+        }
+        out << "; " << report.simulatedSeconds / 3600.0 << " h simuliert in "
+            << report.wallTime.count() / 1000.0 << " s" << std::endl;
+    }
+}
+
+bool LoadSimulator::isSimulationInvocation(int argc, char** argv) {
+    return argc > 1 && std::string(argv[1]) == "--simulate";
+}
+
+int LoadSimulator::runCommandLine(int argc, char** argv) {
+    std::string scenarioFile;
+    std::string baseConfig;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--config" && i + 1 < argc) baseConfig = argv[++i];
+        else scenarioFile = arg;
+    }
+    if (scenarioFile.empty()) {
+        std::cerr << "Aufruf: --simulate <Szenario.json> [--config config.json]" << std::endl;
+        return 1;
+    }
+
+    auto scenario = loadScenario(scenarioFile, baseConfig);
+    if (!scenario) return 1;
+
+    std::vector<Report> reports;
+    for (const auto& configuration : scenario->configurations) {
+        std::cout << "Simuliere '" << configuration.name << "'..." << std::endl;
+        reports.push_back(run(*scenario, configuration));
+    }
+    printReports(reports, std::cout);
+    return 0;
+}
@@ -0,0 +1,93 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <map>
+#include <optional>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include "ConfigLoader.h"
+#include "HttpClient.h"
+
+/// <summary>
+/// Spielt Import-Verkehr mit virtueller Uhr gegen modellierte Server durch, um Host-Limits,
+/// Priorittsklassen, Wiederholungen, Hedging und Token-Refresh offline abzustimmen: ein
+/// simulierter Tag mit Millionen Requests dauert Sekunden. Host-Limit, Hedge-Platz und Backoff
+/// entscheidet HttpClient selbst (nextAdmission, shouldRetry, retryDelay); der Ablauf eines Imports
+/// folgt SpotifyService::runImport, der Token-Refresh TokenStore::refreshNow. Hedges laufen immer
+/// wie in performHedged, auch mit HTTP/2, wo performMultiplexed den Hedge auf einen Platz warten
+/// lsst. Alle Konfigurationen eines Szenarios sehen dieselben Importe.
+/// </summary>
+class LoadSimulator {
+public:
+    // Modellierter API-Host
+    struct ServerModel {
+        double medianMs = 120.0;        // Latenz log-normalverteilt, bestimmt durch Median und p99
+        double p99Ms = 800.0;
+        double errorRate = 0.0;         // Anteil der Antworten mit 503
+        long rateLimit = 0;             // Requests pro Fenster (abgewiesene zhlen mit), 0 = unbegrenzt
+        long rateWindowMs = 30000;
+        long retryAfterS = 0;           // Retry-After bei 429; 0 = bis im Fenster wieder Platz ist
+    };
+
+    struct Workload {
+        double importsPerHour = 600.0;  // Poisson-verteilte Anknfte
+        size_t minSongs = 10;
+        size_t maxSongs = 25;
+        double trackCacheHitRate = 0.3; // Anteil der Songs, die ohne Suche aufgelst werden
+        double interactiveShare = 0.2;  // Importe aus dem Fenster, warten nicht auf Import-Worker
+        double backgroundShare = 0.2;   // Rest: Jobs mit Prioritt normal
+        size_t cascadeVariants = 2;     // Zustzliche Suchen pro Song bei search.cascade
+    };
+
+    struct Configuration {
+        std::string name;
+        ConfigLoader::PerformanceConfig performance;
+    };
+
+    struct Scenario {
+        double durationHours = 24.0;
+        uint32_t seed = 1;
+        Workload workload;
+        ServerModel spotify;
+        ServerModel setlistFm;
+        ServerModel accounts;           // Token-Refresh
+        long tokenLifetimeS = 3600;
+        std::vector<Configuration> configurations;
+    };
+
+    struct Report {
+        std::string name;
+        double simulatedSeconds = 0.0;
+        std::chrono::milliseconds wallTime{ 0 };
+        uint64_t imports = 0;
+        uint64_t importsFailed = 0;
+        uint64_t requests = 0;          // Aufrufe (Wiederholungen und Hedges zhlen nicht extra)
+        uint64_t sent = 0;              // Beim Server angekommen, mit Wiederholungen und Hedges
+        uint64_t throttled = 0;         // Antworten mit 429
+        uint64_t retries = 0;
+        uint64_t hedges = 0;
+        uint64_t timeouts = 0;
+        uint64_t unauthorized = 0;      // Mit abgelaufenem Token gesendet
+        uint64_t tokenRefreshes = 0;
+        uint64_t tokenWaits = 0;        // Aufrufer, die auf einen Refresh warten mussten
+        double p50Ms = 0.0;             // Aus Sicht des Aufrufers, mit Wartezeit und Wiederholungen
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        std::map<HttpClient::Priority, double> p95ByPriority;
+        double importP50Ms = 0.0;       // Von der Ankunft bis zum Ende, mit Wartezeit auf einen Worker
+        double importP95Ms = 0.0;
+
+        double throughput() const;      // Requests pro simulierter Sekunde
+        double throttleRate() const;    // 429 pro gesendetem Request
+    };
+
+    // Ohne baseConfig starten alle Konfigurationen von den Defaults, sonst von deren Abschnitt "performance"
+    static std::optional<Scenario> loadScenario(const std::string& filename, const std::string& baseConfig = "");
+    static Report run(const Scenario& scenario, const Configuration& configuration);
+    static void printReports(const std::vector<Report>& reports, std::ostream& out);
+
+    // Kommandozeile: --simulate <Szenario.json> [--config config.json]
+    static bool isSimulationInvocation(int argc, char** argv);
+    static int runCommandLine(int argc, char** argv);
+};
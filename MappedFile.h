@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <cstddef>
+
+/// <summary>
+/// Schreibgeschtzte Abbildung einer Datei in den Speicher (mmap bzw. MapViewOfFile).
+/// Der Inhalt wird erst beim Zugriff vom Betriebssystem eingelesen und nicht kopiert.
+/// </summary>
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Bildet die ganze Datei ab; false, wenn sie nicht geffnet werden kann
+    bool open(const std::string& path);
+    void close();
+
+    bool isOpen() const { return open_; }
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    std::string_view view() const { return { data_, size_ }; }
+
+private:
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    bool open_ = false;         // Auch leere Dateien gelten als geffnet
+#ifdef _WIN32
+    void* file_ = nullptr;      // HANDLE
+    void* mapping_ = nullptr;   // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
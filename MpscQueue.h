@@ -0,0 +1,74 @@
+#pragma once
+#include <atomic>
+#include <optional>
+#include <cstddef>
+
+/// <summary>
+/// Lock-freie Warteschlange fr viele Produzenten und einen Konsumenten (nach D. Vyukov).
+/// push() ist von beliebigen Threads aus erlaubt, tryPop()/drain() nur von einem Thread.
+/// Ein Element, dessen push() gerade luft, kann kurz unsichtbar sein; es wird beim
+/// nchsten Leeren geliefert.
+/// </summary>
+template <typename T>
+class MpscQueue {
+public:
+    MpscQueue() {
+        Node* stub = new Node;
+        head_.store(stub, std::memory_order_relaxed);
+        tail_ = stub;
+    }
+
+    ~MpscQueue() {
+        while (tryPop()) {}
+        delete tail_;
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* node = new Node;
+        node->value.emplace(std::move(value));
+
+        // Erst den Kopf umsetzen, dann den Vorgnger verketten; beides ohne Sperre
+        Node* previous = head_.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    std::optional<T> tryPop() {
+        Node* tail = tail_;
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return std::nullopt;
+
+        // next wird zum neuen Stub; sein Wert gehrt jetzt dem Konsumenten
+        std::optional<T> value = std::move(next->value);
+        next->value.reset();
+        tail_ = next;
+        delete tail;
+        return value;
+    }
+
+    // Ruft handler fr alle aktuell sichtbaren Elemente auf und liefert deren Anzahl
+    template <typename F>
+    size_t drain(F&& handler) {
+        size_t count = 0;
+        while (auto value = tryPop()) {
+            handler(std::move(*value));
+            count++;
+        }
+        return count;
+    }
+
+    bool empty() const {
+        return tail_->next.load(std::memory_order_acquire) == nullptr;
+    }
+
+private:
+    struct Node {
+        std::atomic<Node*> next{ nullptr };
+        std::optional<T> value;
+    };
+
+    std::atomic<Node*> head_;   // Zuletzt eingefgter Knoten (Produzenten)
+    Node* tail_;                // Stub vor dem ltesten Element (Konsument)
+};
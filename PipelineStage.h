@@ -0,0 +1,225 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <optional>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+
+// Momentaufnahme einer Stufe (siehe PipelineStage::stats)
+struct PipelineStageStats {
+    std::string name;
+    size_t workers = 0;
+    size_t capacity = 0;
+    size_t depth = 0;               // Wartende Elemente
+    size_t active = 0;              // Worker im Handler
+    size_t blocked = 0;             // Worker, die auf Platz in der nchsten Stufe warten
+    uint64_t processed = 0;
+    double utilization = 0.0;       // Anteil der Worker-Zeit im Handler, ber das letzte Messintervall
+};
+
+/// <summary>
+/// Stufe einer Verarbeitungskette mit eigenen Worker-Threads und begrenzter Eingangs-
+/// Warteschlange. Liefert der Handler true, geht das Element an die nchste Stufe; ist deren
+/// Warteschlange voll, wartet der Worker. So pflanzt sich der Rckstau bis zum Anfang der
+/// Kette fort und der Speicher bleibt begrenzt. Die Statistik trennt Arbeit im Handler vom
+/// Warten auf die nchste Stufe: Der Engpass ist ausgelastet, seine Warteschlange ist voll
+/// und die Stufen davor warten auf ihn.
+/// </summary>
+template <typename T>
+class PipelineStage {
+public:
+    using Handler = std::function<bool(T&)>;
+
+    PipelineStage(std::string name, size_t workers, size_t capacity, Handler handler)
+        : name_(std::move(name)), workerCount_(std::max<size_t>(1, workers)),
+        capacity_(std::max<size_t>(1, capacity)), handler_(std::move(handler)),
+        activeSince_(workerCount_), sampleTime_(std::chrono::steady_clock::now()) {
+    }
+
+    ~PipelineStage() {
+        stop();
+        join();
+    }
+
+    PipelineStage(const PipelineStage&) = delete;
+    PipelineStage& operator=(const PipelineStage&) = delete;
+
+    // Vor start() aufrufen; ohne nchste Stufe endet die Kette hier
+    void connect(PipelineStage& next) { next_ = &next; }
+
+    void start() {
+        for (size_t i = 0; i < workerCount_; i++) {
+            workers_.emplace_back([this, i]() { workerLoop(i); });
+        }
+    }
+
+    // Wartet, bis Platz ist; false nach stop()
+    bool push(T item) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            notFull_.wait(lock, [this]() { return stopping_ || queue_.size() < capacity_; });
+            if (stopping_) return false;
+            queue_.push_back(std::move(item));
+        }
+        notEmpty_.notify_one();
+        return true;
+    }
+
+    // Alle oder keins, ohne zu warten
+    bool tryPushAll(std::vector<T>& items) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopping_ || queue_.size() + items.size() > capacity_) return false;
+            for (auto& item : items) {
+                queue_.push_back(std::move(item));
+            }
+        }
+        notEmpty_.notify_all();
+        return true;
+    }
+
+    // Nimmt wartende Elemente heraus, fr die predicate zutrifft
+    template <typename Predicate>
+    std::vector<T> removeIf(Predicate predicate) {
+        std::vector<T> removed;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (auto it = queue_.begin(); it != queue_.end();) {
+                if (predicate(*it)) {
+                    removed.push_back(std::move(*it));
+                    it = queue_.erase(it);
+                }
+                else {
+                    ++it;
+                }
+            }
+        }
+        if (!removed.empty()) notFull_.notify_all();
+        return removed;
+    }
+
+    // Weckt alle wartenden Worker und Produzenten; wartende Elemente werden verworfen.
+    // Bei mehreren Stufen erst alle anhalten, dann auf alle warten.
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        notEmpty_.notify_all();
+        notFull_.notify_all();
+    }
+
+    void join() {
+        for (auto& worker : workers_) {
+            if (worker.joinable()) worker.join();
+        }
+    }
+
+    size_t depth() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return queue_.size();
+    }
+
+    size_t capacity() const { return capacity_; }
+
+    PipelineStageStats stats() const {
+        auto now = std::chrono::steady_clock::now();
+        std::lock_guard<std::mutex> lock(mutex_);
+
+        PipelineStageStats stats;
+        stats.name = name_;
+        stats.workers = workerCount_;
+        stats.capacity = capacity_;
+        stats.depth = queue_.size();
+        stats.blocked = blocked_;
+        stats.processed = processed_;
+
+        // Laufende Handler zhlen bis jetzt mit
+        auto busy = busy_;
+        for (const auto& since : activeSince_) {
+            if (!since) continue;
+            stats.active++;
+            busy += now - *since;
+        }
+
+        // Nach einem vollen Messintervall neu auswerten, bis dahin ber die bisherige Zeit
+        auto elapsed = now - sampleTime_;
+        if (elapsed >= kSampleInterval || !sampled_) {
+            if (elapsed.count() > 0) {
+                utilization_ = std::chrono::duration<double>(busy - sampleBusy_).count() /
+                    (std::chrono::duration<double>(elapsed).count() * workerCount_);
+            }
+            if (elapsed >= kSampleInterval) {
+                sampleTime_ = now;
+                sampleBusy_ = busy;
+                sampled_ = true;
+            }
+        }
+        stats.utilization = std::min(1.0, utilization_);
+        return stats;
+    }
+
+private:
+    static constexpr std::chrono::seconds kSampleInterval{ 5 };
+
+    void workerLoop(size_t index) {
+        while (true) {
+            std::optional<T> item;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                notEmpty_.wait(lock, [this]() { return stopping_ || !queue_.empty(); });
+                if (stopping_) return;
+
+                item.emplace(std::move(queue_.front()));
+                queue_.pop_front();
+                activeSince_[index] = std::chrono::steady_clock::now();
+            }
+            notFull_.notify_one();
+
+            bool forward = handler_(*item) && next_;
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                busy_ += std::chrono::steady_clock::now() - *activeSince_[index];
+                activeSince_[index].reset();
+                processed_++;
+                if (forward) blocked_++;
+            }
+
+            if (forward) {
+                next_->push(std::move(*item));
+                std::lock_guard<std::mutex> lock(mutex_);
+                blocked_--;
+            }
+        }
+    }
+
+    std::string name_;
+    size_t workerCount_;
+    size_t capacity_;
+    Handler handler_;
+    PipelineStage* next_ = nullptr;
+
+    mutable std::mutex mutex_;
+    std::condition_variable notEmpty_;
+    std::condition_variable notFull_;
+    std::deque<T> queue_;
+    bool stopping_ = false;
+
+    size_t blocked_ = 0;
+    uint64_t processed_ = 0;
+    std::chrono::steady_clock::duration busy_{ 0 };
+    std::vector<std::optional<std::chrono::steady_clock::time_point>> activeSince_;
+
+    mutable std::chrono::steady_clock::time_point sampleTime_;
+    mutable std::chrono::steady_clock::duration sampleBusy_{ 0 };
+    mutable double utilization_ = 0.0;
+    mutable bool sampled_ = false;
+
+    std::vector<std::thread> workers_;
+};
@@ -0,0 +1,222 @@
+#include "SetlistCache.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    json setlistToJson(const SetlistFmService::Setlist& setlist) {
+        json songs = json::array();
+        for (const auto& song : setlist.songs) {
+            songs.push_back({
+                {"name", song.name},
+                {"artist", song.artist},
+                {"is_cover", song.isCover},
+                {"cover_artist", song.coverArtist}
+                });
+        }
+        return {
+            {"id", setlist.id},
+            {"version_id", setlist.versionId},
+            {"last_updated", setlist.lastUpdated},
+            {"event_date", setlist.eventDate},
+            {"artist", setlist.artist},
+            {"venue", setlist.venue},
+            {"city", setlist.city},
+            {"country", setlist.country},
+            {"songs", std::move(songs)}
+        };
+    }
+
+    SetlistFmService::Setlist setlistFromJson(const json& j) {
+        SetlistFmService::Setlist setlist;
+        setlist.id = j.at("id");
+        setlist.versionId = j.value("version_id", "");
+        setlist.lastUpdated = j.value("last_updated", "");
+        setlist.eventDate = j.value("event_date", "");
+        setlist.artist = j.value("artist", "");
+        setlist.venue = j.value("venue", "");
+        setlist.city = j.value("city", "");
+        setlist.country = j.value("country", "");
+        for (const auto& songJson : j.at("songs")) {
+            SetlistFmService::Song song;
+            song.name = songJson.at("name");
+            song.artist = songJson.value("artist", "");
+            song.isCover = songJson.value("is_cover", false);
+            song.coverArtist = songJson.value("cover_artist", "");
+            setlist.songs.push_back(std::move(song));
+        }
+        return setlist;
+    }
+}
+
+SetlistCache::SetlistCache()
+    : SetlistCache(Options{}) {
+}
+
+SetlistCache::SetlistCache(const Options& options)
+    : options_(options) {
+}
+
+std::optional<SetlistCache::Entry> SetlistCache::get(const std::string& setlistId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = index_.find(setlistId);
+    if (it == index_.end()) return std::nullopt;
+
+    lru_.splice(lru_.begin(), lru_, it->second);
+    return *it->second;
+}
+
+void SetlistCache::put(Entry entry) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (index_.count(entry.setlist.id)) refetched_++;
+    insertLocked(std::move(entry));
+    dirty_ = true;
+}
+
+void SetlistCache::markValidated(const std::string& setlistId, const std::string& etag, const std::string& lastModified) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    notModified_++;
+    auto it = index_.find(setlistId);
+    if (it == index_.end()) return;
+
+    auto& entry = *it->second;
+    if (!etag.empty()) entry.etag = etag;
+    if (!lastModified.empty()) entry.lastModified = lastModified;
+    entry.validated = std::chrono::system_clock::now();
+    dirty_ = true;
+}
+
+std::vector<std::string> SetlistCache::ids() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::string> result;
+    result.reserve(lru_.size());
+    for (const auto& entry : lru_) {
+        result.push_back(entry.setlist.id);
+    }
+    return result;
+}
+
+bool SetlistCache::load() {
+    try {
+        std::ifstream file(options_.filename);
+        if (!file.is_open()) return false;
+
+        json j;
+        file >> j;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Die Datei ist nach Aktualitt sortiert; rckwrts einfgen, damit die Reihenfolge erhalten bleibt
+        const auto& entries = j.at("entries");
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            Entry entry;
+            entry.setlist = setlistFromJson(it->at("setlist"));
+            entry.etag = it->value("etag", "");
+            entry.lastModified = it->value("last_modified", "");
+            entry.validated = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds(it->value("validated_ms", int64_t{ 0 })));
+            // Seit dem Start schon neu abgerufene (oder aus einem Bundle bernommene) Setlists
+            // bleiben, wenn sie aktueller sind
+            insertIfNewerLocked(std::move(entry));
+        }
+        // dirty_ bleibt gesetzt: Eintrge von vor dem Laden fehlen noch in der Datei
+
+        std::cout << "Setlist-Cache geladen: " << index_.size() << " Eintrge" << std::endl;
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading setlist cache: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool SetlistCache::save() {
+    // Ein Speichervorgang zur Zeit: Die temporre Datei ist fr alle gleich, und ein
+    // spterer Stand darf nicht von einem frheren berschrieben werden
+    std::lock_guard<std::mutex> saveLock(saveMutex_);
+    json j;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dirty_) return true;
+
+        j["entries"] = json::array();
+        for (const auto& entry : lru_) {
+            j["entries"].push_back({
+                {"setlist", setlistToJson(entry.setlist)},
+                {"etag", entry.etag},
+                {"last_modified", entry.lastModified},
+                {"validated_ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+                    entry.validated.time_since_epoch()).count()}
+                });
+        }
+        dirty_ = false;
+    }
+
+    // Erst vollstndig in eine temporre Datei schreiben, dann atomar ersetzen
+    std::string tempName = options_.filename + ".tmp";
+    try {
+        {
+            std::ofstream file(tempName, std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open " + tempName);
+            }
+            file << j.dump();
+            if (!file) {
+                throw std::runtime_error("Could not write " + tempName);
+            }
+        }
+        std::filesystem::rename(tempName, options_.filename);
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error saving setlist cache: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty_ = true;
+        return false;
+    }
+}
+
+std::vector<SetlistCache::Entry> SetlistCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::vector<Entry>(lru_.begin(), lru_.end());
+}
+
+size_t SetlistCache::merge(const std::vector<Entry>& entries) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t merged = 0;
+    for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+        if (insertIfNewerLocked(*it)) merged++;
+    }
+    if (merged > 0) dirty_ = true;
+    return merged;
+}
+
+size_t SetlistCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+void SetlistCache::insertLocked(Entry entry) {
+    auto it = index_.find(entry.setlist.id);
+    if (it != index_.end()) {
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front(std::move(entry));
+    index_[lru_.front().setlist.id] = lru_.begin();
+
+    while (index_.size() > options_.capacity && !lru_.empty()) {
+        index_.erase(lru_.back().setlist.id);
+        lru_.pop_back();
+    }
+}
+
+bool SetlistCache::insertIfNewerLocked(Entry entry) {
+    auto it = index_.find(entry.setlist.id);
+    if (it != index_.end() && it->second->validated >= entry.validated) return false;
+    insertLocked(std::move(entry));
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <list>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include "SetlistFmService.h"
+
+/// <summary>
+/// Zwischenspeicher fr abgerufene Setlists samt Validatoren (ETag, Last-Modified). Setlists
+/// werden nach dem Konzert noch bearbeitet, daher gilt kein Eintrag als dauerhaft aktuell:
+/// SetlistFmService fragt mit If-None-Match/If-Modified-Since nach und bekommt bei
+/// unvernderten Setlists nur ein 304. Threadsicher, mit LRU-Verdrngung.
+/// </summary>
+class SetlistCache {
+public:
+    struct Options {
+        std::string filename = "setlist_cache.json";
+        size_t capacity = 5000;
+    };
+
+    struct Entry {
+        SetlistFmService::Setlist setlist;
+        std::string etag;
+        std::string lastModified;   // HTTP-Datum
+        std::chrono::system_clock::time_point validated;
+    };
+
+    SetlistCache();
+    explicit SetlistCache(const Options& options);
+
+    SetlistCache(const SetlistCache&) = delete;
+    SetlistCache& operator=(const SetlistCache&) = delete;
+
+    std::optional<Entry> get(const std::string& setlistId);
+    void put(Entry entry);
+    // Nach einem 304: Eintrag ist weiter aktuell, neue Validatoren bernehmen
+    void markValidated(const std::string& setlistId, const std::string& etag, const std::string& lastModified);
+
+    std::vector<std::string> ids() const;
+
+    bool load();
+    // Schreibt nur, wenn sich seit dem letzten Speichern etwas gendert hat
+    bool save();
+
+    // Alle Eintrge, zuletzt verwendete zuerst (z.B. fr ein CacheBundle)
+    std::vector<Entry> entries() const;
+    // bernimmt Eintrge in derselben Reihenfolge; bei bekannten Setlists gewinnt die zuletzt
+    // validierte. Liefert die Anzahl bernommener Eintrge.
+    size_t merge(const std::vector<Entry>& entries);
+
+    size_t size() const;
+    uint64_t notModified() const { return notModified_; }
+    uint64_t refetched() const { return refetched_; }
+
+private:
+    void insertLocked(Entry entry);
+    bool insertIfNewerLocked(Entry entry);
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::mutex saveMutex_;     // Hlt save() von Schreiben bis rename()
+    std::list<Entry> lru_;      // Vorne: zuletzt verwendet
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    bool dirty_ = false;
+
+    std::atomic<uint64_t> notModified_{ 0 };
+    std::atomic<uint64_t> refetched_{ 0 };
+};
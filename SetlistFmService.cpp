@@ -1,95 +1,275 @@
 // SetlistFmService.cpp
 #include "SetlistFmService.h"
+#include "SetlistCache.h"
 #include <iostream>
+#include <cstdio>
 #include <curl/curl.h>
+#include <boost/asio/use_awaitable.hpp>
 
-// Callback-Funktion fr cURL
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
-    size_t newLength = size * nmemb;
-    try {
-        s->append((char*)contents, newLength);
-        return newLength;
+namespace {
+    HttpClient::Options withoutMultiplexing(HttpClient::Options options) {
+        // HTTP/2-Multiplexing ist fr die Such-Fan-outs gegen api.spotify.com gedacht;
+        // setlist.fm wird nur vereinzelt abgefragt
+        options.http2.enabled = false;
+        return options;
     }
-    catch (std::bad_alloc& e) {
-        return 0;
+
+    // "2013-10-20T05:18:08.000+0000" -> "Sun, 20 Oct 2013 05:18:08 GMT"; leer, wenn nicht lesbar
+    std::string httpDateFromIso(const std::string& iso) {
+        int year, month, day, hour, minute, second;
+        char sign = '+';
+        int offset = 0;
+        if (std::sscanf(iso.c_str(), "%d-%d-%dT%d:%d:%d", &year, &month, &day, &hour, &minute, &second) != 6) {
+            return "";
+        }
+        auto zone = iso.find_first_of("+-Z", 19);
+        if (zone != std::string::npos && iso[zone] != 'Z') {
+            sign = iso[zone];
+            offset = std::atoi(iso.c_str() + zone + 1);
+        }
+
+        using namespace std::chrono;
+        year_month_day date{ std::chrono::year(year), std::chrono::month(static_cast<unsigned>(month)),
+            std::chrono::day(static_cast<unsigned>(day)) };
+        if (!date.ok()) return "";
+        auto time = sys_days(date) + hours(hour) + minutes(minute) + seconds(second);
+        auto zoneOffset = hours(offset / 100) + minutes(offset % 100);
+        time += (sign == '+') ? -zoneOffset : zoneOffset;
+
+        auto utcDays = floor<days>(time);
+        year_month_day utcDate(utcDays);
+        hh_mm_ss<seconds> clock(time - utcDays);
+        static const char* weekdays[] = { "Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat" };
+        static const char* months[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+        char buffer[40];
+        std::snprintf(buffer, sizeof(buffer), "%s, %02u %s %04d %02d:%02d:%02d GMT",
+            weekdays[weekday(utcDays).c_encoding()], static_cast<unsigned>(utcDate.day()),
+            months[static_cast<unsigned>(utcDate.month()) - 1], static_cast<int>(utcDate.year()),
+            static_cast<int>(clock.hours().count()), static_cast<int>(clock.minutes().count()),
+            static_cast<int>(clock.seconds().count()));
+        return buffer;
+    }
+
+    std::string headerValue(const HttpClient::Response& response, const std::string& name) {
+        auto it = response.headers.find(name);
+        return it != response.headers.end() ? it->second : "";
     }
 }
 
-SetlistFmService::SetlistFmService(const Config& config)
-    : config_(config) {
+SetlistFmService::SetlistFmService(const Config& config, const HttpClient::Options& httpOptions)
+    : config_(config), http_(withoutMultiplexing(httpOptions)), cache_(std::make_shared<SetlistCache>()) {
     // Initialisiere cURL global (nur einmal pro Anwendung)
     curl_global_init(CURL_GLOBAL_DEFAULT);
 }
 
 SetlistFmService::~SetlistFmService() {
+    cache_->save();
+
     // Cleanup cURL
     curl_global_cleanup();
 }
 
-std::optional<SetlistFmService::Setlist> SetlistFmService::getSetlist(const std::string& setlistId) {
-    auto result = makeApiRequest("/rest/1.0/setlist/" + setlistId);
-    if (result) {
-        return parseSetlistJson(*result);
+std::optional<SetlistFmService::Setlist> SetlistFmService::getSetlist(const std::string& setlistId,
+    const CancellationToken& cancel) {
+    auto result = resolveSetlist(setlistId, fetchSetlist(setlistId, cancel));
+    if (result.refetch) {
+        result = resolveSetlist(setlistId, fetchSetlist(setlistId, cancel, false));
     }
-    return std::nullopt;
+    return result.setlist;
 }
 
-std::optional<json> SetlistFmService::makeApiRequest(const std::string& target) {
-    CURL* curl = curl_easy_init();
-    std::string response_string;
+HttpClient::Response SetlistFmService::fetchSetlist(const std::string& setlistId, const CancellationToken& cancel,
+    bool conditional) {
+    auto request = buildSetlistRequest(setlistId, conditional);
+    request.cancel = cancel;
 
-    if (curl) {
-        std::string url = "https://api.setlist.fm" + target;
+    // Debug-Ausgabe
+    std::cout << "Sende Anfrage an: " << request.url << std::endl;
 
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
+    return http_.perform(request);
+}
 
-        // Headers setzen
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, "Accept: application/json");
-        std::string api_key_header = "x-api-key: " + config_.api_key;
-        headers = curl_slist_append(headers, api_key_header.c_str());
-        headers = curl_slist_append(headers, "User-Agent: SetlistSpotifyGenerator/1.0");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+std::vector<SetlistFmService::Setlist> SetlistFmService::searchSetlists(const std::string& artistName, int page) {
+    std::vector<Setlist> setlists;
 
-        // Debug-Ausgabe
-        std::cout << "Sende Anfrage an: " << url << std::endl;
+    char* escaped = curl_easy_escape(nullptr, artistName.c_str(), static_cast<int>(artistName.size()));
+    if (!escaped) return setlists;
+    std::string target = "/rest/1.0/search/setlists?artistName=" + std::string(escaped) + "&p=" + std::to_string(page);
+    curl_free(escaped);
 
-        // Verbindung herstellen und Daten empfangen
-        CURLcode res = curl_easy_perform(curl);
+    auto result = parseApiResponse(http_.perform(buildApiRequest(target)));
+    if (!result || !result->contains("setlist")) return setlists;
 
-        // HTTP-Status abrufen
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    auto now = std::chrono::system_clock::now();
+    for (const auto& item : (*result)["setlist"]) {
+        try {
+            Setlist setlist = parseSetlistJson(item);
+            // Bestehende Eintrge behalten ihren ETag, solange sich die Fassung nicht gendert hat
+            auto cached = cache_->get(setlist.id);
+            if (!cached || cached->setlist.versionId != setlist.versionId) {
+                SetlistCache::Entry entry;
+                entry.setlist = setlist;
+                entry.validated = now;
+                cache_->put(entry);
+            }
+            setlists.push_back(std::move(setlist));
+        }
+        catch (const json::exception& e) {
+            std::cerr << "Unvollstndige Setlist in den Suchergebnissen: " << e.what() << std::endl;
+        }
+    }
+    return setlists;
+}
 
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+size_t SetlistFmService::revalidateCached() {
+    // Niemand wartet auf das Ergebnis: interaktive Requests haben Vorrang
+    HttpClient::PriorityScope priority(HttpClient::Priority::Background);
 
-        if (res == CURLE_OK) {
-            std::cout << "HTTP-Status: " << http_code << std::endl;
+    size_t changed = 0;
+    for (const auto& id : cache_->ids()) {
+        auto before = cache_->get(id);
+        auto after = getSetlist(id);
+        if (before && after && after->versionId != before->setlist.versionId) {
+            changed++;
+        }
+    }
+    cache_->save();
+    return changed;
+}
 
-            if (http_code == 200) {
-                try {
-                    return json::parse(response_string);
-                }
-                catch (const json::parse_error& e) {
-                    std::cerr << "JSON parse error: " << e.what() << std::endl;
-                    std::cerr << "Response: " << response_string.substr(0, 200) << "..." << std::endl;
-                }
+HttpClient::Request SetlistFmService::buildSetlistRequest(const std::string& setlistId, bool conditional) const {
+    auto request = buildApiRequest("/rest/1.0/setlist/" + setlistId);
+    if (!conditional) return request;
+
+    // Bekannte Setlist: nur bei nderungen den ganzen Body schicken lassen. If-None-Match nur mit
+    // einem gelieferten ETag; dass setlist.fm die versionId als ETag verwendet, ist nicht zugesagt.
+    // Ohne ETag (z.B. aus der Suche bernommen) gengt lastUpdated fr If-Modified-Since.
+    if (auto cached = cache_->get(setlistId)) {
+        const std::string& etag = cached->etag;
+        std::string lastModified = cached->lastModified;
+        if (lastModified.empty()) {
+            lastModified = httpDateFromIso(cached->setlist.lastUpdated);
+        }
+
+        if (!etag.empty()) request.headers.push_back("If-None-Match: " + etag);
+        if (!lastModified.empty()) request.headers.push_back("If-Modified-Since: " + lastModified);
+    }
+    return request;
+}
+
+SetlistFmService::Resolution SetlistFmService::resolveSetlist(const std::string& setlistId,
+    const HttpClient::Response& response) {
+    if (response.cancelled) {
+        std::cout << "Abruf der Setlist " << setlistId << " abgebrochen." << std::endl;
+        return {};
+    }
+
+    if (response.ok && response.status == 304) {
+        auto cached = cache_->get(setlistId);
+        if (cached) {
+            std::cout << "Setlist " << setlistId << " unverndert (304)." << std::endl;
+            cache_->markValidated(setlistId, headerValue(response, "etag"), headerValue(response, "last-modified"));
+            return { cached->setlist };
+        }
+
+        // Zwischen Request und Antwort verdrngt: Ein 304 hat keinen Body. Neu laden muss der
+        // Aufrufer, damit ein asynchroner Aufrufer hier nicht blockiert.
+        std::cout << "Setlist " << setlistId << " nicht mehr im Cache, muss neu geladen werden." << std::endl;
+        return { std::nullopt, true };
+    }
+
+    auto result = parseApiResponse(response);
+    if (result) {
+        try {
+            SetlistCache::Entry entry;
+            entry.setlist = parseSetlistJson(*result);
+            entry.etag = headerValue(response, "etag");
+            entry.lastModified = headerValue(response, "last-modified");
+            entry.validated = std::chrono::system_clock::now();
+            cache_->put(entry);
+            return { entry.setlist };
+        }
+        catch (const json::exception& e) {
+            std::cerr << "Unvollstndige Setlist: " << e.what() << std::endl;
+            return {};
+        }
+    }
+
+    // Server nicht erreichbar: lieber die zuletzt bekannte Fassung als gar nichts
+    if (!response.ok || response.status >= 500) {
+        if (auto cached = cache_->get(setlistId)) {
+            std::cerr << "Verwende zwischengespeicherte Setlist " << setlistId << "." << std::endl;
+            return { cached->setlist };
+        }
+    }
+    return {};
+}
+
+bool SetlistFmService::prewarm() {
+    return http_.prewarm("https://api.setlist.fm/", "setlistfm.prewarm");
+}
+
+void SetlistFmService::applyPerformance(const ConfigLoader::PerformanceConfig& performance) {
+    http_.setOptions(withoutMultiplexing(performance.http));
+}
+
+net::awaitable<std::optional<SetlistFmService::Setlist>> SetlistFmService::getSetlistAsync(std::string setlistId,
+    std::optional<std::chrono::steady_clock::time_point> deadline) {
+    auto request = buildSetlistRequest(setlistId);
+    request.deadline = deadline;
+
+    auto result = resolveSetlist(setlistId, co_await http_.asyncPerform(std::move(request), net::use_awaitable));
+    if (result.refetch) {
+        auto fresh = buildSetlistRequest(setlistId, false);
+        fresh.deadline = deadline;
+        result = resolveSetlist(setlistId, co_await http_.asyncPerform(std::move(fresh), net::use_awaitable));
+    }
+    co_return result.setlist;
+}
+
+HttpClient::Request SetlistFmService::buildApiRequest(const std::string& target) const {
+    HttpClient::Request request;
+    request.url = "https://api.setlist.fm" + target;
+    // Setlist-Abrufe sind idempotent und drfen gehedged werden
+    request.hedgeable = true;
+
+    // "/rest/1.0/setlist/<id>" -> "setlistfm.setlist"
+    std::string path = target.substr(0, target.find('?'));
+    if (path.rfind("/rest/1.0/", 0) == 0) {
+        path = path.substr(10);
+    }
+    request.metric = "setlistfm." + path.substr(0, path.find('/'));
+
+    // Headers setzen
+    request.headers = {
+        "Accept: application/json",
+        "x-api-key: " + config_.api_key,
+        "User-Agent: SetlistSpotifyGenerator/1.0"
+    };
+    return request;
+}
+
+std::optional<json> SetlistFmService::parseApiResponse(const HttpClient::Response& response) {
+    if (response.ok) {
+        std::cout << "HTTP-Status: " << response.status << std::endl;
+
+        if (response.status == 200) {
+            try {
+                return json::parse(response.body);
             }
-            else {
-                std::cerr << "API error, HTTP-Status: " << http_code << std::endl;
-                std::cerr << "Response: " << response_string << std::endl;
+            catch (const json::parse_error& e) {
+                std::cerr << "JSON parse error: " << e.what() << std::endl;
+                std::cerr << "Response: " << response.body.substr(0, 200) << "..." << std::endl;
             }
         }
         else {
-            std::cerr << "cURL error: " << curl_easy_strerror(res) << std::endl;
+            std::cerr << "API error, HTTP-Status: " << response.status << std::endl;
+            std::cerr << "Response: " << response.body << std::endl;
         }
     }
     else {
-        std::cerr << "Konnte cURL nicht initialisieren" << std::endl;
+        std::cerr << "cURL error: " << response.error << std::endl;
     }
 
     return std::nullopt;
@@ -99,17 +279,23 @@ SetlistFmService::Setlist SetlistFmService::parseSetlistJson(const json& j) {
     Setlist setlist;
 
     // Setlist-Metadaten extrahieren
-    setlist.id = j["id"].get<std::string>();
-    setlist.eventDate = j["eventDate"].get<std::string>();
-    setlist.artist = j["artist"]["name"].get<std::string>();
+    setlist.id = j.at("id").get<std::string>();
+    setlist.versionId = j.value("versionId", "");
+    setlist.lastUpdated = j.value("lastUpdated", "");
+    setlist.eventDate = j.at("eventDate").get<std::string>();
+    setlist.artist = j.at("artist").at("name").get<std::string>();
 
     // Venue, City, Country Information
     if (j.contains("venue")) {
-        setlist.venue = j["venue"]["name"].get<std::string>();
+        const auto& venue = j["venue"];
+        setlist.venue = venue.value("name", "");
 
-        if (j["venue"].contains("city")) {
-            setlist.city = j["venue"]["city"]["name"].get<std::string>();
-            setlist.country = j["venue"]["city"]["country"]["name"].get<std::string>();
+        if (venue.contains("city")) {
+            const auto& city = venue["city"];
+            setlist.city = city.value("name", "");
+            if (city.contains("country")) {
+                setlist.country = city["country"].value("name", "");
+            }
         }
     }
 
@@ -119,7 +305,7 @@ SetlistFmService::Setlist SetlistFmService::parseSetlistJson(const json& j) {
             if (set.contains("song")) {
                 for (const auto& songJson : set["song"]) {
                     Song song;
-                    song.name = songJson["name"].get<std::string>();
+                    song.name = songJson.at("name").get<std::string>();
                     song.artist = setlist.artist; // Standard: Hauptknstler
 
                     // Prfen ob Cover
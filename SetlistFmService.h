@@ -2,10 +2,16 @@
 #include <string>
 #include <optional>
 #include <vector>
+#include <memory>
 #include <nlohmann/json.hpp>
+#include <boost/asio/awaitable.hpp>
+#include "HttpClient.h"
+#include "ConfigLoader.h"
 
 using json = nlohmann::json;
 
+class SetlistCache;
+
 class SetlistFmService {
 public:
     struct Config {
@@ -21,6 +27,8 @@ public:
 
     struct Setlist {
         std::string id;
+        std::string versionId;      // ndert sich mit jeder Bearbeitung
+        std::string lastUpdated;    // z.B. "2013-10-20T05:18:08.000+0000"
         std::string eventDate;
         std::string artist;
         std::string venue;
@@ -29,15 +37,61 @@ public:
         std::vector<Song> songs;
     };
 
-    explicit SetlistFmService(const Config& config);
+    // Unvernderliche Setlist, die UI und Importe teilen, ohne die Songs zu kopieren
+    using SetlistSnapshot = std::shared_ptr<const Setlist>;
+
+    explicit SetlistFmService(const Config& config, const HttpClient::Options& httpOptions = {});
     ~SetlistFmService();
 
-    // Hauptmethode: Setlist ber ID abrufen
-    std::optional<Setlist> getSetlist(const std::string& setlistId);
+    // Hauptmethode: Setlist ber ID abrufen. Bereits bekannte Setlists werden per
+    // If-None-Match/If-Modified-Since nachgefragt; bei 304 kommt die Setlist aus dem Cache.
+    // Nach einem Abbruch ber cancel kommt std::nullopt, auch wenn die Setlist im Cache liegt.
+    std::optional<Setlist> getSetlist(const std::string& setlistId, const CancellationToken& cancel = {});
+    // getSetlist in zwei Schritten, fr die Pipeline des Job-Servers: fetchSetlist sendet nur den
+    // Request, resolveSetlist wertet die Antwort ohne weitere Requests aus (Parsen, 304 aus dem
+    // Cache, Cache aktualisieren). Wurde die Setlist nach dem Request aus dem Cache verdrngt,
+    // fehlt zu einem 304 der Body: Dann ist refetch gesetzt, und der Aufrufer ldt sie auf seine
+    // Weise (blockierend oder asynchron) mit conditional = false neu.
+    struct Resolution {
+        std::optional<Setlist> setlist;
+        bool refetch = false;
+    };
+    HttpClient::Response fetchSetlist(const std::string& setlistId, const CancellationToken& cancel = {},
+        bool conditional = true);
+    Resolution resolveSetlist(const std::string& setlistId, const HttpClient::Response& response);
+
+    // Jngste Setlists eines Knstlers (setlist.fm sortiert nach Datum, neueste zuerst).
+    // Die Treffer landen im Cache, ein spteres getSetlist() kostet dann nur noch ein 304.
+    std::vector<Setlist> searchSetlists(const std::string& artistName, int page = 1);
+
+    // Prft alle zwischengespeicherten Setlists auf nderungen; liefert die Anzahl genderter
+    size_t revalidateCached();
+    std::shared_ptr<SetlistCache> setlistCache() const { return cache_; }
+
+    // Verbindung zu api.setlist.fm vorab aufbauen (beim Start im Hintergrund)
+    bool prewarm();
+
+    // Zeit seit dem letzten Request, den ein Benutzer ausgelst hat
+    std::chrono::steady_clock::duration foregroundIdle() const { return http_.foregroundIdle(); }
+
+    // bernimmt genderte HTTP-Einstellungen zur Laufzeit
+    void applyPerformance(const ConfigLoader::PerformanceConfig& performance);
+
+    // Nicht blockierende Variante fr Asio-Coroutinen (co_await setlists.getSetlistAsync(id))
+    net::awaitable<std::optional<Setlist>> getSetlistAsync(std::string setlistId,
+        std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt);
+
+    // Wandelt ein Setlist-Objekt der API um (auch fr archivierte Antworten, siehe SetlistIngestor).
+    // Wirft json::exception, wenn Pflichtfelder fehlen.
+    static Setlist parseSetlistJson(const json& j);
 
 private:
     Config config_;
+    HttpClient http_;
+    std::shared_ptr<SetlistCache> cache_;
 
-    std::optional<json> makeApiRequest(const std::string& target);
-    Setlist parseSetlistJson(const json& j);
+    HttpClient::Request buildApiRequest(const std::string& target) const;
+    static std::optional<json> parseApiResponse(const HttpClient::Response& response);
+    // conditional: bei bekannter Setlist If-None-Match/If-Modified-Since mitschicken
+    HttpClient::Request buildSetlistRequest(const std::string& setlistId, bool conditional = true) const;
 };
\ No newline at end of file
@@ -0,0 +1,309 @@
+#include "SetlistIngestor.h"
+#include "MappedFile.h"
+#include "Executor.h"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <filesystem>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <cctype>
+
+namespace {
+    // Ein Arbeitspaket: eine ganze JSON-Datei oder ein Zeilenblock einer NDJSON-Datei
+    struct Unit {
+        size_t file;
+        size_t begin;
+        size_t end;
+        bool lines;
+    };
+
+    bool isNdjson(const std::filesystem::path& path) {
+        auto extension = path.extension().string();
+        return extension == ".ndjson" || extension == ".jsonl";
+    }
+
+    bool isJsonInput(const std::filesystem::path& path) {
+        return path.extension() == ".json" || isNdjson(path);
+    }
+
+    bool matchesWildcard(const char* pattern, const char* text) {
+        if (*pattern == '\0') return *text == '\0';
+        if (*pattern == '*') {
+            return matchesWildcard(pattern + 1, text) || (*text != '\0' && matchesWildcard(pattern, text + 1));
+        }
+        if (*text == '\0') return false;
+        return (*pattern == '?' || *pattern == *text) && matchesWildcard(pattern + 1, text + 1);
+    }
+
+    // Einzelne Setlist oder Suchergebnis ({"setlist": [...]}) in Setlists umwandeln
+    void collect(const json& j, std::vector<SetlistFmService::Setlist>& out, uint64_t& errors) {
+        if (j.is_object() && j.contains("setlist") && j["setlist"].is_array()) {
+            for (const auto& setlist : j["setlist"]) {
+                collect(setlist, out, errors);
+            }
+            return;
+        }
+        try {
+            out.push_back(SetlistFmService::parseSetlistJson(j));
+        }
+        catch (const json::exception&) {
+            errors++;
+        }
+    }
+
+    void parseLines(const char* begin, const char* end, std::vector<SetlistFmService::Setlist>& out, uint64_t& errors) {
+        while (begin < end) {
+            const char* lineEnd = std::find(begin, end, '\n');
+            const char* first = begin;
+            while (first < lineEnd && std::isspace(static_cast<unsigned char>(*first))) first++;
+            if (first < lineEnd) {
+                try {
+                    collect(json::parse(first, lineEnd), out, errors);
+                }
+                catch (const json::exception&) {
+                    errors++;
+                }
+            }
+            begin = (lineEnd < end) ? lineEnd + 1 : end;
+        }
+    }
+
+    json setlistToJson(const SetlistFmService::Setlist& setlist) {
+        json songs = json::array();
+        for (const auto& song : setlist.songs) {
+            json entry = { {"name", song.name}, {"artist", song.artist} };
+            if (song.isCover) entry["cover_artist"] = song.coverArtist;
+            songs.push_back(std::move(entry));
+        }
+        return {
+            {"id", setlist.id},
+            {"event_date", setlist.eventDate},
+            {"artist", setlist.artist},
+            {"venue", setlist.venue},
+            {"city", setlist.city},
+            {"country", setlist.country},
+            {"songs", std::move(songs)}
+        };
+    }
+}
+
+double SetlistIngestor::Stats::megabytesPerSecond() const {
+    if (elapsed.count() <= 0) return 0.0;
+    return (bytes / (1024.0 * 1024.0)) / (elapsed.count() / 1000.0);
+}
+
+SetlistIngestor::SetlistIngestor()
+    : SetlistIngestor(Options{}) {
+}
+
+SetlistIngestor::SetlistIngestor(const Options& options)
+    : options_(options) {
+}
+
+std::vector<std::string> SetlistIngestor::expandInputs(const std::vector<std::string>& inputs) {
+    namespace fs = std::filesystem;
+    std::vector<std::string> files;
+    std::error_code error;
+
+    for (const auto& input : inputs) {
+        fs::path path(input);
+        std::string name = path.filename().string();
+
+        if (name.find_first_of("*?") != std::string::npos) {
+            fs::path directory = path.has_parent_path() ? path.parent_path() : fs::path(".");
+            for (const auto& entry : fs::directory_iterator(directory, error)) {
+                if (entry.is_regular_file() && matchesWildcard(name.c_str(), entry.path().filename().string().c_str())) {
+                    files.push_back(entry.path().string());
+                }
+            }
+        }
+        else if (fs::is_directory(path, error)) {
+            for (const auto& entry : fs::recursive_directory_iterator(path, error)) {
+                if (entry.is_regular_file() && isJsonInput(entry.path())) {
+                    files.push_back(entry.path().string());
+                }
+            }
+        }
+        else {
+            files.push_back(input);
+        }
+    }
+
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+SetlistIngestor::Stats SetlistIngestor::ingest(const std::vector<std::string>& inputs, const Consumer& consumer) {
+    auto start = std::chrono::steady_clock::now();
+    auto paths = expandInputs(inputs);
+
+    Stats stats;
+    std::atomic<uint64_t> errors{ 0 };
+
+    // Arbeitspakete nur aus Pfad und Gre bilden. Abgebildet wird eine Datei erst in ihrem
+    // Paket, sonst hielte ein groer Dump tausende Dateien gleichzeitig offen.
+    std::vector<Unit> units;
+    uint64_t totalBytes = 0;
+    std::atomic<size_t> filesRead{ 0 };
+    for (size_t i = 0; i < paths.size(); i++) {
+        std::error_code error;
+        uint64_t size = std::filesystem::file_size(paths[i], error);
+        if (error) {
+            std::cerr << "Kann " << paths[i] << " nicht ffnen." << std::endl;
+            errors++;
+            continue;
+        }
+        totalBytes += size;
+        if (size == 0) {
+            filesRead++;
+            continue;
+        }
+
+        if (!isNdjson(paths[i])) {
+            units.push_back({ i, 0, size, false });
+            continue;
+        }
+
+        // Die Grenzen werden erst im Paket auf Zeilenanfnge verschoben
+        size_t step = std::max<size_t>(options_.chunkBytes, 1);
+        for (size_t begin = 0; begin < size; begin += step) {
+            units.push_back({ i, begin, std::min<size_t>(size, begin + step), true });
+        }
+    }
+
+    std::atomic<uint64_t> bytesDone{ 0 };
+    std::atomic<uint64_t> setlistsDone{ 0 };
+    std::mutex consumerMutex;
+
+    // Fortschritt in eigenem Thread, der Aufrufer arbeitet in parallelFor mit
+    std::mutex progressMutex;
+    std::condition_variable progressCv;
+    bool finished = false;
+    std::thread reporter;
+    if (options_.reportProgress) {
+        reporter = std::thread([&]() {
+            std::unique_lock<std::mutex> lock(progressMutex);
+            while (!progressCv.wait_for(lock, options_.progressInterval, [&]() { return finished; })) {
+                double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                double megabytes = bytesDone / (1024.0 * 1024.0);
+                std::cout << std::fixed << std::setprecision(1)
+                    << "Einlesen: " << megabytes << " / " << totalBytes / (1024.0 * 1024.0) << " MB ("
+                    << (seconds > 0 ? megabytes / seconds : 0.0) << " MB/s), "
+                    << setlistsDone << " Setlists" << std::endl;
+            }
+            });
+    }
+
+    Executor::instance().parallelFor(units.size(), [&](size_t index) {
+        const Unit& unit = units[index];
+        MappedFile file;
+        if (!file.open(paths[unit.file])) {
+            // Nur das erste Paket einer Datei meldet den Fehler
+            if (unit.begin == 0) {
+                std::cerr << "Kann " << paths[unit.file] << " nicht ffnen." << std::endl;
+                errors++;
+            }
+            bytesDone += unit.end - unit.begin;
+            return;
+        }
+        if (unit.begin == 0) filesRead++;
+
+        // Ein Block enthlt die Zeilen, die in [begin, end) beginnen
+        const char* data = file.data();
+        size_t size = file.size();
+        auto lineStart = [&](size_t position) {
+            position = std::min(position, size);
+            while (position > 0 && position < size && data[position - 1] != '\n') position++;
+            return position;
+        };
+        const char* begin = data + (unit.lines ? lineStart(unit.begin) : 0);
+        const char* end = data + (unit.lines ? lineStart(unit.end) : size);
+
+        std::vector<SetlistFmService::Setlist> setlists;
+        uint64_t unitErrors = 0;
+        if (unit.lines) {
+            parseLines(begin, end, setlists, unitErrors);
+        }
+        else {
+            try {
+                collect(json::parse(begin, end), setlists, unitErrors);
+            }
+            catch (const json::parse_error&) {
+                // Manche Archive speichern NDJSON unter .json
+                parseLines(begin, end, setlists, unitErrors);
+            }
+        }
+
+        if (!setlists.empty()) {
+            std::lock_guard<std::mutex> lock(consumerMutex);
+            for (auto& setlist : setlists) {
+                consumer(std::move(setlist));
+            }
+        }
+        errors += unitErrors;
+        setlistsDone += setlists.size();
+        bytesDone += unit.end - unit.begin;
+        });
+
+    if (reporter.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(progressMutex);
+            finished = true;
+        }
+        progressCv.notify_all();
+        reporter.join();
+    }
+
+    stats.files = filesRead;
+    stats.bytes = totalBytes;
+    stats.setlists = setlistsDone;
+    stats.errors = errors;
+    stats.elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return stats;
+}
+
+bool SetlistIngestor::isIngestInvocation(int argc, char** argv) {
+    return argc > 1 && std::string(argv[1]) == "--ingest";
+}
+
+int SetlistIngestor::runCommandLine(int argc, char** argv) {
+    std::string outFile;
+    std::vector<std::string> inputs;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--out" && i + 1 < argc) outFile = argv[++i];
+        else if (arg == "--threads" && i + 1 < argc) Executor::configure(std::stoul(argv[++i]));
+        else inputs.push_back(arg);
+    }
+    if (inputs.empty()) {
+        std::cerr << "Aufruf: --ingest [--out index.ndjson] [--threads N] <Verzeichnis|Muster|Datei>..." << std::endl;
+        return 1;
+    }
+
+    std::ofstream out;
+    if (!outFile.empty()) {
+        out.open(outFile, std::ios::trunc | std::ios::binary);
+        if (!out.is_open()) {
+            std::cerr << "Kann " << outFile << " nicht schreiben." << std::endl;
+            return 1;
+        }
+    }
+
+    SetlistIngestor ingestor;
+    auto stats = ingestor.ingest(inputs, [&out](SetlistFmService::Setlist&& setlist) {
+        if (out.is_open()) {
+            out << setlistToJson(setlist).dump() << '\n';
+        }
+        });
+
+    std::cout << std::fixed << std::setprecision(1)
+        << stats.files << " Dateien, " << stats.bytes / (1024.0 * 1024.0) << " MB, "
+        << stats.setlists << " Setlists, " << stats.errors << " Fehler in "
+        << stats.elapsed.count() / 1000.0 << " s (" << stats.megabytesPerSecond() << " MB/s)" << std::endl;
+    return stats.errors == 0 ? 0 : 2;
+}
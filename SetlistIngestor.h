@@ -0,0 +1,49 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <chrono>
+#include <cstdint>
+#include "SetlistFmService.h"
+
+/// <summary>
+/// Liest archivierte setlist.fm-Antworten ohne Netzwerk ein: Verzeichnisse, Glob-Muster oder
+/// einzelne Dateien mit JSON bzw. Newline-Delimited JSON. Die Dateien werden in Blcke geteilt,
+/// auf allen Kernen des Executors geparst und nur fr die Dauer ihres Blocks in den Speicher abgebildet.
+/// </summary>
+class SetlistIngestor {
+public:
+    struct Options {
+        size_t chunkBytes = 8 * 1024 * 1024;    // NDJSON-Dateien werden an Zeilengrenzen in Blcke dieser Gre geteilt
+        std::chrono::milliseconds progressInterval{ 1000 };
+        bool reportProgress = true;             // Fortschritt und MB/s auf der Konsole
+    };
+
+    struct Stats {
+        size_t files = 0;
+        uint64_t bytes = 0;
+        uint64_t setlists = 0;
+        uint64_t errors = 0;                    // Unlesbare Dateien, Zeilen oder Setlists
+        std::chrono::milliseconds elapsed{ 0 };
+
+        double megabytesPerSecond() const;
+    };
+
+    // Wird nie gleichzeitig aufgerufen; die Reihenfolge der Setlists ist nicht festgelegt
+    using Consumer = std::function<void(SetlistFmService::Setlist&&)>;
+
+    SetlistIngestor();
+    explicit SetlistIngestor(const Options& options);
+
+    // Lst Verzeichnisse (rekursiv: *.json, *.ndjson, *.jsonl) und Muster mit * und ? im Dateinamen auf
+    static std::vector<std::string> expandInputs(const std::vector<std::string>& inputs);
+
+    Stats ingest(const std::vector<std::string>& inputs, const Consumer& consumer);
+
+    // Kommandozeile: --ingest [--out index.ndjson] [--threads N] <Verzeichnis|Muster|Datei>...
+    static bool isIngestInvocation(int argc, char** argv);
+    static int runCommandLine(int argc, char** argv);
+
+private:
+    Options options_;
+};
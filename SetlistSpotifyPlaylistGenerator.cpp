@@ -1,4 +1,7 @@
 
+// Ohne Win32 und DirectX (_WIN32 nicht definiert, Build ber CMakeLists.txt) entstehen nur die
+// Kommandozeilen-Modi; --bench-ui nur, wenn ImGui vorhanden ist (SETLIST_UI_BENCHMARK)
+#ifdef _WIN32
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
@@ -27,13 +30,29 @@
 #include <imgui.h>
 #include <imgui_impl_win32.h>
 #include <imgui_impl_dx11.h>
+#else
+#include <iostream>
+#endif
 
 // Eigene Projekt-Header
 #include "AppState.h"
 #include "UIRenderer.h"
 #include "AppInitializer.h"
+#ifdef _WIN32
 #include "DirectXSetup.h"
+#endif
+#include "JobServer.h"
+#include "SetlistIngestor.h"
+#include "CacheBundle.h"
+#include "LoadSimulator.h"
+#if defined(_WIN32) && !defined(SETLIST_UI_BENCHMARK)
+#define SETLIST_UI_BENCHMARK
+#endif
+#ifdef SETLIST_UI_BENCHMARK
+#include "UiBenchmark.h"
+#endif
 
+#ifdef _WIN32
 // Forward-Deklaration von ImGui_ImplWin32_WndProcHandler
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -45,9 +64,51 @@ ID3D11Device* g_pd3dDevice = nullptr;
 ID3D11DeviceContext* g_pd3dDeviceContext = nullptr;
 IDXGISwapChain* g_pSwapChain = nullptr;
 ID3D11RenderTargetView* g_mainRenderTargetView = nullptr;
+#endif
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+    // Server-Modus: Job-API ohne Fenster
+    if (JobServer::isServerInvocation(argc, argv))
+    {
+        return JobServer::run(JobServer::parseArguments(argc, argv));
+    }
+
+    // Offline-Einlesen archivierter setlist.fm-Antworten
+    if (SetlistIngestor::isIngestInvocation(argc, argv))
+    {
+        return SetlistIngestor::runCommandLine(argc, argv);
+    }
+
+    // Cache-Bundle fr den Warmstart neuer Worker schreiben bzw. bernehmen
+    if (CacheBundle::isBundleInvocation(argc, argv))
+    {
+        return CacheBundle::runCommandLine(argc, argv);
+    }
+
+    // Lastsimulation mit virtueller Uhr, um Performance-Einstellungen offline abzustimmen
+    if (LoadSimulator::isSimulationInvocation(argc, argv))
+    {
+        return LoadSimulator::runCommandLine(argc, argv);
+    }
+
+#ifdef SETLIST_UI_BENCHMARK
+    // Frame-Zeiten der Oberflche ohne Fenster und Renderer messen
+    if (UiBenchmark::isBenchmarkInvocation(argc, argv))
+    {
+        return UiBenchmark::runCommandLine(argc, argv);
+    }
+#endif
+
+#ifndef _WIN32
+    std::cerr << "Die Oberflche gibt es nur unter Windows. Verfgbare Modi: --server, --ingest, "
+        "--export-caches, --import-caches, --simulate"
+#ifdef SETLIST_UI_BENCHMARK
+        ", --bench-ui"
+#endif
+        << std::endl;
+    return 1;
+#else
     // Fenster erstellen
     WNDCLASSEXW wc = { sizeof(wc), CS_CLASSDC, WndProc, 0L, 0L, GetModuleHandle(nullptr), nullptr, nullptr, nullptr, nullptr, L"Setlist Spotify Generator", nullptr };
     RegisterClassExW(&wc);
@@ -105,6 +166,11 @@ int main(int, char**)
 
         // UI rendern
         UIRenderer::RenderMainUI(appState);
+        if (appState.quitRequested)
+        {
+            appState.quitRequested = false;
+            ::PostQuitMessage(0);
+        }
 
         // Rendern
         ImGui::Render();
@@ -117,6 +183,7 @@ int main(int, char**)
     }
 
     // Cleanup
+    AppInitializer::Shutdown(appState);
     ImGui_ImplDX11_Shutdown();
     ImGui_ImplWin32_Shutdown();
     ImGui::DestroyContext();
@@ -126,8 +193,10 @@ int main(int, char**)
     UnregisterClassW(wc.lpszClassName, wc.hInstance);
 
     return 0;
+#endif
 }
 
+#ifdef _WIN32
 // Win32 Nachrichtenverarbeitung
 LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 {
@@ -153,4 +222,5 @@ LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
         return 0;
     }
     return ::DefWindowProc(hWnd, msg, wParam, lParam);
-}
\ No newline at end of file
+}
+#endif
\ No newline at end of file
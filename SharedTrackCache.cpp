@@ -0,0 +1,272 @@
+#include "SharedTrackCache.h"
+#include <atomic>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <thread>
+#include <iostream>
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr uint32_t kMagic = 0x53544331;     // "STC1"
+    constexpr uint32_t kVersion = 1;
+
+    enum : uint32_t { kUninitialized = 0, kInitializing = 1, kReady = 2 };
+
+    // Mehrere Prozesse greifen gleichzeitig zu: nur echte Hardware-Atomics funktionieren
+    static_assert(std::atomic<uint32_t>::is_always_lock_free, "32-Bit-Atomics mssen lock-free sein");
+
+    int64_t toMs(std::chrono::system_clock::time_point time) {
+        return std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()).count();
+    }
+}
+
+struct alignas(64) SharedTrackCache::Header {
+    std::atomic<uint32_t> state;    // Ein frisch angelegtes Segment ist mit Nullen gefllt
+    uint32_t magic;
+    uint32_t version;
+    uint64_t slots;
+};
+
+struct alignas(64) SharedTrackCache::Slot {
+    std::atomic<uint32_t> sequence; // Ungerade, solange ein Schreiber den Platz fllt
+    uint8_t keyLength;
+    uint8_t idLength;
+    uint64_t hash;                  // 0 = nie belegt
+    int64_t storedMs;
+    char key[kMaxKeyLength];
+    char trackId[kMaxIdLength + 1];
+};
+
+SharedTrackCache::~SharedTrackCache() {
+    // Das Segment selbst bleibt fr die anderen Prozesse bestehen
+#ifdef _WIN32
+    if (header_) UnmapViewOfFile(header_);
+    if (mapping_) CloseHandle(mapping_);
+#else
+    if (header_) munmap(header_, bytes_);
+    if (fd_ >= 0) ::close(fd_);
+#endif
+}
+
+std::shared_ptr<SharedTrackCache> SharedTrackCache::open(const Options& options) {
+    size_t slots = 1;
+    while (slots < options.slots) slots <<= 1;
+    size_t bytes = sizeof(Header) + slots * sizeof(Slot);
+
+    std::shared_ptr<SharedTrackCache> cache(new SharedTrackCache());
+    cache->name_ = options.name;
+
+#ifdef _WIN32
+    // Auslagerungsdatei-gesttzt; lebt, solange ein Prozess das Handle offen hat
+    std::string mappingName = "Local\\" + options.name;
+    HANDLE mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE,
+        static_cast<DWORD>(static_cast<uint64_t>(bytes) >> 32), static_cast<DWORD>(bytes & 0xFFFFFFFF),
+        mappingName.c_str());
+    if (!mapping) {
+        std::cerr << "Gemeinsamer Track-Cache '" << options.name << "' nicht verfgbar (Fehler "
+            << GetLastError() << ")" << std::endl;
+        return nullptr;
+    }
+    cache->mapping_ = mapping;
+
+    void* view = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, 0);
+    MEMORY_BASIC_INFORMATION info;
+    if (!view || VirtualQuery(view, &info, sizeof(info)) == 0) {
+        std::cerr << "Gemeinsamer Track-Cache '" << options.name << "' lsst sich nicht abbilden" << std::endl;
+        return nullptr;
+    }
+    // Ein bestehendes Segment kann mit einer anderen Gre angelegt worden sein
+    cache->header_ = static_cast<Header*>(view);
+    cache->bytes_ = info.RegionSize;
+#else
+    std::string shmName = "/" + options.name;
+    cache->fd_ = shm_open(shmName.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0600);
+    if (cache->fd_ < 0) {
+        std::cerr << "Gemeinsamer Track-Cache '" << options.name << "' nicht verfgbar: "
+            << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+
+    // Nur ein neues Segment bekommt die gewnschte Gre; ftruncate auf dieselbe Gre ist harmlos
+    struct stat info;
+    if (fstat(cache->fd_, &info) == 0 && info.st_size == 0) {
+        if (ftruncate(cache->fd_, static_cast<off_t>(bytes)) != 0) {
+            std::cerr << "Gemeinsamer Track-Cache: ftruncate fehlgeschlagen: " << std::strerror(errno) << std::endl;
+            return nullptr;
+        }
+    }
+    if (fstat(cache->fd_, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Header)) {
+        return nullptr;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, cache->fd_, 0);
+    if (data == MAP_FAILED) {
+        std::cerr << "Gemeinsamer Track-Cache lsst sich nicht abbilden: " << std::strerror(errno) << std::endl;
+        return nullptr;
+    }
+    cache->header_ = static_cast<Header*>(data);
+    cache->bytes_ = static_cast<size_t>(info.st_size);
+#endif
+
+    if (!cache->attach(cache->bytes_, slots)) {
+        return nullptr;
+    }
+    return cache;
+}
+
+bool SharedTrackCache::attach(size_t bytes, size_t slots) {
+    // Der erste Prozess schreibt den Kopf, alle anderen warten darauf
+    uint32_t expected = kUninitialized;
+    if (header_->state.compare_exchange_strong(expected, kInitializing, std::memory_order_acq_rel)) {
+        header_->magic = kMagic;
+        header_->version = kVersion;
+        header_->slots = std::min<uint64_t>(slots, (bytes - sizeof(Header)) / sizeof(Slot));
+        header_->state.store(kReady, std::memory_order_release);
+    }
+    else {
+        auto until = std::chrono::steady_clock::now() + std::chrono::seconds(1);
+        while (header_->state.load(std::memory_order_acquire) != kReady) {
+            if (std::chrono::steady_clock::now() >= until) {
+                std::cerr << "Gemeinsamer Track-Cache '" << name_ << "' wurde nicht fertig angelegt" << std::endl;
+                return false;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    uint64_t count = header_->slots;
+    if (header_->magic != kMagic || header_->version != kVersion || count == 0 || (count & (count - 1)) != 0 ||
+        sizeof(Header) + count * sizeof(Slot) > bytes) {
+        std::cerr << "Gemeinsamer Track-Cache '" << name_ << "' hat ein unbekanntes Format" << std::endl;
+        return false;
+    }
+
+    slots_ = reinterpret_cast<Slot*>(reinterpret_cast<char*>(header_) + sizeof(Header));
+    mask_ = static_cast<size_t>(count - 1);
+    std::cout << "Gemeinsamer Track-Cache '" << name_ << "' verbunden (" << count << " Pltze)" << std::endl;
+    return true;
+}
+
+SharedTrackCache::Slot& SharedTrackCache::slot(size_t index) const {
+    return slots_[index & mask_];
+}
+
+uint64_t SharedTrackCache::hash(const std::string& key) {
+    // FNV-1a; 0 ist fr leere Pltze reserviert
+    uint64_t h = 1469598103934665603ULL;
+    for (unsigned char c : key) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    return h ? h : 1;
+}
+
+std::optional<SharedTrackCache::Hit> SharedTrackCache::get(const std::string& key, std::chrono::hours ttl) const {
+    if (key.size() > kMaxKeyLength) return std::nullopt;
+
+    uint64_t h = hash(key);
+    int64_t oldestValid = toMs(std::chrono::system_clock::now() - ttl);
+
+    for (size_t probe = 0; probe < kMaxProbes; probe++) {
+        const Slot& s = slot(h + probe);
+
+        // Seqlock lesen: Kopie nur gltig, wenn sich die Sequenz dabei nicht gendert hat
+        Slot copy;
+        bool consistent = false;
+        for (int attempt = 0; attempt < 64 && !consistent; attempt++) {
+            uint32_t before = s.sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+            copy.keyLength = s.keyLength;
+            copy.idLength = s.idLength;
+            copy.hash = s.hash;
+            copy.storedMs = s.storedMs;
+            std::memcpy(copy.key, s.key, sizeof(copy.key));
+            std::memcpy(copy.trackId, s.trackId, sizeof(copy.trackId));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            consistent = (s.sequence.load(std::memory_order_relaxed) == before);
+        }
+        // Ein hngender Schreiber (z.B. abgestrzter Prozess) macht nur diesen Platz unbrauchbar
+        if (!consistent) continue;
+
+        if (copy.hash == 0) return std::nullopt;
+        if (copy.hash != h || copy.keyLength != key.size() ||
+            std::memcmp(copy.key, key.data(), key.size()) != 0) {
+            continue;
+        }
+        if (copy.storedMs < oldestValid || copy.idLength == 0 || copy.idLength > kMaxIdLength) {
+            return std::nullopt;
+        }
+
+        Hit hit;
+        hit.trackId.assign(copy.trackId, copy.idLength);
+        hit.stored = std::chrono::system_clock::time_point(std::chrono::milliseconds(copy.storedMs));
+        return hit;
+    }
+    return std::nullopt;
+}
+
+void SharedTrackCache::put(const std::string& key, const std::string& trackId,
+    std::chrono::system_clock::time_point stored) {
+    if (key.size() > kMaxKeyLength || trackId.empty() || trackId.size() > kMaxIdLength) return;
+
+    uint64_t h = hash(key);
+
+    // Ziel: derselbe Schlssel, sonst der erste freie, sonst der lteste Platz im Suchfenster
+    Slot* target = nullptr;
+    uint32_t targetSequence = 0;
+    int64_t oldest = INT64_MAX;
+    for (size_t probe = 0; probe < kMaxProbes; probe++) {
+        Slot& s = slot(h + probe);
+        uint32_t sequence = s.sequence.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+
+        uint64_t slotHash = s.hash;
+        int64_t slotStored = s.storedMs;
+        bool sameKey = slotHash == h && s.keyLength == key.size() &&
+            std::memcmp(s.key, key.data(), key.size()) == 0;
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s.sequence.load(std::memory_order_relaxed) != sequence) continue;
+
+        if (slotHash == 0 || sameKey) {
+            target = &s;
+            targetSequence = sequence;
+            break;
+        }
+        if (slotStored < oldest) {
+            oldest = slotStored;
+            target = &s;
+            targetSequence = sequence;
+        }
+    }
+    if (!target) return;
+
+    // Platz sperren; hat ihn inzwischen jemand anderes gendert, wird der Eintrag verworfen
+    if (!target->sequence.compare_exchange_strong(targetSequence, targetSequence + 1, std::memory_order_acq_rel)) {
+        return;
+    }
+    std::atomic_thread_fence(std::memory_order_release);
+
+    target->keyLength = static_cast<uint8_t>(key.size());
+    target->idLength = static_cast<uint8_t>(trackId.size());
+    target->hash = h;
+    target->storedMs = toMs(stored);
+    std::memcpy(target->key, key.data(), key.size());
+    std::memcpy(target->trackId, trackId.data(), trackId.size());
+    target->trackId[trackId.size()] = '\0';
+
+    target->sequence.store(targetSequence + 2, std::memory_order_release);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <string>
+#include <optional>
+#include <memory>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// Track-Suchergebnisse im gemeinsamen Speicher (POSIX shm bzw. benannte Dateiabbildung),
+/// damit alle Import-Prozesse eines Rechners dieselben Suchen nur einmal bezahlen.
+/// Hash-Tabelle fester Gre mit offener Adressierung; jeder Platz ist durch einen
+/// Seqlock geschtzt, Leser brauchen also keine Sperre. Schreiber, die sich um einen
+/// Platz streiten, verwerfen ihren Eintrag einfach (es ist nur ein Cache).
+/// Das Segment bleibt bestehen, wenn einzelne Prozesse neu starten.
+/// </summary>
+class SharedTrackCache {
+public:
+    struct Options {
+        std::string name = "setlist_spotify_tracks";
+        size_t slots = 65536;           // Wird auf eine Zweierpotenz aufgerundet
+    };
+
+    struct Hit {
+        std::string trackId;
+        std::chrono::system_clock::time_point stored;
+    };
+
+    ~SharedTrackCache();
+
+    SharedTrackCache(const SharedTrackCache&) = delete;
+    SharedTrackCache& operator=(const SharedTrackCache&) = delete;
+
+    // ffnet das Segment oder legt es an; nullptr, wenn das nicht mglich ist
+    static std::shared_ptr<SharedTrackCache> open(const Options& options);
+
+    std::optional<Hit> get(const std::string& key, std::chrono::hours ttl) const;
+    void put(const std::string& key, const std::string& trackId,
+        std::chrono::system_clock::time_point stored = std::chrono::system_clock::now());
+
+    const std::string& name() const { return name_; }
+    size_t slots() const { return mask_ + 1; }
+
+private:
+    struct Header;
+    struct Slot;
+
+    // Ohne das Prfix passen Spotify-IDs (22 Zeichen) und bliche Titel bequem hinein
+    static constexpr size_t kMaxKeyLength = 190;
+    static constexpr size_t kMaxIdLength = 31;
+    static constexpr size_t kMaxProbes = 16;
+
+    SharedTrackCache() = default;
+
+    static uint64_t hash(const std::string& key);
+    bool attach(size_t bytes, size_t slots);
+    Slot& slot(size_t index) const;
+
+    std::string name_;
+    Header* header_ = nullptr;
+    Slot* slots_ = nullptr;
+    size_t mask_ = 0;
+    size_t bytes_ = 0;
+#ifdef _WIN32
+    void* mapping_ = nullptr;   // HANDLE
+#else
+    int fd_ = -1;
+#endif
+};
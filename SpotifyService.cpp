@@ -1,229 +1,500 @@
 #include "SpotifyService.h"
+#include "ImportJournal.h"
+#include "AsyncOps.h"
+#include "Executor.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
+#include <cctype>
+#include <mutex>
+#include <condition_variable>
 #include <curl/curl.h>
 
-// Callback-Funktion fr cURL
-static size_t WriteCallback(void* contents, size_t size, size_t nmemb, std::string* s) {
-    size_t newLength = size * nmemb;
-    try {
-        s->append((char*)contents, newLength);
-        return newLength;
-    }
-    catch (std::bad_alloc& e) {
-        return 0;
-    }
-}
+SpotifyService::SpotifyService(const AuthConfig& config, const HttpClient::Options& httpOptions,
+    std::shared_ptr<TokenStore> tokens, const std::string& account)
+    : config_(config),
+    http_(std::make_shared<HttpClient>(httpOptions)),
+    tokens_(tokens ? std::move(tokens) : std::make_shared<TokenStore>()),
+    trackCache_(std::make_shared<TrackCache>()),
+    searchLimit_(std::make_shared<std::atomic<int>>(1)),
+    searchCascade_(std::make_shared<std::atomic<bool>>(false)),
+    printStats_(std::make_shared<std::atomic<bool>>(false)),
+    account_(account), ownsCurlGlobal_(true) {
+    // cURL global initialisieren
+    curl_global_init(CURL_GLOBAL_DEFAULT);
 
-bool SpotifyService::TokenInfo::isExpired() const {
-    auto now = std::chrono::system_clock::now();
-    return (now - timestamp) >= std::chrono::seconds(expires_in - 300); // 5 Minuten Puffer
+    // Der TokenStore erneuert alle Konten im Hintergrund mit den Zugangsdaten dieser App
+    tokens_->setRefresher([config = config_, http = http_](const std::string&, const TokenInfo& current) {
+        return exchangeRefreshToken(config, *http, current);
+        });
 }
 
-SpotifyService::SpotifyService(const AuthConfig& config)
-    : config_(config) {
-    // cURL global initialisieren
-    curl_global_init(CURL_GLOBAL_DEFAULT);
+SpotifyService::SpotifyService(const SpotifyService& root, const std::string& account)
+    : config_(root.config_), http_(root.http_), tokens_(root.tokens_), trackCache_(root.trackCache_),
+    searchLimit_(root.searchLimit_), searchCascade_(root.searchCascade_),
+    printStats_(root.printStats_), account_(account) {
+    // cURL bleibt vom Hauptdienst initialisiert, der alle Kontodienste berlebt: curl_global_init
+    // und curl_global_cleanup sind nicht threadsicher und drfen nicht pro Job laufen
 }
 
 SpotifyService::~SpotifyService() {
     // cURL global bereinigen
-    curl_global_cleanup();
+    if (ownsCurlGlobal_) {
+        curl_global_cleanup();
+    }
 }
 
-bool SpotifyService::requestAccessToken(const std::string& auth_code) {
-    // URL fr Token-Anfrage
-    std::string url = "https://accounts.spotify.com/api/token";
+bool SpotifyService::prewarm() {
+    return http_->prewarm("https://api.spotify.com/", "spotify.prewarm");
+}
+
+void SpotifyService::applyPerformance(const ConfigLoader::PerformanceConfig& performance) {
+    http_->setOptions(performance.http);
+    trackCache_->setLimits(performance.cache.trackCapacity, std::chrono::hours(performance.cache.trackTtlHours));
+
+    // Gemeinsamen Track-Cache nur bei Bedarf (neu) verbinden
+    const auto& cache = performance.cache;
+    auto shared = trackCache_->shared();
+    if (!cache.sharedMemory) {
+        trackCache_->attachShared(nullptr);
+    }
+    else if (!shared || shared->name() != cache.sharedName) {
+        trackCache_->attachShared(SharedTrackCache::open({ cache.sharedName, cache.sharedSlots }));
+    }
+    tokens_->setRefreshLead(std::chrono::seconds(performance.tokens.refreshLeadSeconds));
+    *searchLimit_ = performance.search.limit;
+    *searchCascade_ = performance.search.cascade;
+    *printStats_ = performance.stats.printAfterImport;
+}
 
+std::unique_ptr<SpotifyService> SpotifyService::forAccount(const std::string& account) const {
+    return std::unique_ptr<SpotifyService>(new SpotifyService(*this, account));
+}
+
+std::string SpotifyService::authorizationUrl(const std::string& state) const {
+    return "https://accounts.spotify.com/authorize?"
+        "client_id=" + config_.client_id +
+        "&response_type=code"
+        "&redirect_uri=" + urlEncode(config_.redirect_uri) +
+        "&scope=user-read-private%20playlist-modify-public"
+        "&state=" + urlEncode(state);
+}
+
+bool SpotifyService::requestAccessToken(const std::string& auth_code) {
     // Request-Body
     std::string request_body =
         "grant_type=authorization_code"
-        "&code=" + auth_code +
+        "&code=" + urlEncode(auth_code) +
         "&redirect_uri=" + urlEncode(config_.redirect_uri) +
         "&client_id=" + config_.client_id +
         "&client_secret=" + config_.client_secret;
 
-    CURL* curl = curl_easy_init();
-    std::string response_string;
-
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-
-        // Headers setzen
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    auto j = postTokenRequest(*http_, request_body);
+    if (!j) return false;
 
-        // Anfrage senden
-        CURLcode res = curl_easy_perform(curl);
-
-        // HTTP-Status abrufen
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
-
-        if (res == CURLE_OK && http_code == 200) {
-            try {
-                auto j = json::parse(response_string);
-                token_info_.access_token = j["access_token"];
-                token_info_.refresh_token = j["refresh_token"];
-                token_info_.expires_in = j["expires_in"];
-                token_info_.token_type = j["token_type"];
-                token_info_.timestamp = std::chrono::system_clock::now();
-
-                saveTokenToFile();
-                return true;
-            }
-            catch (const json::parse_error& e) {
-                std::cerr << "Token-Parsing-Fehler: " << e.what() << std::endl;
-            }
-        }
-        else {
-            std::cerr << "Token-Anfrage fehlgeschlagen: " << curl_easy_strerror(res) << std::endl;
-            std::cerr << "HTTP-Status: " << http_code << ", Response: " << response_string << std::endl;
-        }
+    try {
+        TokenInfo token;
+        token.access_token = (*j)["access_token"];
+        token.refresh_token = (*j)["refresh_token"];
+        token.expires_in = (*j)["expires_in"];
+        token.token_type = (*j)["token_type"];
+        token.timestamp = std::chrono::system_clock::now();
+
+        tokens_->put(account_, token);
+        tokens_->flush();
+        return true;
+    }
+    catch (const json::exception& e) {
+        std::cerr << "Token-Parsing-Fehler: " << e.what() << std::endl;
     }
 
     return false;
 }
 
 bool SpotifyService::refreshAccessToken() {
-    // URL fr Token-Anfrage
-    std::string url = "https://accounts.spotify.com/api/token";
+    return tokens_->refreshNow(account_);
+}
 
+std::optional<SpotifyService::TokenInfo> SpotifyService::exchangeRefreshToken(const AuthConfig& config,
+    HttpClient& http, const TokenInfo& current) {
     // Request-Body
     std::string request_body =
         "grant_type=refresh_token"
-        "&refresh_token=" + token_info_.refresh_token +
-        "&client_id=" + config_.client_id +
-        "&client_secret=" + config_.client_secret;
+        "&refresh_token=" + current.refresh_token +
+        "&client_id=" + config.client_id +
+        "&client_secret=" + config.client_secret;
 
-    CURL* curl = curl_easy_init();
-    std::string response_string;
+    auto j = postTokenRequest(http, request_body);
+    if (!j) return std::nullopt;
 
-    if (curl) {
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_POSTFIELDS, request_body.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-
-        // Headers setzen
-        struct curl_slist* headers = NULL;
-        headers = curl_slist_append(headers, "Content-Type: application/x-www-form-urlencoded");
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    try {
+        TokenInfo token;
+        token.access_token = (*j)["access_token"];
+        token.refresh_token = j->value("refresh_token", current.refresh_token);
+        token.expires_in = (*j)["expires_in"];
+        token.token_type = (*j)["token_type"];
+        token.timestamp = std::chrono::system_clock::now();
+        return token;
+    }
+    catch (const json::exception& e) {
+        std::cerr << "Token-Refresh-Parsing-Fehler: " << e.what() << std::endl;
+    }
 
-        // Anfrage senden
-        CURLcode res = curl_easy_perform(curl);
+    return std::nullopt;
+}
 
-        // HTTP-Status abrufen
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+std::optional<json> SpotifyService::postTokenRequest(HttpClient& http, const std::string& request_body) {
+    HttpClient::Request request;
+    request.method = "POST";
+    request.url = "https://accounts.spotify.com/api/token";
+    request.headers = { "Content-Type: application/x-www-form-urlencoded" };
+    request.body = request_body;
+    request.metric = "spotify.token";
 
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+    auto response = http.perform(request);
 
-        if (res == CURLE_OK && http_code == 200) {
-            try {
-                auto j = json::parse(response_string);
-                token_info_.access_token = j["access_token"];
-                token_info_.expires_in = j["expires_in"];
-                token_info_.token_type = j["token_type"];
-                token_info_.timestamp = std::chrono::system_clock::now();
-
-                saveTokenToFile();
-                return true;
-            }
-            catch (const json::parse_error& e) {
-                std::cerr << "Token-Refresh-Parsing-Fehler: " << e.what() << std::endl;
-            }
+    if (response.ok && response.status == 200) {
+        try {
+            return json::parse(response.body);
         }
-        else {
-            std::cerr << "Token-Refresh fehlgeschlagen: " << curl_easy_strerror(res) << std::endl;
-            std::cerr << "HTTP-Status: " << http_code << ", Response: " << response_string << std::endl;
+        catch (const json::parse_error& e) {
+            std::cerr << "Token-Parsing-Fehler: " << e.what() << std::endl;
         }
     }
+    else {
+        std::cerr << "Token-Anfrage fehlgeschlagen: " << response.error << std::endl;
+        std::cerr << "HTTP-Status: " << response.status << ", Response: " << response.body << std::endl;
+    }
 
-    return false;
+    return std::nullopt;
 }
 
-bool SpotifyService::loadTokenFromFile(const std::string& filename) {
-    try {
-        std::ifstream file(filename);
-        if (!file.is_open()) return false;
+bool SpotifyService::loadTokenFromFile() {
+    tokens_->load();
+    return tokens_->get(account_).has_value();
+}
 
-        json j;
-        file >> j;
+bool SpotifyService::saveTokenToFile() const {
+    return tokens_->flush();
+}
 
-        token_info_.access_token = j["access_token"];
-        token_info_.refresh_token = j["refresh_token"];
-        token_info_.expires_in = j["expires_in"];
-        token_info_.token_type = j["token_type"];
-        token_info_.timestamp = std::chrono::system_clock::time_point(
-            std::chrono::milliseconds(j["timestamp_ms"].get<int64_t>())
-        );
+std::optional<json> SpotifyService::getTrack(const std::string& track_id) {
+    if (!ensureValidToken()) return std::nullopt;
+    return makeApiRequest("/v1/tracks/" + track_id);
+}
 
-        return true;
+std::optional<json> SpotifyService::searchTrack(const std::string& query) {
+    if (!ensureValidToken()) return std::nullopt;
+    return makeApiRequest(searchEndpoint(query));
+}
+
+std::optional<std::string> SpotifyService::searchTrackId(const std::string& trackName, const std::string& artist,
+    const std::string& alternateArtist, const CancellationToken& cancel) {
+    std::string cacheKey = TrackCache::makeKey(trackName, artist);
+    if (auto cached = trackCache_->get(cacheKey)) {
+        return cached;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error loading token: " << e.what() << std::endl;
-        return false;
+
+    HttpClient::CancellationScope cancellation(cancel);
+    if (HttpClient::CancellationScope::cancelled() || !ensureValidToken()) return std::nullopt;
+
+    std::optional<std::string> trackId;
+    if (searchCascade_->load()) {
+        trackId = searchCascade(trackName, artist, alternateArtist);
+    }
+    else {
+        std::string query = "track:" + trackName + " artist:" + artist;
+        trackId = parseSearchResult(makeApiRequest(searchEndpoint(query)), trackName);
+    }
+    if (trackId) {
+        trackCache_->put(cacheKey, *trackId);
     }
+    return trackId;
 }
 
-bool SpotifyService::saveTokenToFile(const std::string& filename) const {
-    try {
-        json j;
-        j["access_token"] = token_info_.access_token;
-        j["refresh_token"] = token_info_.refresh_token;
-        j["expires_in"] = token_info_.expires_in;
-        j["token_type"] = token_info_.token_type;
-        j["timestamp_ms"] = std::chrono::duration_cast<std::chrono::milliseconds>(
-            token_info_.timestamp.time_since_epoch()
-        ).count();
-
-        std::ofstream file(filename);
-        file << j.dump(4);
-        return true;
+net::awaitable<std::optional<std::string>> SpotifyService::searchTrackIdAsync(std::string trackName,
+    std::string artist, std::optional<std::chrono::steady_clock::time_point> deadline, std::string alternateArtist,
+    CancellationToken cancel) {
+    std::string cacheKey = TrackCache::makeKey(trackName, artist);
+    if (auto cached = trackCache_->get(cacheKey)) {
+        co_return cached;
     }
-    catch (const std::exception& e) {
-        std::cerr << "Error saving token: " << e.what() << std::endl;
-        return false;
+
+    // Wie bei searchTrackId gilt ohne eigenes Token das des Threads, der die Suche startet
+    if (!cancel.cancellable()) cancel = HttpClient::CancellationScope::current();
+    if (cancel.cancelled() || !co_await ensureValidTokenAsync()) co_return std::nullopt;
+
+    std::optional<std::string> trackId;
+    if (searchCascade_->load()) {
+        trackId = co_await searchCascadeAsync(trackName, artist, alternateArtist, deadline, cancel);
+    }
+    else {
+        std::string query = "track:" + trackName + " artist:" + artist;
+        auto request = buildApiRequest(searchEndpoint(query));
+        request.deadline = deadline;
+        request.cancel = cancel;
+
+        auto response = co_await http_->asyncPerform(std::move(request), net::use_awaitable);
+        trackId = parseSearchResult(parseApiResponse(response), trackName);
     }
+    if (trackId) {
+        trackCache_->put(cacheKey, *trackId);
+    }
+    co_return trackId;
 }
 
-std::optional<json> SpotifyService::getTrack(const std::string& track_id) {
-    if (!ensureValidToken()) return std::nullopt;
-    return makeApiRequest("/v1/tracks/" + track_id);
+net::awaitable<std::vector<std::optional<std::string>>> SpotifyService::searchTrackIdsAsync(
+    std::vector<std::pair<std::string, std::string>> songs,
+    std::optional<std::chrono::steady_clock::time_point> deadline, CancellationToken cancel) {
+    std::vector<net::awaitable<std::optional<std::string>>> searches;
+    searches.reserve(songs.size());
+    for (auto& [title, artist] : songs) {
+        searches.push_back(searchTrackIdAsync(std::move(title), std::move(artist), deadline, "", cancel));
+    }
+    co_return co_await AsyncOps::whenAll(std::move(searches));
 }
 
-std::optional<json> SpotifyService::searchTrack(const std::string& query) {
-    if (!ensureValidToken()) return std::nullopt;
-    return makeApiRequest("/v1/search?q=" + urlEncode(query) + "&type=track&limit=1");
+std::vector<std::string> SpotifyService::cascadeVariants(const std::string& trackName, const std::string& artist,
+    const std::string& alternateArtist) {
+    std::string normalized = normalizeTitle(trackName);
+    std::string strict = "track:" + trackName + " artist:" + artist;
+
+    std::vector<std::string> variants;
+    auto addVariant = [&](std::string query) {
+        if (query != strict && std::find(variants.begin(), variants.end(), query) == variants.end()) {
+            variants.push_back(std::move(query));
+        }
+    };
+    if (!normalized.empty()) {
+        addVariant("track:" + normalized + " artist:" + artist);
+    }
+    if (!alternateArtist.empty()) {
+        addVariant("track:" + trackName + " artist:" + alternateArtist);
+    }
+    addVariant((normalized.empty() ? trackName : normalized) + " " + artist);
+    return variants;
 }
 
-std::optional<std::string> SpotifyService::searchTrackId(const std::string& trackName, const std::string& artist) {
-    if (!ensureValidToken()) return std::nullopt;
+std::optional<std::string> SpotifyService::searchCascade(const std::string& trackName, const std::string& artist,
+    const std::string& alternateArtist) {
+    std::string strict = "track:" + trackName + " artist:" + artist;
+    std::vector<std::string> variants = cascadeVariants(trackName, artist, alternateArtist);
+
+    // Antworten der Varianten; berleben das vorzeitige Ende dieser Funktion
+    struct Cascade {
+        std::mutex mutex;
+        std::condition_variable cv;
+        std::vector<std::optional<HttpClient::Response>> responses;
+    };
+    auto cascade = std::make_shared<Cascade>();
+    cascade->responses.resize(variants.size());
+
+    // Sobald ein Treffer feststeht, werden die brigen Varianten abgebrochen (auch wartende)
+    auto losers = CancellationToken::linkedTo(HttpClient::CancellationScope::current());
+
+    // Mehr Kandidaten, da die Treffer gelockerter Suchen erst geprft werden
+    for (size_t i = 0; i < variants.size(); i++) {
+        auto request = buildApiRequest(searchEndpoint(variants[i], 5));
+        request.cancel = losers;
+        http_->performAsync(request, [cascade, i](HttpClient::Response response) {
+            std::lock_guard<std::mutex> lock(cascade->mutex);
+            cascade->responses[i] = std::move(response);
+            cascade->cv.notify_all();
+            });
+    }
+
+    // Die strikte Suche luft blockierend (mit Wiederholungen), die Varianten whrenddessen
+    if (auto trackId = parseSearchResult(makeApiRequest(searchEndpoint(strict)), trackName)) {
+        losers.cancel();
+        return trackId;
+    }
+
+    std::vector<std::string> artists = { artist };
+    if (!alternateArtist.empty()) artists.push_back(alternateArtist);
+
+    for (size_t i = 0; i < variants.size(); i++) {
+        HttpClient::Response response;
+        {
+            std::unique_lock<std::mutex> lock(cascade->mutex);
+            cascade->cv.wait(lock, [&]() { return cascade->responses[i].has_value(); });
+            response = std::move(*cascade->responses[i]);
+        }
+        if (auto trackId = matchSearchResult(parseApiResponse(response), trackName, artists)) {
+            losers.cancel();
+            return trackId;
+        }
+    }
+    return std::nullopt;
+}
+
+net::awaitable<std::optional<std::string>> SpotifyService::searchCascadeAsync(std::string trackName,
+    std::string artist, std::string alternateArtist, std::optional<std::chrono::steady_clock::time_point> deadline,
+    CancellationToken cancel) {
+    // Index 0 ist die strikte Suche, danach die Varianten
+    std::vector<std::string> queries = { "track:" + trackName + " artist:" + artist };
+    for (auto& variant : cascadeVariants(trackName, artist, alternateArtist)) {
+        queries.push_back(std::move(variant));
+    }
+
+    // Antworten aller Suchen; die Coroutine wartet jeweils auf die nchste in der Rangfolge
+    struct Cascade {
+        std::mutex mutex;
+        std::vector<std::optional<HttpClient::Response>> responses;
+        size_t awaited = 0;
+        std::function<void()> waiter;   // Fortsetzung der Coroutine, solange responses[awaited] fehlt
+    };
+    auto cascade = std::make_shared<Cascade>();
+    cascade->responses.resize(queries.size());
+
+    // Sobald ein Treffer feststeht, werden die brigen Suchen abgebrochen (auch wartende)
+    auto losers = CancellationToken::linkedTo(cancel);
+    for (size_t i = 0; i < queries.size(); i++) {
+        // Mehr Kandidaten fr die Varianten, da ihre Treffer erst geprft werden
+        auto request = buildApiRequest(i == 0 ? searchEndpoint(queries[i]) : searchEndpoint(queries[i], 5));
+        request.deadline = deadline;
+        request.cancel = losers;
+        http_->performAsync(request, [cascade, i](HttpClient::Response response) {
+            std::function<void()> waiter;
+            {
+                std::lock_guard<std::mutex> lock(cascade->mutex);
+                cascade->responses[i] = std::move(response);
+                if (cascade->awaited == i) waiter = std::move(cascade->waiter);
+            }
+            if (waiter) waiter();
+            });
+    }
+
+    std::vector<std::string> artists = { artist };
+    if (!alternateArtist.empty()) artists.push_back(alternateArtist);
+
+    for (size_t i = 0; i < queries.size(); i++) {
+        // Benannt statt als Temporary (siehe AsyncOps::whenAll)
+        auto waitFor = [cascade, i](auto handler) {
+            auto work = net::make_work_guard(handler);
+            auto pending = std::make_shared<std::pair<decltype(handler), decltype(work)>>(
+                std::move(handler), std::move(work));
+            auto resume = [pending]() {
+                auto executor = pending->second.get_executor();
+                net::post(executor, [pending]() {
+                    pending->first();
+                    pending->second.reset();
+                    });
+            };
+
+            std::unique_lock<std::mutex> lock(cascade->mutex);
+            cascade->awaited = i;
+            if (cascade->responses[i]) {
+                lock.unlock();
+                resume();
+            }
+            else {
+                cascade->waiter = resume;
+            }
+        };
+        co_await net::async_initiate<decltype(net::use_awaitable), void()>(waitFor, net::use_awaitable);
+
+        HttpClient::Response response;
+        {
+            std::lock_guard<std::mutex> lock(cascade->mutex);
+            response = std::move(*cascade->responses[i]);
+        }
+        auto trackId = (i == 0) ? parseSearchResult(parseApiResponse(response), trackName)
+            : matchSearchResult(parseApiResponse(response), trackName, artists);
+        if (trackId) {
+            losers.cancel();
+            co_return trackId;
+        }
+    }
+    co_return std::nullopt;
+}
+
+std::optional<std::string> SpotifyService::matchSearchResult(const std::optional<json>& result,
+    const std::string& trackName, const std::vector<std::string>& artists) {
+    if (!result) return std::nullopt;
+
+    std::string title = normalizeTitle(trackName);
+    std::vector<std::string> wanted;
+    for (const auto& artist : artists) {
+        wanted.push_back(normalizeTitle(artist));
+    }
+
+    try {
+        if (!result->contains("tracks") || !(*result)["tracks"].contains("items")) return std::nullopt;
+        for (const auto& track : (*result)["tracks"]["items"]) {
+            if (normalizeTitle(track.value("name", "")) != title) continue;
+
+            for (const auto& trackArtist : track.value("artists", json::array())) {
+                std::string name = normalizeTitle(trackArtist.value("name", ""));
+                if (std::find(wanted.begin(), wanted.end(), name) != wanted.end()) {
+                    return track.at("id").get<std::string>();
+                }
+            }
+        }
+    }
+    catch (const json::exception& e) {
+        std::cerr << "Fehler beim Parsen der Track-Suche: " << e.what() << std::endl;
+    }
+    return std::nullopt;
+}
+
+std::string SpotifyService::normalizeTitle(const std::string& title) {
+    // Medleys ("Song A / Song B") und Zustze wie "Song - Live at ..." abschneiden
+    std::string text = title.substr(0, title.find(" / "));
+    text = text.substr(0, text.find(" - "));
+
+    std::string result;
+    int depth = 0;
+    for (unsigned char c : text) {
+        if (c == '(' || c == '[') {
+            depth++;
+        }
+        else if (c == ')' || c == ']') {
+            if (depth > 0) depth--;
+        }
+        else if (depth > 0 || c == '\'') {
+            // Klammerzustze ("(Live)", "[Acoustic]") und Apostrophe entfallen
+        }
+        else if (std::isalnum(c) || c >= 0x80) {
+            result += static_cast<char>(std::tolower(c));
+        }
+        else if (!result.empty() && result.back() != ' ') {
+            result += ' ';
+        }
+    }
+    while (!result.empty() && result.back() == ' ') {
+        result.pop_back();
+    }
+    return result;
+}
 
-    std::string query = "track:" + trackName + " artist:" + artist;
-    auto result = makeApiRequest("/v1/search?q=" + urlEncode(query) + "&type=track&limit=1");
+std::string SpotifyService::searchEndpoint(const std::string& query, int minLimit) const {
+    int limit = std::max(searchLimit_->load(), minLimit);
+    return "/v1/search?q=" + urlEncode(query) + "&type=track&limit=" + std::to_string(limit);
+}
 
+std::optional<std::string> SpotifyService::parseSearchResult(const std::optional<json>& result,
+    const std::string& trackName) {
     if (result) {
         try {
             if ((*result).contains("tracks") &&
                 (*result)["tracks"].contains("items") &&
                 !(*result)["tracks"]["items"].empty()) {
 
-                auto track = (*result)["tracks"]["items"][0];
-                return track["id"].get<std::string>();
+                // Bei mehreren Kandidaten gewinnt ein exakter Titel, sonst Spotifys bester Treffer
+                auto lower = [](std::string text) {
+                    std::transform(text.begin(), text.end(), text.begin(),
+                        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+                    return text;
+                };
+                const auto& items = (*result)["tracks"]["items"];
+                for (const auto& track : items) {
+                    if (lower(track.value("name", "")) == lower(trackName)) {
+                        return track["id"].get<std::string>();
+                    }
+                }
+                return items[0]["id"].get<std::string>();
             }
         }
         catch (const json::exception& e) {
@@ -234,7 +505,9 @@ std::optional<std::string> SpotifyService::searchTrackId(const std::string& trac
     return std::nullopt;
 }
 
-std::optional<std::string> SpotifyService::createPlaylist(const std::string& name, const std::string& description) {
+std::optional<std::string> SpotifyService::createPlaylist(const std::string& name, const std::string& description,
+    const CancellationToken& cancel) {
+    HttpClient::CancellationScope cancellation(cancel);
     if (!ensureValidToken()) return std::nullopt;
 
     // Benutzerprofil abrufen, um User-ID zu erhalten
@@ -262,81 +535,306 @@ std::optional<std::string> SpotifyService::createPlaylist(const std::string& nam
     return std::nullopt;
 }
 
-bool SpotifyService::addTracksToPlaylist(const std::string& playlistId, const std::vector<std::string>& trackIds) {
+bool SpotifyService::addTracksToPlaylist(const std::string& playlistId, std::span<const std::string> trackIds,
+    const CancellationToken& cancel) {
+    HttpClient::CancellationScope cancellation(cancel);
     if (!ensureValidToken() || trackIds.empty()) return false;
 
-    // Track-URIs erstellen
-    std::vector<std::string> trackUris;
+    // Body direkt aus den IDs schreiben, ohne Zwischenvektor mit URIs und json-Objekt
+    auto body = buildTrackUrisBody(trackIds);
+    if (!body) return false;
+
+    auto request = buildApiRequest("/v1/playlists/" + playlistId + "/tracks", "POST");
+    request.body = std::move(*body);
+    request.headers.push_back("Content-Type: application/json");
+
+    return parseApiResponse(http_->perform(request)).has_value();
+}
+
+std::optional<std::string> SpotifyService::buildTrackUrisBody(std::span<const std::string> trackIds) {
+    static constexpr std::string_view kPrefix = "{\"uris\":[";
+    static constexpr std::string_view kUriPrefix = "\"spotify:track:";
+
+    size_t size = kPrefix.size() + 2;
     for (const auto& id : trackIds) {
-        trackUris.push_back("spotify:track:" + id);
+        size += kUriPrefix.size() + id.size() + 2;
     }
 
-    // JSON-Body fr Track-Hinzufgen
-    json body = {
-        {"uris", trackUris}
+    std::string body;
+    body.reserve(size);
+    body += kPrefix;
+    for (size_t i = 0; i < trackIds.size(); i++) {
+        const auto& id = trackIds[i];
+        // Spotify-IDs sind Base62; alles andere msste escaped werden und ist ohnehin ungltig
+        bool valid = !id.empty() && std::all_of(id.begin(), id.end(),
+            [](unsigned char c) { return std::isalnum(c) != 0; });
+        if (!valid) {
+            std::cerr << "Ungltige Track-ID: " << id << std::endl;
+            return std::nullopt;
+        }
+
+        if (i > 0) body += ',';
+        body += kUriPrefix;
+        body += id;
+        body += '"';
+    }
+    body += "]}";
+    return body;
+}
+
+bool SpotifyService::importSetlistToSpotify(const std::string& playlistName,
+    const std::string& artist,
+    std::span<const SetlistFmService::Song> songs,
+    ImportJournal* journal,
+    const ImportObserver& observer,
+    const CancellationToken& cancel) {
+    // Alle Requests des Imports, auch die der Suchkaskade, hngen an diesem Token
+    HttpClient::CancellationScope cancellation(cancel);
+    auto start = std::chrono::steady_clock::now();
+    size_t resolvedCount = 0;
+
+    // Ereignisse mit gemeinsamen Feldern anreichern und an den Beobachter weitergeben
+    auto emit = [&](ImportEvent&& event) {
+        if (event.type == ImportEvent::Type::SongResolved) resolvedCount++;
+        event.songCount = songs.size();
+        event.resolvedCount = resolvedCount;
+        if (observer) observer(event);
     };
 
-    auto result = makeApiRequest("/v1/playlists/" + playlistId + "/tracks", "POST", body);
+    ImportEvent started;
+    started.type = ImportEvent::Type::Started;
+    started.message = playlistName;
+    emit(std::move(started));
+
+    std::string playlistId;
+    bool success = runImport(playlistName, artist, songs, journal, emit, playlistId);
+
+    ImportEvent finished;
+    finished.type = success ? ImportEvent::Type::Finished : ImportEvent::Type::Failed;
+    finished.playlistId = playlistId;
+    finished.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (!success) {
+        finished.message = HttpClient::CancellationScope::cancelled() ?
+            "Import abgebrochen" : "Fehler beim Erstellen der Playlist";
+    }
+    emit(std::move(finished));
+
+    // Neue Suchergebnisse fr sptere Importe sichern
+    trackCache_->save();
 
-    return result.has_value();
+    return success;
 }
 
-bool SpotifyService::importSetlistToSpotify(const std::string& playlistName,
+bool SpotifyService::runImport(const std::string& playlistName,
     const std::string& artist,
-    const std::vector<std::pair<std::string, std::string>>& songs) {
+    std::span<const SetlistFmService::Song> songs,
+    ImportJournal* journal,
+    const ImportEmitter& emit,
+    std::string& playlistIdOut) {
+    // Gesamtbudget fr den Import: alle Requests teilen sich diese Deadline
+    HttpClient::DeadlineScope deadline(importBudget(songs.size()));
+
     if (!ensureValidToken()) return false;
 
-    // Playlist erstellen
-    std::cout << "Erstelle Playlist '" << playlistName << "'..." << std::endl;
-    auto playlistId = createPlaylist(playlistName, "Setlist von " + artist);
-    if (!playlistId) {
-        std::cerr << "Konnte Playlist nicht erstellen." << std::endl;
+    // Checkpoint eines frheren, abgebrochenen Laufs bernehmen
+    ImportJournal::State checkpoint = journal ? journal->state() : ImportJournal::State{};
+    if (checkpoint.completed) {
+        std::cout << "Import '" << playlistName << "' wurde bereits abgeschlossen." << std::endl;
+        playlistIdOut = checkpoint.playlistId.value_or("");
+        return true;
+    }
+
+    // Erst auflsen, dann die Playlist anlegen: Ohne Treffer, nach einem Abbruch oder nach Ablauf
+    // des Budgets bleibt so keine leere Playlist zurck, die ein Fortsetzen dann bernhme
+    auto resolved = resolveTracks(artist, songs, checkpoint, journal, emit);
+    if (!resolved) return false;
+
+    // Latenz- und Hedge-Statistik nur auf Wunsch: Im Servermodus liefen sonst bei jedem Job
+    // die Zhler aller Jobs ber die Konsole
+    if (printStats_->load()) {
+        http_->printStats(std::cout);
+    }
+
+    if (resolved->empty()) {
+        std::cerr << "Keine Songs gefunden, es wird keine Playlist erstellt." << std::endl;
         return false;
     }
 
-    // Tracks suchen
+    auto playlistId = preparePlaylist(playlistName, artist, checkpoint, journal, emit);
+    if (!playlistId) return false;
+    playlistIdOut = *playlistId;
+
+    if (!writeTracks(*playlistId, *resolved, checkpoint, journal, emit)) return false;
+
+    if (journal) journal->markCompleted();
+    std::cout << "Playlist erfolgreich erstellt und Songs hinzugefgt!" << std::endl;
+    return true;
+}
+
+std::optional<std::string> SpotifyService::preparePlaylist(const std::string& playlistName,
+    const std::string& artist,
+    const ImportJournal::State& checkpoint,
+    ImportJournal* journal,
+    const ImportEmitter& emit) {
+    // Playlist erstellen oder die bereits erstellte wiederverwenden
+    std::optional<std::string> playlistId = checkpoint.playlistId;
+    if (playlistId) {
+        std::cout << "Setze Import in Playlist " << *playlistId << " fort..." << std::endl;
+    }
+    else {
+        std::cout << "Erstelle Playlist '" << playlistName << "'..." << std::endl;
+        playlistId = createPlaylist(playlistName, "Setlist von " + artist);
+        if (!playlistId) {
+            std::cerr << "Konnte Playlist nicht erstellen." << std::endl;
+            return std::nullopt;
+        }
+        if (journal) journal->recordPlaylist(*playlistId);
+    }
+
+    ImportEvent created;
+    created.type = ImportEvent::Type::PlaylistCreated;
+    created.playlistId = *playlistId;
+    created.fromCheckpoint = checkpoint.playlistId.has_value();
+    emit(std::move(created));
+    return playlistId;
+}
+
+std::optional<SpotifyService::ResolvedTracks> SpotifyService::resolveTracks(const std::string& artist,
+    std::span<const SetlistFmService::Song> songs,
+    const ImportJournal::State& checkpoint,
+    ImportJournal* journal,
+    const ImportEmitter& emit) {
+    if (!ensureValidToken()) return std::nullopt;
+
     std::cout << "Suche nach Songs..." << std::endl;
-    std::vector<std::string> trackIds;
-    int foundCount = 0;
-    int totalCount = songs.size();
+    ResolvedTracks resolved;
+    const std::string noAlternate;
+
+    for (size_t i = 0; i < songs.size(); i++) {
+        const auto& song = songs[i];
+        const std::string& title = song.name;
+
+        // Fr Covers den Original-Knstler verwenden, sonst den Hauptknstler
+        bool isCover = song.isCover && !song.coverArtist.empty();
+        const std::string& artistToUse = isCover ? song.coverArtist : artist;
+
+        ImportEvent songEvent;
+        songEvent.songIndex = i;
+        songEvent.title = title;
+        songEvent.artist = artistToUse;
+
+        // Bereits aufgelste Songs nicht erneut suchen
+        auto known = checkpoint.resolvedTracks.find(i);
+        if (known != checkpoint.resolvedTracks.end()) {
+            resolved.push_back({ i, known->second });
+
+            songEvent.type = ImportEvent::Type::SongResolved;
+            songEvent.trackId = known->second;
+            songEvent.fromCheckpoint = true;
+            emit(std::move(songEvent));
+            continue;
+        }
 
-    for (const auto& [title, songArtist] : songs) {
-        std::cout << "  Suche: " << title;
+        if (HttpClient::DeadlineScope::expired()) {
+            std::cerr << "Import-Budget berschritten, Suche abgebrochen." << std::endl;
+            return std::nullopt;
+        }
+        if (HttpClient::CancellationScope::cancelled()) {
+            std::cerr << "Import abgebrochen." << std::endl;
+            return std::nullopt;
+        }
 
-        // Verwende den Song-spezifischen Knstler, falls vorhanden, sonst den Hauptknstler
-        std::string artistToUse = songArtist.empty() ? artist : songArtist;
+        std::cout << "  Suche: " << title;
         std::cout << " (Knstler: " << artistToUse << ")... ";
 
-        auto trackId = searchTrackId(title, artistToUse);
+        auto searchStart = std::chrono::steady_clock::now();
+        // Fr Covers ist der Hauptknstler die Alternative der Suchkaskade
+        auto trackId = searchTrackId(title, artistToUse, isCover ? artist : noAlternate);
+        songEvent.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - searchStart);
+
+        // Eine abgebrochene Suche ist kein "nicht gefunden"
+        if (!trackId && HttpClient::CancellationScope::cancelled()) {
+            std::cout << "abgebrochen." << std::endl;
+            return std::nullopt;
+        }
+
         if (trackId) {
-            trackIds.push_back(*trackId);
+            resolved.push_back({ i, *trackId });
+            if (journal) journal->recordTrack(i, *trackId);
             std::cout << "gefunden!" << std::endl;
-            foundCount++;
+
+            songEvent.type = ImportEvent::Type::SongResolved;
+            songEvent.trackId = *trackId;
         }
         else {
             std::cout << "nicht gefunden." << std::endl;
+            songEvent.type = ImportEvent::Type::SongNotFound;
         }
+        emit(std::move(songEvent));
     }
 
-    // Gefundene Tracks zur Playlist hinzufgen
-    if (!trackIds.empty()) {
-        std::cout << "\nFge " << trackIds.size() << " von " << totalCount
-            << " Songs zur Playlist hinzu..." << std::endl;
+    std::cout << "Gefunden: " << resolved.size() << " von " << songs.size() << " Songs." << std::endl;
+    return resolved;
+}
 
-        if (addTracksToPlaylist(*playlistId, trackIds)) {
-            std::cout << "Playlist erfolgreich erstellt und Songs hinzugefgt!" << std::endl;
-            std::cout << "Gefunden: " << foundCount << " von " << totalCount << " Songs." << std::endl;
-            return true;
-        }
-        else {
+bool SpotifyService::writeTracks(const std::string& playlistId,
+    ResolvedTracks& resolved,
+    const ImportJournal::State& checkpoint,
+    ImportJournal* journal,
+    const ImportEmitter& emit) {
+    if (resolved.empty()) {
+        std::cerr << "Keine Songs gefunden. Playlist ist leer." << std::endl;
+        return false;
+    }
+
+    // Gefundene Tracks chunkweise zur Playlist hinzufgen; bereits geschriebene Chunks berspringen
+    std::cout << "\nFge " << resolved.size() << " Songs zur Playlist hinzu..." << std::endl;
+
+    std::vector<std::string> chunkTracks;
+    std::vector<size_t> chunkSongs;
+    chunkTracks.reserve(std::min(resolved.size(), kMaxTracksPerRequest));
+    auto flushChunk = [&]() {
+        if (chunkTracks.empty()) return true;
+
+        auto chunkStart = std::chrono::steady_clock::now();
+        if (!addTracksToPlaylist(playlistId, chunkTracks)) return false;
+        if (journal) journal->recordChunk(chunkSongs);
+
+        ImportEvent chunkEvent;
+        chunkEvent.type = ImportEvent::Type::ChunkWritten;
+        chunkEvent.chunkSize = chunkTracks.size();
+        chunkEvent.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - chunkStart);
+        emit(std::move(chunkEvent));
+
+        chunkTracks.clear();
+        chunkSongs.clear();
+        return true;
+    };
+
+    // resolved wird danach nicht mehr gebraucht, die IDs knnen verschoben werden
+    for (auto& [index, trackId] : resolved) {
+        if (checkpoint.committedSongs.count(index)) continue;
+
+        chunkTracks.push_back(std::move(trackId));
+        chunkSongs.push_back(index);
+        if (chunkTracks.size() == kMaxTracksPerRequest && !flushChunk()) {
             std::cerr << "Fehler beim Hinzufgen der Songs zur Playlist." << std::endl;
+            return false;
         }
     }
-    else {
-        std::cerr << "Keine Songs gefunden. Playlist ist leer." << std::endl;
+    if (!flushChunk()) {
+        std::cerr << "Fehler beim Hinzufgen der Songs zur Playlist." << std::endl;
+        return false;
     }
+    resolved.clear();
+    return true;
+}
 
-    return false;
+std::chrono::milliseconds SpotifyService::importBudget(size_t songCount) const {
+    return http_->options().timeouts.importBudget(songCount);
 }
 
 std::optional<json> SpotifyService::makeApiRequest(
@@ -346,94 +844,123 @@ std::optional<json> SpotifyService::makeApiRequest(
 
     if (!ensureValidToken()) return std::nullopt;
 
-    CURL* curl = curl_easy_init();
-    std::string response_string;
-
-    if (curl) {
-        std::string url = "https://api.spotify.com" + endpoint;
-
-        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
-        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response_string);
-
-        // HTTP-Methode setzen
-        if (method == "POST") {
-            curl_easy_setopt(curl, CURLOPT_POST, 1L);
-        }
-        else if (method == "PUT") {
-            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT");
-        }
-        else if (method == "DELETE") {
-            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE");
-        }
-
-        // Headers setzen
-        struct curl_slist* headers = NULL;
-        std::string auth_header = "Authorization: " + createAuthHeader();
-        headers = curl_slist_append(headers, auth_header.c_str());
-
-        // Body setzen, falls vorhanden
-        std::string body_str;
-        if (body != nullptr) {
-            body_str = body.dump();
-            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body_str.c_str());
-            headers = curl_slist_append(headers, "Content-Type: application/json");
-        }
-
-        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-
-        // Anfrage senden
-        CURLcode res = curl_easy_perform(curl);
+    // Anfrage senden
+    return parseApiResponse(http_->perform(buildApiRequest(endpoint, method, body)));
+}
 
-        // HTTP-Status abrufen
-        long http_code = 0;
-        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+HttpClient::Request SpotifyService::buildApiRequest(
+    const std::string& endpoint,
+    const std::string& method,
+    const json& body) const {
+
+    HttpClient::Request request;
+    request.method = method;
+    request.url = "https://api.spotify.com" + endpoint;
+    request.metric = metricFor(endpoint);
+    // Nur idempotente GETs drfen doppelt gesendet werden
+    request.hedgeable = (method == "GET");
+
+    // Headers setzen
+    request.headers.push_back("Authorization: " + createAuthHeader());
+
+    // Body setzen, falls vorhanden
+    if (body != nullptr) {
+        request.body = body.dump();
+        request.headers.push_back("Content-Type: application/json");
+    }
+    return request;
+}
 
-        // Cleanup
-        curl_slist_free_all(headers);
-        curl_easy_cleanup(curl);
+std::optional<json> SpotifyService::parseApiResponse(const HttpClient::Response& response) {
+    // Ein Abbruch ist gewollt und kein Fehler
+    if (response.cancelled) return std::nullopt;
 
-        if (res == CURLE_OK) {
-            if (http_code >= 200 && http_code < 300) {
-                try {
-                    if (!response_string.empty()) {
-                        return json::parse(response_string);
-                    }
-                    else {
-                        // Manche Endpunkte geben leere Antworten zurck
-                        return json::object();
-                    }
+    if (response.ok) {
+        if (response.status >= 200 && response.status < 300) {
+            try {
+                if (!response.body.empty()) {
+                    return json::parse(response.body);
                 }
-                catch (const json::parse_error& e) {
-                    std::cerr << "JSON-Parsing-Fehler: " << e.what() << std::endl;
-                    std::cerr << "Response: " << response_string.substr(0, 200) << "..." << std::endl;
+                else {
+                    // Manche Endpunkte geben leere Antworten zurck
+                    return json::object();
                 }
             }
-            else {
-                std::cerr << "API-Fehler, HTTP-Status: " << http_code << std::endl;
-                std::cerr << "Response: " << response_string << std::endl;
+            catch (const json::parse_error& e) {
+                std::cerr << "JSON-Parsing-Fehler: " << e.what() << std::endl;
+                std::cerr << "Response: " << response.body.substr(0, 200) << "..." << std::endl;
             }
         }
         else {
-            std::cerr << "cURL-Fehler: " << curl_easy_strerror(res) << std::endl;
+            std::cerr << "API-Fehler, HTTP-Status: " << response.status << std::endl;
+            std::cerr << "Response: " << response.body << std::endl;
         }
     }
     else {
-        std::cerr << "Konnte cURL nicht initialisieren" << std::endl;
+        std::cerr << "cURL-Fehler: " << response.error << std::endl;
     }
 
     return std::nullopt;
 }
 
 bool SpotifyService::ensureValidToken() {
-    if (token_info_.isExpired()) {
+    auto token = tokens_->get(account_);
+    if (!token) return false;
+
+    // Normalerweise erneuert der TokenStore rechtzeitig; dies ist nur die Rckfallebene
+    if (token->isExpired(tokens_->refreshLead())) {
         return refreshAccessToken();
     }
     return true;
 }
 
+net::awaitable<bool> SpotifyService::ensureValidTokenAsync() {
+    auto token = tokens_->get(account_);
+    if (!token) co_return false;
+    if (!token->isExpired(tokens_->refreshLead())) co_return true;
+
+    // Luft fr das Konto schon ein Refresh, wartet refreshNow nur auf dessen Ergebnis
+    auto refresh = [tokens = tokens_, account = account_]() {
+        try {
+            return tokens->refreshNow(account);
+        }
+        catch (const std::exception& e) {
+            std::cerr << "Token-Refresh fr Konto '" << account << "' fehlgeschlagen: " << e.what() << std::endl;
+            return false;
+        }
+    };
+
+    // Noch gltig: mit dem alten Token weitersuchen und im Hintergrund erneuern (beim Beenden nicht mehr)
+    if (!token->isExpired(std::chrono::seconds(0))) {
+        Executor::instance().post([refresh]() { refresh(); });
+        co_return true;
+    }
+
+    // Abgelaufen: im Executor erneuern, die Coroutine gibt ihren Thread solange frei
+    auto refreshInExecutor = [refresh](auto handler) {
+        auto work = net::make_work_guard(handler);
+        auto pending = std::make_shared<std::pair<decltype(handler), decltype(work)>>(
+            std::move(handler), std::move(work));
+        auto complete = [pending](bool refreshed) {
+            auto executor = pending->second.get_executor();
+            net::post(executor, [pending, refreshed]() {
+                pending->first(refreshed);
+                pending->second.reset();
+                });
+        };
+        // Nach dem Beenden des Executors bliebe die Coroutine sonst fr immer hngen
+        if (!Executor::instance().post([refresh, complete]() { complete(refresh()); })) {
+            complete(false);
+        }
+    };
+    co_return co_await net::async_initiate<decltype(net::use_awaitable), void(bool)>(refreshInExecutor,
+        net::use_awaitable);
+}
+
 std::string SpotifyService::createAuthHeader() const {
-    return token_info_.token_type + " " + token_info_.access_token;
+    auto token = tokens_->get(account_);
+    if (!token) return "";
+    return token->token_type + " " + token->access_token;
 }
 
 std::string SpotifyService::urlEncode(const std::string& value) {
@@ -441,4 +968,13 @@ std::string SpotifyService::urlEncode(const std::string& value) {
     std::string result(encoded);
     curl_free(encoded);
     return result;
+}
+
+std::string SpotifyService::metricFor(const std::string& endpoint) {
+    // "/v1/search?q=..." -> "spotify.search"
+    std::string path = endpoint.substr(0, endpoint.find('?'));
+    if (path.rfind("/v1/", 0) == 0) {
+        path = path.substr(4);
+    }
+    return "spotify." + path.substr(0, path.find('/'));
 }
\ No newline at end of file
@@ -3,7 +3,18 @@
 #include <optional>
 #include <vector>
 #include <chrono>
+#include <memory>
+#include <atomic>
+#include <span>
 #include <nlohmann/json.hpp>
+#include <boost/asio/awaitable.hpp>
+#include "HttpClient.h"
+#include "ImportProgress.h"
+#include "TokenStore.h"
+#include "TrackCache.h"
+#include "ConfigLoader.h"
+#include "SetlistFmService.h"
+#include "ImportJournal.h"
 
 using json = nlohmann::json;
 
@@ -15,46 +26,146 @@ public:
         std::string redirect_uri;
     };
 
-    struct TokenInfo {
-        std::string access_token;
-        std::string refresh_token;
-        int64_t expires_in;
-        std::string token_type;
-        std::chrono::system_clock::time_point timestamp;
-        bool isExpired() const;
-    };
+    using TokenInfo = TokenStore::TokenInfo;
 
-    SpotifyService(const AuthConfig& config);
+    // Ohne TokenStore legt der Service einen eigenen an
+    SpotifyService(const AuthConfig& config,
+        const HttpClient::Options& httpOptions = {},
+        std::shared_ptr<TokenStore> tokens = nullptr,
+        const std::string& account = TokenStore::kDefaultAccount);
     ~SpotifyService();
 
-    // Token-Management
+    // Service fr ein anderes Konto; teilt Konfiguration, HTTP-Client und TokenStore
+    std::unique_ptr<SpotifyService> forAccount(const std::string& account) const;
+    const std::string& account() const { return account_; }
+    std::shared_ptr<TokenStore> tokenStore() const { return tokens_; }
+    std::shared_ptr<TrackCache> trackCache() const { return trackCache_; }
+
+    // Verbindung zu api.spotify.com vorab aufbauen (beim Start im Hintergrund)
+    bool prewarm();
+
+    // Zeit seit dem letzten Request, den ein Benutzer ausgelst hat (ber alle Konten)
+    std::chrono::steady_clock::duration foregroundIdle() const { return http_->foregroundIdle(); }
+
+    // bernimmt genderte Performance-Einstellungen zur Laufzeit (gilt fr alle Konten)
+    void applyPerformance(const ConfigLoader::PerformanceConfig& performance);
+
+    // Token-Management (fr das Konto dieses Services)
+    // Autorisierungs-URL fr den Browser; state ordnet den Redirect dem Vorgang zu
+    std::string authorizationUrl(const std::string& state) const;
     bool requestAccessToken(const std::string& auth_code);
     bool refreshAccessToken();
-    bool loadTokenFromFile(const std::string& filename = "spotify_token.json");
-    bool saveTokenToFile(const std::string& filename = "spotify_token.json") const;
+    bool loadTokenFromFile();
+    bool saveTokenToFile() const;
 
     // API-Zugriffe
     std::optional<json> getTrack(const std::string& track_id);
     std::optional<json> searchTrack(const std::string& query);
-    std::optional<std::string> searchTrackId(const std::string& trackName, const std::string& artist);
+    // alternateArtist: zweiter Knstler fr die Suchkaskade, z.B. die Band, die einen Song covert.
+    // Ein leeres CancellationToken bernimmt das der CancellationScope des Threads.
+    std::optional<std::string> searchTrackId(const std::string& trackName, const std::string& artist,
+        const std::string& alternateArtist = "", const CancellationToken& cancel = {});
+
+    // Nicht blockierende Varianten fr Asio-Coroutinen, mit Track-Cache und Suchkaskade wie searchTrackId.
+    // Die optionale Deadline gilt fr alle Requests, bei searchTrackIdsAsync also fr den gesamten
+    // Fan-out. Ein flliger Token-Refresh luft im Executor, nicht im Thread der Coroutine.
+    net::awaitable<std::optional<std::string>> searchTrackIdAsync(std::string trackName, std::string artist,
+        std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt,
+        std::string alternateArtist = "", CancellationToken cancel = {});
+    net::awaitable<std::vector<std::optional<std::string>>> searchTrackIdsAsync(
+        std::vector<std::pair<std::string, std::string>> songs,
+        std::optional<std::chrono::steady_clock::time_point> deadline = std::nullopt,
+        CancellationToken cancel = {});
 
     // Playlist-Management
-    std::optional<std::string> createPlaylist(const std::string& name, const std::string& description = "");
-    bool addTracksToPlaylist(const std::string& playlistId, const std::vector<std::string>& trackIds);
+    std::optional<std::string> createPlaylist(const std::string& name, const std::string& description = "",
+        const CancellationToken& cancel = {});
+    bool addTracksToPlaylist(const std::string& playlistId, std::span<const std::string> trackIds,
+        const CancellationToken& cancel = {});
+    // Die Songs werden nur gelesen; fr Covers wird der Original-Knstler gesucht.
+    // Nach einem Abbruch bleibt der Stand im Journal, ein erneuter Aufruf setzt dort fort.
     bool importSetlistToSpotify(const std::string& playlistName,
         const std::string& artist,
-        const std::vector<std::pair<std::string, std::string>>& songs);
+        std::span<const SetlistFmService::Song> songs,
+        ImportJournal* journal = nullptr,
+        const ImportObserver& observer = nullptr,
+        const CancellationToken& cancel = {});
+
+    // Abschnitte eines Imports einzeln, fr die Pipeline des Job-Servers (siehe ImportJobManager).
+    // importSetlistToSpotify fhrt sie nacheinander aus; emit bekommt die Ereignisse ohne Zhlerstnde.
+    using ImportEmitter = std::function<void(ImportEvent&&)>;
+    using ResolvedTracks = std::vector<std::pair<size_t, std::string>>;  // Song-Index, Track-ID
+    // Erstellt die Playlist oder bernimmt die aus dem Checkpoint
+    std::optional<std::string> preparePlaylist(const std::string& playlistName, const std::string& artist,
+        const ImportJournal::State& checkpoint, ImportJournal* journal, const ImportEmitter& emit);
+    // Nicht gefundene Songs fehlen im Ergebnis; nullopt nach Ablauf der Deadline oder einem Abbruch
+    std::optional<ResolvedTracks> resolveTracks(const std::string& artist,
+        std::span<const SetlistFmService::Song> songs,
+        const ImportJournal::State& checkpoint, ImportJournal* journal, const ImportEmitter& emit);
+    // Schreibt die noch nicht bernommenen Tracks chunkweise und leert resolved dabei
+    bool writeTracks(const std::string& playlistId, ResolvedTracks& resolved,
+        const ImportJournal::State& checkpoint, ImportJournal* journal, const ImportEmitter& emit);
+    // Zeitbudget eines ganzen Imports mit songCount Songs (performance.timeouts.import_budget_ms)
+    std::chrono::milliseconds importBudget(size_t songCount) const;
 
 private:
+    // Spotify akzeptiert maximal 100 Tracks pro Add-Request
+    static constexpr size_t kMaxTracksPerRequest = 100;
+
     AuthConfig config_;
-    TokenInfo token_info_;
+    std::shared_ptr<HttpClient> http_;
+    std::shared_ptr<TokenStore> tokens_;
+    std::shared_ptr<TrackCache> trackCache_;    // Kontounabhngig, daher von allen Konten geteilt
+    std::shared_ptr<std::atomic<int>> searchLimit_;
+    std::shared_ptr<std::atomic<bool>> searchCascade_;
+    std::shared_ptr<std::atomic<bool>> printStats_;
+    std::string account_;
+    bool ownsCurlGlobal_ = false;   // Nur der Hauptdienst, nicht die Dienste aus forAccount()
+
+    SpotifyService(const SpotifyService& root, const std::string& account);
 
     std::optional<json> makeApiRequest(
         const std::string& endpoint,
         const std::string& method = "GET",
         const json& body = nullptr);
+    HttpClient::Request buildApiRequest(const std::string& endpoint,
+        const std::string& method = "GET",
+        const json& body = nullptr) const;
+    static std::optional<json> parseApiResponse(const HttpClient::Response& response);
+    static std::optional<std::string> buildTrackUrisBody(std::span<const std::string> trackIds);
+    std::string searchEndpoint(const std::string& query, int minLimit = 1) const;
+    static std::optional<std::string> parseSearchResult(const std::optional<json>& result, const std::string& trackName);
+
+    // Suchkaskade: strikte Suche und gelockerte Varianten gleichzeitig, der bestplatzierte Treffer gewinnt
+    std::optional<std::string> searchCascade(const std::string& trackName, const std::string& artist,
+        const std::string& alternateArtist);
+    net::awaitable<std::optional<std::string>> searchCascadeAsync(std::string trackName, std::string artist,
+        std::string alternateArtist, std::optional<std::chrono::steady_clock::time_point> deadline,
+        CancellationToken cancel);
+    // Gelockerte Varianten der strikten Suche, in der Reihenfolge, in der ihre Treffer bevorzugt werden
+    static std::vector<std::string> cascadeVariants(const std::string& trackName, const std::string& artist,
+        const std::string& alternateArtist);
+    // Nur Kandidaten mit passendem (normalisiertem) Titel und einem der Knstler
+    static std::optional<std::string> matchSearchResult(const std::optional<json>& result,
+        const std::string& trackName, const std::vector<std::string>& artists);
+    // Kleinbuchstaben, ohne Klammerzustze, " - Live..."-Suffixe und Satzzeichen; bei Medleys nur der erste Teil
+    static std::string normalizeTitle(const std::string& title);
+
+    bool runImport(const std::string& playlistName,
+        const std::string& artist,
+        std::span<const SetlistFmService::Song> songs,
+        ImportJournal* journal,
+        const ImportEmitter& emit,
+        std::string& playlistIdOut);
 
+    static std::optional<json> postTokenRequest(HttpClient& http, const std::string& request_body);
+    static std::optional<TokenInfo> exchangeRefreshToken(const AuthConfig& config, HttpClient& http,
+        const TokenInfo& current);
     bool ensureValidToken();
+    // Wie ensureValidToken, ohne den Thread zu blockieren: Ein bald ablaufendes Token wird im
+    // Hintergrund erneuert, nur auf ein abgelaufenes wartet die Coroutine
+    net::awaitable<bool> ensureValidTokenAsync();
     std::string createAuthHeader() const;
     static std::string urlEncode(const std::string& value);
+    static std::string metricFor(const std::string& endpoint);
 };
\ No newline at end of file
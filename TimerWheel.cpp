@@ -0,0 +1,46 @@
+#include "TimerWheel.h"
+#include <algorithm>
+
+TimerWheel::TimerWheel(size_t slotCount, std::chrono::milliseconds tick)
+    : slots_(std::max<size_t>(slotCount, 1)), tick_(tick) {
+}
+
+void TimerWheel::schedule(const std::string& key, std::chrono::milliseconds delay) {
+    // Mindestens ein Tick, damit der Timer nicht im aktuellen Slot verloren geht
+    size_t ticks = std::max<size_t>(1, static_cast<size_t>((delay.count() + tick_.count() - 1) / tick_.count()));
+    size_t slot = (current_ + ticks) % slots_.size();
+    size_t rounds = (ticks - 1) / slots_.size();
+
+    uint64_t generation = nextGeneration_++;
+    generations_[key] = generation;
+    slots_[slot].push_back({ key, rounds, generation });
+}
+
+void TimerWheel::cancel(const std::string& key) {
+    generations_.erase(key);
+}
+
+std::vector<std::string> TimerWheel::advance() {
+    current_ = (current_ + 1) % slots_.size();
+
+    std::vector<std::string> due;
+    auto& slot = slots_[current_];
+    std::vector<Timer> remaining;
+
+    for (auto& timer : slot) {
+        auto it = generations_.find(timer.key);
+        if (it == generations_.end() || it->second != timer.generation) {
+            continue;   // Abgebrochen oder neu geplant
+        }
+        if (timer.rounds > 0) {
+            timer.rounds--;
+            remaining.push_back(std::move(timer));
+            continue;
+        }
+        generations_.erase(it);
+        due.push_back(std::move(timer.key));
+    }
+
+    slot = std::move(remaining);
+    return due;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+
+/// <summary>
+/// Einfaches Hashed Timing Wheel. Jeder Schlssel hat hchstens einen aktiven Timer;
+/// erneutes Planen ersetzt den alten Timer. Nicht threadsicher.
+/// </summary>
+class TimerWheel {
+public:
+    TimerWheel(size_t slotCount, std::chrono::milliseconds tick);
+
+    void schedule(const std::string& key, std::chrono::milliseconds delay);
+    void cancel(const std::string& key);
+
+    // Rckt um einen Tick vor und liefert die flligen Schlssel
+    std::vector<std::string> advance();
+
+    std::chrono::milliseconds tick() const { return tick_; }
+    size_t size() const { return generations_.size(); }
+
+private:
+    struct Timer {
+        std::string key;
+        size_t rounds;
+        uint64_t generation;
+    };
+
+    std::vector<std::vector<Timer>> slots_;
+    std::chrono::milliseconds tick_;
+    size_t current_ = 0;
+
+    // Aktuelle Generation je Schlssel; veraltete Timer werden beim Auslsen verworfen
+    std::unordered_map<std::string, uint64_t> generations_;
+    uint64_t nextGeneration_ = 1;
+};
@@ -0,0 +1,337 @@
+#include "TokenStore.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+namespace {
+    json tokenToJson(const TokenStore::TokenInfo& token) {
+        return {
+            {"access_token", token.access_token},
+            {"refresh_token", token.refresh_token},
+            {"expires_in", token.expires_in},
+            {"token_type", token.token_type},
+            {"timestamp_ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+                token.timestamp.time_since_epoch()).count()}
+        };
+    }
+
+    TokenStore::TokenInfo tokenFromJson(const json& j) {
+        TokenStore::TokenInfo token;
+        token.access_token = j["access_token"];
+        token.refresh_token = j["refresh_token"];
+        token.expires_in = j["expires_in"];
+        token.token_type = j["token_type"];
+        token.timestamp = std::chrono::system_clock::time_point(
+            std::chrono::milliseconds(j["timestamp_ms"].get<int64_t>())
+        );
+        return token;
+    }
+}
+
+bool TokenStore::TokenInfo::isExpired(std::chrono::seconds buffer) const {
+    auto now = std::chrono::system_clock::now();
+    return (now - timestamp) >= std::chrono::seconds(expires_in) - buffer;
+}
+
+TokenStore::TokenStore()
+    : TokenStore(Options{}) {
+}
+
+TokenStore::TokenStore(const Options& options)
+    : options_(options), refreshLeadSeconds_(options.refreshLead.count()), wheel_(3600, std::chrono::seconds(1)) {
+    ticker_ = std::thread([this]() { tickLoop(); });
+    for (size_t i = 0; i < options_.refreshWorkers; i++) {
+        refreshThreads_.emplace_back([this]() { refreshLoop(); });
+    }
+}
+
+TokenStore::~TokenStore() {
+    {
+        std::lock_guard<std::mutex> lock(stopMutex_);
+        stopping_ = true;
+    }
+    {
+        // Sperre kurz halten, damit kein Refresh-Thread das Signal verpasst
+        std::lock_guard<std::mutex> lock(refreshQueueMutex_);
+    }
+    stopCv_.notify_all();
+    refreshQueueCv_.notify_all();
+
+    ticker_.join();
+    for (auto& thread : refreshThreads_) {
+        thread.join();
+    }
+
+    flush();
+}
+
+void TokenStore::setRefresher(Refresher refresher) {
+    std::lock_guard<std::mutex> lock(refresherMutex_);
+    refresher_ = std::move(refresher);
+}
+
+bool TokenStore::load() {
+    std::string filename = options_.filename;
+    bool migrate = false;
+    if (!std::filesystem::exists(filename) && std::filesystem::exists(options_.legacyFilename)) {
+        filename = options_.legacyFilename;
+        migrate = true;
+    }
+
+    try {
+        std::ifstream file(filename);
+        if (!file.is_open()) return false;
+
+        json j;
+        file >> j;
+
+        if (migrate) {
+            // Alte Einzelkonto-Datei wird zum Standardkonto
+            put(kDefaultAccount, tokenFromJson(j));
+        }
+        else {
+            for (const auto& [account, token] : j["accounts"].items()) {
+                put(account, tokenFromJson(token));
+            }
+        }
+
+        // Gerade gelesene Daten mssen nur nach einer Migration neu geschrieben werden
+        dirty_ = migrate;
+        return size() > 0;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading tokens: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool TokenStore::flush() {
+    if (!dirty_) return true;
+    return persist();
+}
+
+std::optional<TokenStore::TokenInfo> TokenStore::get(const std::string& account) const {
+    auto& shard = shardFor(account);
+    std::shared_lock<std::shared_mutex> lock(shard.mutex);
+    auto it = shard.tokens.find(account);
+    if (it == shard.tokens.end()) return std::nullopt;
+    return it->second;
+}
+
+void TokenStore::put(const std::string& account, const TokenInfo& token) {
+    {
+        auto& shard = shardFor(account);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.tokens[account] = token;
+    }
+    scheduleRefresh(account, token);
+    dirty_ = true;
+}
+
+void TokenStore::remove(const std::string& account) {
+    {
+        auto& shard = shardFor(account);
+        std::unique_lock<std::shared_mutex> lock(shard.mutex);
+        shard.tokens.erase(account);
+    }
+    {
+        std::lock_guard<std::mutex> lock(wheelMutex_);
+        wheel_.cancel(account);
+    }
+    dirty_ = true;
+}
+
+std::vector<std::string> TokenStore::accounts() const {
+    std::vector<std::string> result;
+    for (auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        for (const auto& [account, token] : shard.tokens) {
+            result.push_back(account);
+        }
+    }
+    return result;
+}
+
+size_t TokenStore::size() const {
+    size_t count = 0;
+    for (auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> lock(shard.mutex);
+        count += shard.tokens.size();
+    }
+    return count;
+}
+
+bool TokenStore::refreshNow(const std::string& account) {
+    // Luft fr das Konto schon ein Refresh (Worker oder anderer Aufrufer), auf dessen Ergebnis
+    // warten: Ein zweiter Refresh wrde den Refresh-Token erneut einlsen, den Spotify beim
+    // ersten womglich schon ersetzt hat
+    std::promise<bool> promise;
+    std::shared_future<bool> running;
+    {
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        auto it = inFlight_.find(account);
+        if (it != inFlight_.end()) {
+            running = it->second;
+        }
+        else {
+            inFlight_.emplace(account, promise.get_future().share());
+        }
+    }
+    if (running.valid()) return running.get();
+
+    auto finish = [&]() {
+        std::lock_guard<std::mutex> lock(inFlightMutex_);
+        inFlight_.erase(account);
+    };
+    try {
+        bool refreshed = refreshAccount(account);
+        finish();
+        promise.set_value(refreshed);
+        return refreshed;
+    }
+    catch (...) {
+        finish();
+        promise.set_exception(std::current_exception());
+        throw;
+    }
+}
+
+bool TokenStore::refreshAccount(const std::string& account) {
+    auto current = get(account);
+    if (!current) return false;
+
+    Refresher refresher;
+    {
+        std::lock_guard<std::mutex> lock(refresherMutex_);
+        refresher = refresher_;
+    }
+    if (!refresher) return false;
+
+    auto refreshed = refresher(account, *current);
+    if (!refreshed) {
+        std::cerr << "Token-Refresh fr Konto '" << account << "' fehlgeschlagen, neuer Versuch in "
+            << options_.retryDelay.count() << " s." << std::endl;
+        std::lock_guard<std::mutex> lock(wheelMutex_);
+        wheel_.schedule(account, options_.retryDelay);
+        return false;
+    }
+
+    // Spotify liefert beim Refresh nicht immer einen neuen Refresh-Token
+    if (refreshed->refresh_token.empty()) {
+        refreshed->refresh_token = current->refresh_token;
+    }
+    put(account, *refreshed);
+    return true;
+}
+
+TokenStore::Shard& TokenStore::shardFor(const std::string& account) const {
+    return shards_[std::hash<std::string>{}(account) % kShardCount];
+}
+
+void TokenStore::scheduleRefresh(const std::string& account, const TokenInfo& token) {
+    if (token.refresh_token.empty()) return;
+
+    // Erneuern, kurz bevor expires_in abluft
+    auto refreshAt = token.timestamp + std::chrono::seconds(token.expires_in) - refreshLead();
+    auto delay = std::chrono::duration_cast<std::chrono::milliseconds>(refreshAt - std::chrono::system_clock::now());
+    if (delay.count() < 0) delay = std::chrono::milliseconds(0);
+
+    std::lock_guard<std::mutex> lock(wheelMutex_);
+    wheel_.schedule(account, delay);
+}
+
+void TokenStore::tickLoop() {
+    const auto tick = wheel_.tick();
+    auto nextTick = std::chrono::steady_clock::now() + tick;
+
+    std::unique_lock<std::mutex> lock(stopMutex_);
+    while (!stopping_) {
+        stopCv_.wait_until(lock, nextTick);
+        if (stopping_) break;
+
+        // Nach der Uhr vorrcken statt einmal pro Aufwachen: frhes Aufwachen zhlt nicht,
+        // verpasste Ticks (lange Refreshs, Suspend) werden nachgeholt
+        auto now = std::chrono::steady_clock::now();
+        if (now < nextTick) continue;
+        size_t ticks = 1 + static_cast<size_t>((now - nextTick) / tick);
+        nextTick += ticks * tick;
+        lock.unlock();
+
+        std::vector<std::string> due;
+        {
+            std::lock_guard<std::mutex> wheelLock(wheelMutex_);
+            for (size_t i = 0; i < ticks; i++) {
+                auto fired = wheel_.advance();
+                due.insert(due.end(), fired.begin(), fired.end());
+            }
+        }
+
+        if (!due.empty()) {
+            std::lock_guard<std::mutex> queueLock(refreshQueueMutex_);
+            refreshQueue_.insert(refreshQueue_.end(), due.begin(), due.end());
+            refreshQueueCv_.notify_all();
+        }
+
+        // nderungen hchstens einmal pro Tick schreiben
+        if (dirty_) {
+            persist();
+        }
+
+        lock.lock();
+    }
+}
+
+void TokenStore::refreshLoop() {
+    while (true) {
+        std::string account;
+        {
+            std::unique_lock<std::mutex> lock(refreshQueueMutex_);
+            refreshQueueCv_.wait(lock, [this]() { return stopping_ || !refreshQueue_.empty(); });
+            if (stopping_) return;
+
+            account = refreshQueue_.front();
+            refreshQueue_.pop_front();
+        }
+        refreshNow(account);
+    }
+}
+
+bool TokenStore::persist() {
+    std::lock_guard<std::mutex> lock(persistMutex_);
+    dirty_ = false;
+
+    json j;
+    j["accounts"] = json::object();
+    for (auto& shard : shards_) {
+        std::shared_lock<std::shared_mutex> shardLock(shard.mutex);
+        for (const auto& [account, token] : shard.tokens) {
+            j["accounts"][account] = tokenToJson(token);
+        }
+    }
+
+    // Erst vollstndig in eine temporre Datei schreiben, dann atomar ersetzen
+    std::string tempName = options_.filename + ".tmp";
+    try {
+        {
+            std::ofstream file(tempName, std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open " + tempName);
+            }
+            file << j.dump(4);
+            file.flush();
+            if (!file) {
+                throw std::runtime_error("Could not write " + tempName);
+            }
+        }
+        std::filesystem::rename(tempName, options_.filename);
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error saving tokens: " << e.what() << std::endl;
+        dirty_ = true;
+        return false;
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <deque>
+#include <array>
+#include <unordered_map>
+#include <optional>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <condition_variable>
+#include <thread>
+#include <future>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include "TimerWheel.h"
+
+/// <summary>
+/// Token-Speicher fr beliebig viele Spotify-Konten. Die Tokens liegen in einer
+/// geshardeten Map, werden kurz vor Ablauf ber ein Timing Wheel im Hintergrund
+/// erneuert und gebndelt per Write-then-Rename gespeichert.
+/// </summary>
+class TokenStore {
+public:
+    struct TokenInfo {
+        std::string access_token;
+        std::string refresh_token;
+        int64_t expires_in = 0;
+        std::string token_type;
+        std::chrono::system_clock::time_point timestamp;
+        // Gilt schon so lange vor dem eigentlichen Ablauf als abgelaufen
+        bool isExpired(std::chrono::seconds buffer = std::chrono::seconds(300)) const;
+    };
+
+    // Erneuert einen Token; std::nullopt bei Fehlern
+    using Refresher = std::function<std::optional<TokenInfo>(const std::string& account, const TokenInfo& current)>;
+
+    struct Options {
+        std::string filename = "spotify_tokens.json";
+        std::string legacyFilename = "spotify_token.json";   // Einzelkonto-Datei frherer Versionen
+        std::chrono::seconds refreshLead{ 300 };              // So lange vor Ablauf erneuern
+        std::chrono::seconds retryDelay{ 30 };                // Nach fehlgeschlagenem Refresh
+        size_t refreshWorkers = 2;
+    };
+
+    static constexpr const char* kDefaultAccount = "default";
+
+    TokenStore();
+    explicit TokenStore(const Options& options);
+    ~TokenStore();
+
+    TokenStore(const TokenStore&) = delete;
+    TokenStore& operator=(const TokenStore&) = delete;
+
+    void setRefresher(Refresher refresher);
+
+    // Vorlauf fr geplante Refreshes; gilt fr alle danach geplanten Tokens
+    void setRefreshLead(std::chrono::seconds lead) { refreshLeadSeconds_ = lead.count(); }
+    std::chrono::seconds refreshLead() const { return std::chrono::seconds(refreshLeadSeconds_.load()); }
+
+    // Ldt alle Konten aus der Datei (bzw. migriert die alte Einzelkonto-Datei)
+    bool load();
+    // Schreibt ausstehende nderungen sofort
+    bool flush();
+
+    std::optional<TokenInfo> get(const std::string& account) const;
+    void put(const std::string& account, const TokenInfo& token);
+    void remove(const std::string& account);
+    std::vector<std::string> accounts() const;
+    size_t size() const;
+
+    // Synchroner Refresh, z.B. wenn ein Token trotz Zeitplan abgelaufen ist. Luft fr das
+    // Konto schon einer, wartet der Aufruf auf dessen Ergebnis.
+    bool refreshNow(const std::string& account);
+
+private:
+    static constexpr size_t kShardCount = 16;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string, TokenInfo> tokens;
+    };
+
+    Shard& shardFor(const std::string& account) const;
+    void scheduleRefresh(const std::string& account, const TokenInfo& token);
+    void tickLoop();
+    void refreshLoop();
+    bool refreshAccount(const std::string& account);
+    bool persist();
+
+    Options options_;
+    std::atomic<int64_t> refreshLeadSeconds_;
+    mutable std::array<Shard, kShardCount> shards_;
+
+    std::mutex refresherMutex_;
+    Refresher refresher_;
+
+    std::mutex wheelMutex_;
+    TimerWheel wheel_;
+
+    std::mutex inFlightMutex_;
+    std::unordered_map<std::string, std::shared_future<bool>> inFlight_;   // Laufende Refreshes pro Konto
+
+    std::mutex refreshQueueMutex_;
+    std::condition_variable refreshQueueCv_;
+    std::deque<std::string> refreshQueue_;
+
+    std::mutex persistMutex_;
+    std::atomic<bool> dirty_{ false };
+
+    std::mutex stopMutex_;
+    std::condition_variable stopCv_;
+    std::atomic<bool> stopping_{ false };
+
+    std::thread ticker_;
+    std::vector<std::thread> refreshThreads_;
+};
@@ -0,0 +1,245 @@
+#include "TrackCache.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+#include <cctype>
+#include <nlohmann/json.hpp>
+
+using json = nlohmann::json;
+
+TrackCache::TrackCache()
+    : TrackCache(Options{}) {
+}
+
+TrackCache::TrackCache(const Options& options)
+    : options_(options) {
+}
+
+std::string TrackCache::makeKey(const std::string& trackName, const std::string& artist) {
+    // Gro-/Kleinschreibung spielt fr die Spotify-Suche keine Rolle
+    std::string key = trackName + "|" + artist;
+    std::transform(key.begin(), key.end(), key.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return key;
+}
+
+std::optional<std::string> TrackCache::get(const std::string& key) {
+    std::shared_ptr<SharedTrackCache> shared;
+    std::chrono::hours ttl;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = index_.find(key);
+        if (it != index_.end() && expired(*it->second)) {
+            lru_.erase(it->second);
+            index_.erase(it);
+            dirty_ = true;
+            it = index_.end();
+        }
+
+        if (it != index_.end()) {
+            lru_.splice(lru_.begin(), lru_, it->second);
+            hits_++;
+            return it->second->trackId;
+        }
+        shared = shared_;
+        ttl = options_.ttl;
+    }
+
+    // Vielleicht hat ein anderer Prozess den Song schon gesucht
+    if (shared) {
+        if (auto hit = shared->get(key, ttl)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            insertLocked({ key, hit->trackId, hit->stored });
+            dirty_ = true;
+            hits_++;
+            sharedHits_++;
+            return hit->trackId;
+        }
+    }
+
+    misses_++;
+    return std::nullopt;
+}
+
+void TrackCache::put(const std::string& key, const std::string& trackId) {
+    auto now = std::chrono::system_clock::now();
+    std::shared_ptr<SharedTrackCache> shared;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        insertLocked({ key, trackId, now });
+        dirty_ = true;
+        shared = shared_;
+    }
+    if (shared) shared->put(key, trackId, now);
+}
+
+void TrackCache::attachShared(std::shared_ptr<SharedTrackCache> shared) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (shared && !shared_) {
+        // Bekannte Eintrge teilen, damit neue Prozesse sofort davon profitieren
+        for (auto it = lru_.rbegin(); it != lru_.rend(); ++it) {
+            if (!expired(*it)) shared->put(it->key, it->trackId, it->stored);
+        }
+    }
+    shared_ = std::move(shared);
+}
+
+std::shared_ptr<SharedTrackCache> TrackCache::shared() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shared_;
+}
+
+bool TrackCache::load() {
+    try {
+        std::ifstream file(options_.filename);
+        if (!file.is_open()) return false;
+
+        json j;
+        file >> j;
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Die Datei ist nach Aktualitt sortiert; rckwrts einfgen, damit die Reihenfolge erhalten bleibt
+        const auto& entries = j["entries"];
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            Entry entry;
+            entry.key = (*it)["key"];
+            entry.trackId = (*it)["track_id"];
+            entry.stored = std::chrono::system_clock::time_point(
+                std::chrono::milliseconds((*it)["stored_ms"].get<int64_t>()));
+            // Eintrge, die seit dem Start schon neu gesucht (oder aus einem Bundle bernommen)
+            // wurden, bleiben, wenn sie aktueller sind
+            if (!expired(entry)) {
+                insertIfNewerLocked(std::move(entry));
+            }
+        }
+        // dirty_ bleibt gesetzt: Eintrge von vor dem Laden fehlen noch in der Datei
+
+        std::cout << "Track-Cache geladen: " << index_.size() << " Eintrge" << std::endl;
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error loading track cache: " << e.what() << std::endl;
+        return false;
+    }
+}
+
+bool TrackCache::save() {
+    // Ein Speichervorgang zur Zeit: Die temporre Datei ist fr alle gleich, und ein
+    // spterer Stand darf nicht von einem frheren berschrieben werden
+    std::lock_guard<std::mutex> saveLock(saveMutex_);
+    json j;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dirty_) return true;
+
+        j["entries"] = json::array();
+        for (const auto& entry : lru_) {
+            j["entries"].push_back({
+                {"key", entry.key},
+                {"track_id", entry.trackId},
+                {"stored_ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+                    entry.stored.time_since_epoch()).count()}
+                });
+        }
+        dirty_ = false;
+    }
+
+    // Erst vollstndig in eine temporre Datei schreiben, dann atomar ersetzen
+    std::string tempName = options_.filename + ".tmp";
+    try {
+        {
+            std::ofstream file(tempName, std::ios::trunc);
+            if (!file.is_open()) {
+                throw std::runtime_error("Could not open " + tempName);
+            }
+            file << j.dump();
+            if (!file) {
+                throw std::runtime_error("Could not write " + tempName);
+            }
+        }
+        std::filesystem::rename(tempName, options_.filename);
+        return true;
+    }
+    catch (const std::exception& e) {
+        std::cerr << "Error saving track cache: " << e.what() << std::endl;
+        std::lock_guard<std::mutex> lock(mutex_);
+        dirty_ = true;
+        return false;
+    }
+}
+
+void TrackCache::setLimits(size_t capacity, std::chrono::hours ttl) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_.capacity = capacity;
+    options_.ttl = ttl;
+    while (index_.size() > options_.capacity && !lru_.empty()) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
+
+std::vector<TrackCache::Entry> TrackCache::entries() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<Entry> result;
+    result.reserve(lru_.size());
+    for (const auto& entry : lru_) {
+        if (!expired(entry)) result.push_back(entry);
+    }
+    return result;
+}
+
+size_t TrackCache::merge(const std::vector<Entry>& entries) {
+    std::vector<const Entry*> inserted;
+    std::shared_ptr<SharedTrackCache> shared;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+            if (!expired(*it) && insertIfNewerLocked(*it)) {
+                inserted.push_back(&*it);
+            }
+        }
+        if (!inserted.empty()) dirty_ = true;
+        shared = shared_;
+    }
+
+    // Auch die anderen Prozesse des Rechners sollen davon profitieren
+    if (shared) {
+        for (const Entry* entry : inserted) {
+            shared->put(entry->key, entry->trackId, entry->stored);
+        }
+    }
+    return inserted.size();
+}
+
+size_t TrackCache::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return index_.size();
+}
+
+void TrackCache::insertLocked(Entry entry) {
+    auto it = index_.find(entry.key);
+    if (it != index_.end()) {
+        lru_.erase(it->second);
+        index_.erase(it);
+    }
+
+    lru_.push_front(std::move(entry));
+    index_[lru_.front().key] = lru_.begin();
+
+    while (index_.size() > options_.capacity && !lru_.empty()) {
+        index_.erase(lru_.back().key);
+        lru_.pop_back();
+    }
+}
+
+bool TrackCache::insertIfNewerLocked(Entry entry) {
+    auto it = index_.find(entry.key);
+    if (it != index_.end() && it->second->stored >= entry.stored) return false;
+    insertLocked(std::move(entry));
+    return true;
+}
+
+bool TrackCache::expired(const Entry& entry) const {
+    return std::chrono::system_clock::now() - entry.stored > options_.ttl;
+}
@@ -0,0 +1,82 @@
+#pragma once
+#include <string>
+#include <list>
+#include <vector>
+#include <unordered_map>
+#include <optional>
+#include <mutex>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include "SharedTrackCache.h"
+
+/// <summary>
+/// Zwischenspeicher fr Track-Suchen ("Titel|Knstler" -> Spotify-Track-ID) mit LRU-Verdrngung
+/// und Ablaufzeit. Wird beim Start von der Platte geladen, damit wiederholte Importe die
+/// Suche nicht erneut bezahlen. Threadsicher. Mit einem SharedTrackCache dahinter sehen
+/// auch die anderen Import-Prozesse des Rechners jedes Suchergebnis.
+/// </summary>
+class TrackCache {
+public:
+    struct Options {
+        std::string filename = "track_cache.json";
+        size_t capacity = 50000;
+        std::chrono::hours ttl{ 24 * 30 };
+    };
+
+    struct Entry {
+        std::string key;
+        std::string trackId;
+        std::chrono::system_clock::time_point stored;
+    };
+
+    TrackCache();
+    explicit TrackCache(const Options& options);
+
+    TrackCache(const TrackCache&) = delete;
+    TrackCache& operator=(const TrackCache&) = delete;
+
+    static std::string makeKey(const std::string& trackName, const std::string& artist);
+
+    std::optional<std::string> get(const std::string& key);
+    void put(const std::string& key, const std::string& trackId);
+
+    // Neue Grenzen zur Laufzeit; berzhlige Eintrge werden sofort verdrngt
+    void setLimits(size_t capacity, std::chrono::hours ttl);
+
+    // Prozessbergreifende zweite Ebene; nullptr trennt sie wieder
+    void attachShared(std::shared_ptr<SharedTrackCache> shared);
+    std::shared_ptr<SharedTrackCache> shared() const;
+
+    bool load();
+    // Schreibt nur, wenn sich seit dem letzten Speichern etwas gendert hat
+    bool save();
+
+    // Alle gltigen Eintrge, zuletzt verwendete zuerst (z.B. fr ein CacheBundle)
+    std::vector<Entry> entries() const;
+    // bernimmt Eintrge in derselben Reihenfolge; bei bekannten Schlsseln gewinnt der neuere.
+    // Liefert die Anzahl bernommener Eintrge.
+    size_t merge(const std::vector<Entry>& entries);
+
+    size_t size() const;
+    uint64_t hits() const { return hits_; }
+    uint64_t misses() const { return misses_; }
+    uint64_t sharedHits() const { return sharedHits_; }
+
+private:
+    void insertLocked(Entry entry);
+    bool insertIfNewerLocked(Entry entry);
+    bool expired(const Entry& entry) const;
+
+    Options options_;
+    mutable std::mutex mutex_;
+    std::mutex saveMutex_;     // Hlt save() von Schreiben bis rename()
+    std::list<Entry> lru_;      // Vorne: zuletzt verwendet
+    std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+    bool dirty_ = false;
+    std::shared_ptr<SharedTrackCache> shared_;
+
+    std::atomic<uint64_t> hits_{ 0 };
+    std::atomic<uint64_t> misses_{ 0 };
+    std::atomic<uint64_t> sharedHits_{ 0 };
+};
@@ -1,33 +1,144 @@
-// Windows-Plattform definieren
-#ifdef _WIN64
-#define _AMD64_      
-#elif defined(_WIN32)
-#define _X86_       
-#endif
+#include <imgui.h>
+#include "Executor.h"
+#include "UIRenderer.h"
+#include "AppState.h"  
+#include "ImportJournal.h"
+#include <type_traits>
+#include <cstring>
+#include <cstdio>
+#include <mutex>
+#include <functional>
+#include <iostream>
 
-#ifndef WIN32_LEAN_AND_MEAN
-#define WIN32_LEAN_AND_MEAN
-#endif
+namespace {
+    /// <summary>
+    /// Fhrt die Importe der UI nacheinander aus. Ein Import, der einen laufenden ersetzt,
+    /// ffnet womglich dasselbe Journal; er startet deshalb erst, wenn der abgebrochene
+    /// Vorgnger fertig ist. Wartet schon ein Nachfolger, wird er durch den neuen ersetzt.
+    /// </summary>
+    class ImportSequence {
+    public:
+        static ImportSequence& instance() {
+            static ImportSequence sequence;
+            return sequence;
+        }
 
-#ifndef NOMINMAX
-#define NOMINMAX
-#endif
+        void start(std::function<void()> import) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (running_) {
+                    next_ = std::move(import);
+                    return;
+                }
+                running_ = true;
+            }
+            post(std::move(import));
+        }
 
-#include <windows.h>
-#include <WinUser.h>
+    private:
+        void post(std::function<void()> import) {
+            Executor::instance().post([this, import = std::move(import)]() {
+                try {
+                    import();
+                }
+                catch (const std::exception& e) {
+                    // Auch dann muss der Nachfolger starten
+                    std::cerr << "Import fehlgeschlagen: " << e.what() << std::endl;
+                }
 
-#include <imgui.h>
-#include <thread>
-#include "UIRenderer.h"
-#include "AppState.h"  
+                std::function<void()> next;
+                {
+                    std::lock_guard<std::mutex> lock(mutex_);
+                    next = std::move(next_);
+                    next_ = nullptr;
+                    running_ = static_cast<bool>(next);
+                }
+                if (next) post(std::move(next));
+                });
+        }
 
+        std::mutex mutex_;
+        bool running_ = false;
+        std::function<void()> next_;
+    };
+}
 
+/// <summary>
+/// Baut die Anzeigezeilen der Songliste einmal auf, statt sie in jedem Frame neu zu formatieren.
+/// </summary>
+/// <param name="state"></param>
+void UIRenderer::BuildSongDisplayLines(AppState& state) {
+    state.songDisplayLines.clear();
+    state.songDisplayLines.reserve(state.currentSetlist->songs.size());
+
+    for (size_t i = 0; i < state.currentSetlist->songs.size(); i++)
+    {
+        const auto& song = state.currentSetlist->songs[i];
+        std::string songDisplay = std::to_string(i + 1) + ". " + song.name;
+        if (song.isCover && !song.coverArtist.empty()) {
+            songDisplay += " (Cover von " + song.coverArtist + ")";
+        }
+        state.songDisplayLines.push_back(std::move(songDisplay));
+    }
+}
+
+/// <summary>
+/// bernimmt die Ergebnisse der Hintergrundaufgaben in den AppState.
+/// </summary>
+/// <param name="state"></param>
+void UIRenderer::ApplyEvents(AppState& state) {
+    state.uiEvents.drain([&state](UiEvent&& event) {
+        std::visit([&state](auto&& payload) {
+            using T = std::decay_t<decltype(payload)>;
+
+            if constexpr (std::is_same_v<T, UiEvent::StatusChanged>) {
+                state.statusMessage = std::move(payload.message);
+            }
+            else if constexpr (std::is_same_v<T, UiEvent::SetlistLoaded>) {
+                state.currentSetlist = std::move(payload.setlist);
+                BuildSongDisplayLines(state);
+                state.hasSetlist = true;
+                state.isLoading = false;
+                state.statusMessage = "Setlist geladen: " + state.currentSetlist->artist + " @ " +
+                    state.currentSetlist->venue;
+
+                // Standardname fr Playlist vorschlagen
+                snprintf(state.playlistName, IM_ARRAYSIZE(state.playlistName),
+                    "%s @ %s (%s)",
+                    state.currentSetlist->artist.c_str(),
+                    state.currentSetlist->venue.c_str(),
+                    state.currentSetlist->eventDate.c_str());
+            }
+            else if constexpr (std::is_same_v<T, UiEvent::SetlistLoadFailed>) {
+                state.statusMessage = std::move(payload.message);
+                state.isLoading = false;
+            }
+            else if constexpr (std::is_same_v<T, UiEvent::ImportStatusChanged>) {
+                if (payload.generation != state.importGeneration) return;   // Von einem ersetzten Import
+                state.playlistCreationStatus = std::move(payload.message);
+            }
+            else if constexpr (std::is_same_v<T, UiEvent::ImportProgressed>) {
+                if (payload.generation != state.importGeneration) return;
+                state.importSongsProcessed = payload.processed;
+            }
+            else if constexpr (std::is_same_v<T, UiEvent::ImportFinished>) {
+                if (payload.generation != state.importGeneration) return;
+                state.playlistCreationStatus = std::move(payload.message);
+                state.playlistCreated = true;
+                state.createPlaylist = false;
+            }
+            }, event.payload);
+        });
+}
 
 /// <summary>
 /// Rendert die Benutzeroberflche der Anwendung.
 /// </summary>
 /// <param name="state"></param>
 void UIRenderer::RenderMainUI(AppState& state) {
+    // Ergebnisse der Hintergrundaufgaben bernehmen, bevor gezeichnet wird
+    ApplyEvents(state);
+
     // Hauptfenster erstellen
     ImGui::SetNextWindowPos(ImVec2(0, 0));
     ImGui::SetNextWindowSize(ImGui::GetIO().DisplaySize);
@@ -42,8 +153,8 @@ void UIRenderer::RenderMainUI(AppState& state) {
         {
             if (ImGui::MenuItem("Beenden", "Alt+F4"))
             {
-                // Anwendung beenden
-                PostQuitMessage(0);
+                // Anwendung beenden; die Hauptschleife reicht das an Windows weiter
+                state.quitRequested = true;
             }
             ImGui::EndMenu();
         }
@@ -93,27 +204,25 @@ void UIRenderer::RenderMainUI(AppState& state) {
         // Setlist-ID abrufen
         std::string setlistId = state.setlistIdInput;
 
-        // In einem separaten Thread laden, um UI nicht zu blockieren
-        std::thread([&state, setlistId]() {
+        // Ein Import der bisherigen Setlist wird nicht mehr gebraucht und soll kein Budget mehr verbrauchen
+        if (state.createPlaylist && state.currentSetlist && state.currentSetlist->id != setlistId) {
+            state.importCancel.cancel();
+        }
+
+        // Im Thread-Pool laden, um UI nicht zu blockieren
+        // Das Ergebnis wird im nchsten Frame von ApplyEvents bernommen
+        Executor::instance().post([&state, setlistId]() {
+            // Der Benutzer wartet: Vorrang vor Hintergrundarbeit
+            HttpClient::PriorityScope priority(HttpClient::Priority::Interactive);
             auto setlist = state.setlistService->getSetlist(setlistId);
             if (setlist) {
-                state.currentSetlist = *setlist;
-                state.hasSetlist = true;
-                state.statusMessage = "Setlist geladen: " + state.currentSetlist.artist + " @ " +
-                    state.currentSetlist.venue;
-
-                // Standardname fr Playlist vorschlagen
-                snprintf(state.playlistName, IM_ARRAYSIZE(state.playlistName),
-                    "%s @ %s (%s)",
-                    state.currentSetlist.artist.c_str(),
-                    state.currentSetlist.venue.c_str(),
-                    state.currentSetlist.eventDate.c_str());
+                state.uiEvents.push({ UiEvent::SetlistLoaded{
+                    std::make_shared<const SetlistFmService::Setlist>(std::move(*setlist)) } });
             }
             else {
-                state.statusMessage = "Fehler beim Laden der Setlist";
+                state.uiEvents.push({ UiEvent::SetlistLoadFailed{ "Fehler beim Laden der Setlist" } });
             }
-            state.isLoading = false;
-            }).detach();
+            });
     }
     if (loadDisabled) ImGui::EndDisabled();
 
@@ -129,27 +238,45 @@ void UIRenderer::RenderMainUI(AppState& state) {
         // Setlist-Informationen
         ImGui::TextColored(ImVec4(0.8f, 0.8f, 0.2f, 1.0f),
             "Setlist: %s @ %s, %s, %s",
-            state.currentSetlist.artist.c_str(),
-            state.currentSetlist.venue.c_str(),
-            state.currentSetlist.city.c_str(),
-            state.currentSetlist.country.c_str());
-        ImGui::Text("Datum: %s", state.currentSetlist.eventDate.c_str());
-        ImGui::Text("Anzahl Songs: %zu", state.currentSetlist.songs.size());
+            state.currentSetlist->artist.c_str(),
+            state.currentSetlist->venue.c_str(),
+            state.currentSetlist->city.c_str(),
+            state.currentSetlist->country.c_str());
+        ImGui::Text("Datum: %s", state.currentSetlist->eventDate.c_str());
+        ImGui::Text("Anzahl Songs: %zu", state.currentSetlist->songs.size());
 
         // Zwei Spalten: Songs und Playlist-Erstellung
         ImGui::Columns(2);
 
         // Songs-Liste
         ImGui::Text("Songs in der Setlist:");
-        ImGui::BeginChild("SongsList", ImVec2(0, ImGui::GetContentRegionAvail().y), true);
-        for (size_t i = 0; i < state.currentSetlist.songs.size(); i++)
+        ImGui::BeginChild("SongsList", ImVec2(0, ImGui::GetContentRegionAvail().y), true,
+            ImGuiWindowFlags_HorizontalScrollbar);
+
+        // Nur die sichtbaren Zeilen zeichnen; bei Tour- und Festivallisten mit tausenden Songs
+        // bleibt die Frame-Zeit so konstant. Der Clipper braucht gleich hohe Zeilen, daher
+        // ohne Umbruch und mit horizontalem Scrollen.
+        if (state.virtualizeSongList)
         {
-            const auto& song = state.currentSetlist.songs[i];
-            std::string songDisplay = std::to_string(i + 1) + ". " + song.name;
-            if (song.isCover && !song.coverArtist.empty()) {
-                songDisplay += " (Cover von " + song.coverArtist + ")";
+            ImGuiListClipper clipper;
+            clipper.Begin(static_cast<int>(state.songDisplayLines.size()));
+            while (clipper.Step())
+            {
+                for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++)
+                {
+                    const std::string& line = state.songDisplayLines[i];
+                    ImGui::TextUnformatted(line.c_str(), line.c_str() + line.size());
+                }
+            }
+            clipper.End();
+        }
+        else
+        {
+            // Vergleichspfad fr --bench-ui: jede Zeile wird gezeichnet
+            for (const std::string& line : state.songDisplayLines)
+            {
+                ImGui::TextUnformatted(line.c_str(), line.c_str() + line.size());
             }
-            ImGui::TextWrapped("%s", songDisplay.c_str());
         }
         ImGui::EndChild();
 
@@ -166,42 +293,83 @@ void UIRenderer::RenderMainUI(AppState& state) {
             state.createPlaylist = true;
             state.playlistCreated = false;
             state.playlistCreationStatus = "Erstelle Playlist...";
+            state.importSongsProcessed = 0;
+            state.importSongCount = state.currentSetlist->songs.size();
 
-            // Songs in das gewnschte Format umwandeln
-            std::vector<std::pair<std::string, std::string>> songList;
-            for (const auto& song : state.currentSetlist.songs) {
-                // Fr Covers den Original-Knstler verwenden
-                std::string artistToUse = song.isCover ? song.coverArtist : "";
-                songList.push_back({ song.name, artistToUse });
-            }
+            // Ein noch laufender Import wird durch den neuen ersetzt; seine restlichen Ereignisse
+            // tragen die alte Generation und werden verworfen
+            state.importCancel.cancel();
+            state.importCancel = CancellationToken::create();
+            CancellationToken cancel = state.importCancel;
+            uint64_t generation = ++state.importGeneration;
 
-            // In einem separaten Thread importieren
-            std::thread([&state, songList]() {
-                bool success = state.spotifyService->importSetlistToSpotify(
-                    state.playlistName,
-                    state.currentSetlist.artist,
-                    songList
-                );
+            // Gleiche Setlist und gleicher Name: ein abgebrochener Import wird fortgesetzt
+            std::string jobId = ImportJournal::makeJobId(state.currentSetlist->id, state.playlistName,
+                TokenStore::kDefaultAccount);
 
-                if (success) {
-                    state.playlistCreationStatus = "Playlist erfolgreich erstellt!";
+            // Namen kopieren, da die UI ihn whrend des Imports ndern kann; die Setlist selbst
+            // ist unvernderlich und wird nur geteilt, auch wenn inzwischen eine neue geladen wird
+            std::string playlistName = state.playlistName;
+            SetlistFmService::SetlistSnapshot setlist = state.currentSetlist;
+
+            // Im Thread-Pool importieren, erst nach dem Ende des abgebrochenen Vorgngers
+            ImportSequence::instance().start([&state, setlist, jobId, playlistName, cancel, generation]() {
+                HttpClient::PriorityScope priority(HttpClient::Priority::Interactive);
+                ImportJournal journal(jobId);
+                if (!journal.bindVersion(setlist->versionId)) {
+                    // Die Song-Indizes des alten Laufs passen nicht mehr zur bearbeiteten Setlist
+                    state.uiEvents.push({ UiEvent::ImportStatusChanged{ generation, "Setlist wurde gendert, Import beginnt neu..." } });
+                }
+                else if (journal.state().completed) {
+                    // Erneuter Klick nach erfolgreichem Import: neue Playlist anlegen
+                    journal.reset();
                 }
-                else {
-                    state.playlistCreationStatus = "Fehler beim Erstellen der Playlist";
+                else if (journal.hasProgress()) {
+                    state.uiEvents.push({ UiEvent::ImportStatusChanged{ generation, "Setze abgebrochenen Import fort..." } });
                 }
 
-                state.playlistCreated = true;
-                state.createPlaylist = false;
-                }).detach();
+                bool success = state.spotifyService->importSetlistToSpotify(
+                    playlistName,
+                    setlist->artist,
+                    setlist->songs,
+                    &journal,
+                    [&state, generation](const ImportEvent& event) {
+                        if (event.type == ImportEvent::Type::SongResolved ||
+                            event.type == ImportEvent::Type::SongNotFound) {
+                            state.uiEvents.push({ UiEvent::ImportProgressed{ generation, event.songIndex + 1 } });
+                        }
+                    },
+                    cancel
+                );
+
+                std::string message = success ? "Playlist erfolgreich erstellt!" :
+                    cancel.cancelled() ? "Import abgebrochen" : "Fehler beim Erstellen der Playlist";
+                state.uiEvents.push({ UiEvent::ImportFinished{ generation, success, std::move(message) } });
+                });
         }
 
         // Status der Playlist-Erstellung
         if (state.createPlaylist) {
             ImGui::TextColored(ImVec4(1.0f, 0.8f, 0.0f, 1.0f), "Status: %s", state.playlistCreationStatus.c_str());
 
-            // Fortschrittsbalken (knnte in Zukunft mit echtem Fortschritt aktualisiert werden)
-            float progress = -1.0f;  // Unbestimmter Fortschrittsbalken
-            ImGui::ProgressBar(progress, ImVec2(-1, 0));
+            // Fortschrittsbalken: bearbeitete Songs laut ImportEvents
+            size_t total = state.importSongCount;
+            size_t processed = state.importSongsProcessed;
+            if (total > 0) {
+                char overlay[64];
+                snprintf(overlay, sizeof(overlay), "%zu / %zu Songs", processed, total);
+                ImGui::ProgressBar(static_cast<float>(processed) / total, ImVec2(-1, 0), overlay);
+            }
+            else {
+                ImGui::ProgressBar(-1.0f, ImVec2(-1, 0));
+            }
+
+            bool cancelling = state.importCancel.cancelled();
+            if (cancelling) ImGui::BeginDisabled();
+            if (ImGui::Button(cancelling ? "Wird abgebrochen..." : "Import abbrechen", ImVec2(-1, 0)) && !cancelling) {
+                state.importCancel.cancel();
+            }
+            if (cancelling) ImGui::EndDisabled();
         }
         else if (state.playlistCreated) {
             ImGui::TextColored(
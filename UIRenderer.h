@@ -7,4 +7,10 @@
 class UIRenderer {
 public:
     static void RenderMainUI(AppState& state);
+
+private:
+    // Wendet die Ereignisse der Hintergrundaufgaben auf den AppState an (einmal pro Frame)
+    static void ApplyEvents(AppState& state);
+    // Baut die Anzeigezeilen der Songliste neu (nach dem Laden einer Setlist)
+    static void BuildSongDisplayLines(AppState& state);
 };
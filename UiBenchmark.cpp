@@ -0,0 +1,159 @@
+#include "UiBenchmark.h"
+#include "UIRenderer.h"
+#include "AppState.h"
+#include <imgui.h>
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <memory>
+
+namespace {
+    SetlistFmService::SetlistSnapshot makeSetlist(size_t songCount) {
+        auto setlist = std::make_shared<SetlistFmService::Setlist>();
+        setlist->id = "benchmark";
+        setlist->artist = "Benchmark Band";
+        setlist->venue = "Festivalgelnde";
+        setlist->city = "Berlin";
+        setlist->country = "Deutschland";
+        setlist->eventDate = "01-07-2025";
+        setlist->songs.reserve(songCount);
+        for (size_t i = 0; i < songCount; i++) {
+            SetlistFmService::Song song;
+            song.name = "Song Nummer " + std::to_string(i + 1);
+            song.artist = setlist->artist;
+            // Jeder zehnte Song ein Cover, damit die Zeilen unterschiedlich lang sind
+            if (i % 10 == 0) {
+                song.isCover = true;
+                song.coverArtist = "Originalknstler " + std::to_string(i / 10);
+            }
+            setlist->songs.push_back(std::move(song));
+        }
+        return setlist;
+    }
+
+    // Texturwnsche des Frames erfllen, ohne Pixel hochzuladen (nicht Teil der Messung)
+    void acknowledgeTextures() {
+#if IMGUI_VERSION_NUM >= 19200
+        for (ImTextureData* texture : ImGui::GetPlatformIO().Textures) {
+            if (texture->Status == ImTextureStatus_WantCreate || texture->Status == ImTextureStatus_WantUpdates) {
+                texture->SetTexID(static_cast<ImTextureID>(texture->UniqueID));
+                texture->SetStatus(ImTextureStatus_OK);
+            }
+            else if (texture->Status == ImTextureStatus_WantDestroy) {
+                texture->SetTexID(ImTextureID_Invalid);
+                texture->SetStatus(ImTextureStatus_Destroyed);
+            }
+        }
+#endif
+    }
+
+    double percentile(const std::vector<double>& sorted, double p) {
+        if (sorted.empty()) return 0.0;
+        size_t index = static_cast<size_t>(p * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+}
+
+UiBenchmark::Result UiBenchmark::run(const Options& options, bool virtualized) {
+    IMGUI_CHECKVERSION();
+    ImGuiContext* context = ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = nullptr;
+    io.DisplaySize = ImVec2(options.width, options.height);
+    io.DeltaTime = 1.0f / 60.0f;
+
+    // Ohne Renderer-Backend bernimmt der Benchmark dessen Rolle beim Font-Atlas, wie das
+    // Null-Backend aus den ImGui-Beispielen (example_null). Ab 1.92 verwaltet ImGui die Texturen
+    // selbst und verlangt, dass jemand ihre Anforderungen besttigt; davor reicht der fertige Atlas.
+#if IMGUI_VERSION_NUM >= 19200
+    io.BackendFlags |= ImGuiBackendFlags_RendererHasTextures;
+#else
+    unsigned char* pixels = nullptr;
+    int atlasWidth = 0;
+    int atlasHeight = 0;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &atlasWidth, &atlasHeight);
+#endif
+
+    // Die Setlist kommt wie im Betrieb als Ereignis an und wird im ersten Frame bernommen
+    auto state = std::make_unique<AppState>();
+    state->virtualizeSongList = virtualized;
+    state->uiEvents.push({ UiEvent::SetlistLoaded{ makeSetlist(options.songs) } });
+
+    std::vector<double> frameMs;
+    frameMs.reserve(options.frames);
+    for (size_t frame = 0; frame < options.warmupFrames + options.frames; frame++) {
+        auto start = std::chrono::steady_clock::now();
+        ImGui::NewFrame();
+        UIRenderer::RenderMainUI(*state);
+        ImGui::Render();
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        acknowledgeTextures();
+
+        if (frame >= options.warmupFrames) {
+            frameMs.push_back(std::chrono::duration<double, std::milli>(elapsed).count());
+        }
+    }
+    ImGui::DestroyContext(context);
+
+    Result result;
+    result.name = virtualized ? "virtualisiert" : "alle Zeilen";
+    result.frames = frameMs.size();
+    if (!frameMs.empty()) {
+        double sum = 0.0;
+        for (double ms : frameMs) sum += ms;
+        result.meanMs = sum / frameMs.size();
+        std::sort(frameMs.begin(), frameMs.end());
+        result.p50Ms = percentile(frameMs, 0.50);
+        result.p95Ms = percentile(frameMs, 0.95);
+        result.p99Ms = percentile(frameMs, 0.99);
+        result.maxMs = frameMs.back();
+    }
+    return result;
+}
+
+void UiBenchmark::printResults(const std::vector<Result>& results, std::ostream& out) {
+    out << std::left << std::setw(16) << "Songliste" << std::right
+        << std::setw(8) << "Frames" << std::setw(10) << "Mittel" << std::setw(10) << "p50"
+        << std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "Max" << "  (ms)\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& result : results) {
+        out << std::left << std::setw(16) << result.name << std::right
+            << std::setw(8) << result.frames << std::setw(10) << result.meanMs << std::setw(10) << result.p50Ms
+            << std::setw(10) << result.p95Ms << std::setw(10) << result.p99Ms << std::setw(10) << result.maxMs << "\n";
+    }
+    if (results.size() == 2 && results[0].meanMs > 0.0) {
+        out << std::setprecision(1) << "Faktor (Mittel): " << results[1].meanMs / results[0].meanMs << "x\n";
+    }
+    out << std::defaultfloat;
+}
+
+bool UiBenchmark::isBenchmarkInvocation(int argc, char** argv) {
+    return argc > 1 && std::string(argv[1]) == "--bench-ui";
+}
+
+int UiBenchmark::runCommandLine(int argc, char** argv) {
+    Options options;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        std::string key = argv[i];
+        std::string value = argv[i + 1];
+        try {
+            if (key == "--songs") options.songs = std::stoul(value);
+            else if (key == "--frames") options.frames = std::stoul(value);
+            else {
+                std::cerr << "Unbekannter Schalter: " << key << std::endl;
+                return 1;
+            }
+        }
+        catch (const std::exception&) {
+            std::cerr << "Ungltiger Wert fr " << key << ": " << value << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << "UI-Benchmark: " << options.songs << " Songs, " << options.frames << " Frames, "
+        << options.width << "x" << options.height << ", ohne Renderer-Backend" << std::endl;
+    std::vector<Result> results{ run(options, true), run(options, false) };
+    printResults(results, std::cout);
+    return 0;
+}
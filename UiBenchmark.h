@@ -0,0 +1,39 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <ostream>
+
+/// <summary>
+/// Misst die Frame-Zeit der Oberflche ohne Fenster und Renderer-Backend: ImGui::NewFrame,
+/// UIRenderer::RenderMainUI und ImGui::Render auf einer synthetischen Setlist, einmal mit
+/// virtualisierter Songliste (ImGuiListClipper) und einmal mit allen Zeilen. Gemessen wird
+/// nur die CPU-Seite, also der Anteil, den die Virtualisierung einspart.
+/// </summary>
+class UiBenchmark {
+public:
+    struct Options {
+        size_t songs = 10000;
+        size_t frames = 600;
+        size_t warmupFrames = 30;       // Nicht gemessen (Font-Atlas, erste Layouts)
+        float width = 1280.0f;
+        float height = 800.0f;
+    };
+
+    struct Result {
+        std::string name;
+        size_t frames = 0;
+        double meanMs = 0.0;
+        double p50Ms = 0.0;
+        double p95Ms = 0.0;
+        double p99Ms = 0.0;
+        double maxMs = 0.0;
+    };
+
+    static Result run(const Options& options, bool virtualized);
+    static void printResults(const std::vector<Result>& results, std::ostream& out);
+
+    // Kommandozeile: --bench-ui [--songs N] [--frames N]
+    static bool isBenchmarkInvocation(int argc, char** argv);
+    static int runCommandLine(int argc, char** argv);
+};
@@ -0,0 +1,47 @@
+#pragma once
+#include <string>
+#include <variant>
+#include <cstdint>
+#include "SetlistFmService.h"
+
+/// <summary>
+/// Ergebnis einer Hintergrundaufgabe fr die UI. Worker-Threads schreiben nicht mehr
+/// direkt in den AppState, sondern stellen diese Ereignisse in AppState::uiEvents ein;
+/// der UI-Thread wendet sie einmal pro Frame an.
+/// </summary>
+struct UiEvent {
+    struct StatusChanged {
+        std::string message;
+    };
+
+    struct SetlistLoaded {
+        SetlistFmService::SetlistSnapshot setlist;
+    };
+
+    struct SetlistLoadFailed {
+        std::string message;
+    };
+
+    // Import-Ereignisse tragen die Generation ihres Imports (AppState::importGeneration),
+    // damit die eines ersetzten Imports den neuen nicht berschreiben
+    struct ImportStatusChanged {
+        uint64_t generation = 0;
+        std::string message;
+    };
+
+    struct ImportProgressed {
+        uint64_t generation = 0;
+        size_t processed = 0;
+    };
+
+    struct ImportFinished {
+        uint64_t generation = 0;
+        bool success = false;
+        std::string message;
+    };
+
+    using Payload = std::variant<StatusChanged, SetlistLoaded, SetlistLoadFailed,
+        ImportStatusChanged, ImportProgressed, ImportFinished>;
+
+    Payload payload;
+};